@@ -74,10 +74,10 @@ Trajectory PlayGame(
 
   while (true) {
     open_spiel::Player player = state->CurrentPlayer();
-    std::unique_ptr<SearchNode> root = (*bots)[player]->MCTSearch(*state);
+    const SearchNode* root = (*bots)[player]->MCTSearch(*state);
     open_spiel::ActionsAndProbs policy;
-    policy.reserve(root->children.size());
-    for (const SearchNode& c : root->children) {
+    policy.reserve(root->num_children);
+    for (const SearchNode& c : root->children()) {
       policy.emplace_back(
           c.action, std::pow(c.explore_count, 1.0 / temperature));
     }
@@ -14,11 +14,14 @@
 
 #include "open_spiel/algorithms/alpha_zero/vpevaluator.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <memory>
+#include <vector>
 
 #include "open_spiel/abseil-cpp/absl/hash/hash.h"
 #include "open_spiel/abseil-cpp/absl/time/time.h"
+#include "open_spiel/abseil-cpp/absl/types/span.h"
 #include "open_spiel/utils/stats.h"
 
 namespace open_spiel {
@@ -77,6 +80,55 @@ open_spiel::ActionsAndProbs VPNetEvaluator::Prior(const State& state) {
   return Inference(state).policy;
 }
 
+std::vector<Evaluator::Evaluation> VPNetEvaluator::EvaluateBatch(
+    absl::Span<const State* const> states) {
+  std::vector<VPNetModel::InferenceOutputs> outputs(states.size());
+  std::vector<uint64_t> keys(states.size());
+  std::vector<VPNetModel::InferenceInputs> inputs;
+  std::vector<int> missing;  // The states that were not in the cache.
+  for (int i = 0; i < states.size(); ++i) {
+    VPNetModel::InferenceInputs input = {
+      states[i]->LegalActions(), states[i]->ObservationTensor()};
+    if (!cache_.empty()) {
+      keys[i] = absl::Hash<VPNetModel::InferenceInputs>{}(input);
+      std::optional<const VPNetModel::InferenceOutputs> opt_outputs =
+          cache_[keys[i] % cache_.size()]->Get(keys[i]);
+      if (opt_outputs) {
+        outputs[i] = *opt_outputs;
+        continue;
+      }
+    }
+    inputs.push_back(std::move(input));
+    missing.push_back(i);
+  }
+
+  if (!inputs.empty()) {
+    {
+      absl::MutexLock lock(&stats_m_);
+      batch_size_stats_.Add(inputs.size());
+      batch_size_hist_.Add(std::min<int>(inputs.size(), batch_size_));
+    }
+    std::vector<VPNetModel::InferenceOutputs> results =
+        device_manager_.Get(inputs.size())->Inference(inputs);
+    for (int j = 0; j < missing.size(); ++j) {
+      const int i = missing[j];
+      outputs[i] = std::move(results[j]);
+      if (!cache_.empty()) {
+        cache_[keys[i] % cache_.size()]->Set(keys[i], outputs[i]);
+      }
+    }
+  }
+
+  // TODO(author5): currently assumes zero-sum.
+  std::vector<Evaluation> evaluations;
+  evaluations.reserve(states.size());
+  for (VPNetModel::InferenceOutputs& output : outputs) {
+    evaluations.push_back({{output.value, -output.value},
+                           std::move(output.policy)});
+  }
+  return evaluations;
+}
+
 VPNetModel::InferenceOutputs VPNetEvaluator::Inference(const State& state) {
   VPNetModel::InferenceInputs inputs = {
     state.LegalActions(), state.ObservationTensor()};
@@ -43,6 +43,11 @@ class VPNetEvaluator : public Evaluator {
   // Return a policy: the probability of the current player playing each action.
   ActionsAndProbs Prior(const State& state) override;
 
+  // Runs one inference for all the states that are not in the cache, without
+  // going through the batching queue.
+  std::vector<Evaluation> EvaluateBatch(
+      absl::Span<const State* const> states) override;
+
   void ClearCache();
   LRUCacheInfo CacheInfo();
 
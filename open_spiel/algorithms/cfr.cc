@@ -21,6 +21,37 @@
 
 namespace open_spiel {
 namespace algorithms {
+namespace {
+
+// A parallel traversal aims for at least this many tasks per thread, as the
+// subtrees may differ in size.
+constexpr int kTasksPerThread = 4;
+
+// Fills the policy in proportion to the positive regrets, or uniformly when
+// there are none. The loops have no branches in their bodies, so that the
+// compiler can vectorize the second one; the sum stays in action order, as
+// the results must not depend on how the tree is walked.
+void RegretMatching(absl::Span<const double> cumulative_regrets,
+                    absl::Span<double> policy) {
+  const int num_actions = cumulative_regrets.size();
+  const double* regrets = cumulative_regrets.data();
+  double* probs = policy.data();
+  double sum_positive_regrets = 0.0;
+  for (int aidx = 0; aidx < num_actions; ++aidx) {
+    sum_positive_regrets += regrets[aidx] > 0 ? regrets[aidx] : 0.0;
+  }
+
+  if (sum_positive_regrets > 0) {
+    for (int aidx = 0; aidx < num_actions; ++aidx) {
+      probs[aidx] =
+          regrets[aidx] > 0 ? regrets[aidx] / sum_positive_regrets : 0.0;
+    }
+  } else {
+    std::fill(probs, probs + num_actions, 1.0 / num_actions);
+  }
+}
+
+}  // namespace
 
 CFRAveragePolicy::CFRAveragePolicy(const CFRInfoStateValuesTable& info_states,
                                    std::shared_ptr<Policy> default_policy)
@@ -122,13 +153,17 @@ ActionsAndProbs CFRCurrentPolicy::GetStatePolicyFromInformationStateValues(
 }
 
 CFRSolverBase::CFRSolverBase(const Game& game, bool alternating_updates,
-                             bool linear_averaging, bool regret_matching_plus)
+                             bool linear_averaging, bool regret_matching_plus,
+                             bool precompiled, bool compiled_tree,
+                             int num_threads)
     : game_(game),
       root_state_(game.NewInitialState()),
       root_reach_probs_(game_.NumPlayers() + 1, 1.0),
       regret_matching_plus_(regret_matching_plus),
       alternating_updates_(alternating_updates),
       linear_averaging_(linear_averaging),
+      precompiled_(precompiled || compiled_tree),
+      compiled_tree_(compiled_tree),
       chance_player_(game.NumPlayers()) {
   if (game_.GetType().dynamics != GameType::Dynamics::kSequential) {
     SpielFatalError(
@@ -136,17 +171,47 @@ CFRSolverBase::CFRSolverBase(const Game& game, bool alternating_updates,
         "on a simultaneous (or normal-form) game, please first transform it "
         "using turn_based_simultaneous_game.");
   }
+  if (num_threads > 1) SPIEL_CHECK_TRUE(compiled_tree_);
 
-  InitializeInfostateNodes(*root_state_);
+  std::unordered_map<std::string, int> indices;
+  if (compiled_tree_) {
+    tree_.nodes.resize(1);
+    tree_.chance_probs.resize(1, 1.0);
+  }
+  InitializeInfostateNodes(*root_state_, &indices, compiled_tree_ ? 0 : -1);
+  if (precompiled_) InitializeInfoStateArrays(indices);
+  if (compiled_tree_) FinishCompiledTree(num_threads);
+  if (split_depth_ > 0) {
+    pool_ = std::make_unique<ThreadPool>(num_threads - 1);
+  }
 }
 
-void CFRSolverBase::InitializeInfostateNodes(const State& state) {
+void CFRSolverBase::InitializeInfostateNodes(
+    const State& state, std::unordered_map<std::string, int>* indices,
+    int tree_node) {
+  using NodeType = CompiledTree::NodeType;
   if (state.IsTerminal()) {
+    if (tree_node >= 0) {
+      AddTreeChildren(tree_node, NodeType::kTerminal, kTerminalPlayerId,
+                      tree_.utilities.size(), 0);
+      std::vector<double> returns = state.Returns();
+      tree_.utilities.insert(tree_.utilities.end(), returns.begin(),
+                             returns.end());
+    }
     return;
   }
   if (state.IsChanceNode()) {
-    for (const auto& action_prob : state.ChanceOutcomes()) {
-      InitializeInfostateNodes(*state.Child(action_prob.first));
+    ActionsAndProbs outcomes = state.ChanceOutcomes();
+    int child = -1;
+    if (tree_node >= 0) {
+      child = AddTreeChildren(tree_node, NodeType::kChance, chance_player_,
+                              -1, outcomes.size());
+    }
+    for (const auto& action_prob : outcomes) {
+      if (tree_node >= 0) tree_.chance_probs[child] = action_prob.second;
+      InitializeInfostateNodes(*state.Child(action_prob.first), indices,
+                               child);
+      if (tree_node >= 0) ++child;
     }
     return;
   }
@@ -155,11 +220,118 @@ void CFRSolverBase::InitializeInfostateNodes(const State& state) {
   std::string info_state = state.InformationStateString(current_player);
   std::vector<Action> legal_actions = state.LegalActions();
 
+  int node = -1;
+  if (precompiled_) {
+    auto [it, inserted] = indices->insert({info_state, indices->size()});
+    node = node_info_states_.size();
+    node_info_states_.push_back(it->second);
+    node_subtree_sizes_.push_back(0);
+  }
+
   CFRInfoStateValues is_vals(legal_actions);
   info_states_[info_state] = is_vals;
 
+  int child = -1;
+  if (tree_node >= 0) {
+    child = AddTreeChildren(tree_node, NodeType::kDecision, current_player,
+                            node_info_states_[node], legal_actions.size());
+  }
   for (const Action& action : legal_actions) {
-    InitializeInfostateNodes(*state.Child(action));
+    InitializeInfostateNodes(*state.Child(action), indices, child);
+    if (tree_node >= 0) ++child;
+  }
+
+  if (precompiled_) {
+    node_subtree_sizes_[node] = node_info_states_.size() - node;
+  }
+}
+
+int CFRSolverBase::AddTreeChildren(int tree_node, CompiledTree::NodeType type,
+                                   int player, int index, int num_children) {
+  // The nodes may move when they grow, so they are only held by index.
+  const int first_child = tree_.nodes.size();
+  tree_.nodes[tree_node] = {type, player, index, first_child, num_children};
+  tree_.nodes.resize(first_child + num_children);
+  tree_.chance_probs.resize(first_child + num_children, 1.0);
+  return first_child;
+}
+
+void CFRSolverBase::FinishCompiledTree(int num_threads) {
+  // Parents come before their children.
+  std::vector<int> depths(tree_.nodes.size(), 0);
+  std::vector<int> depth_sizes;  // Nodes with children per depth.
+  for (int i = 0; i < tree_.nodes.size(); ++i) {
+    const CompiledTree::Node& node = tree_.nodes[i];
+    tree_.max_depth = std::max(tree_.max_depth, depths[i]);
+    tree_.max_children = std::max(tree_.max_children, node.num_children);
+    for (int c = 0; c < node.num_children; ++c) {
+      depths[node.first_child + c] = depths[i] + 1;
+    }
+    if (node.num_children > 0) {
+      if (depths[i] >= depth_sizes.size()) depth_sizes.resize(depths[i] + 1);
+      ++depth_sizes[depths[i]];
+    }
+  }
+  // Trees too small to split are walked serially.
+  if (num_threads > 1) {
+    for (int depth = 1; depth < depth_sizes.size(); ++depth) {
+      if (depth_sizes[depth] >= kTasksPerThread * num_threads) {
+        split_depth_ = depth;
+        break;
+      }
+    }
+  }
+  const int num_players = game_.NumPlayers();
+  scratch_stride_ = (num_players + 1) + num_players + tree_.max_children;
+  scratch_.resize((tree_.max_depth + 1) * scratch_stride_);
+  override_policies_.resize(info_state_arrays_.cumulative_policy.size());
+  override_calls_.resize(info_state_arrays_.values.size(), 0);
+}
+
+void CFRSolverBase::InitializeInfoStateArrays(
+    const std::unordered_map<std::string, int>& indices) {
+  std::vector<std::pair<const std::string*, CFRInfoStateValues*>> entries(
+      indices.size());
+  for (const auto& [key, index] : indices) {
+    auto it = info_states_.find(key);
+    entries[index] = {&it->first, &it->second};
+  }
+  InfoStateArrays& arrays = info_state_arrays_;
+  arrays.offsets.push_back(0);
+  for (const auto& [key, values] : entries) {
+    arrays.keys.push_back(key);
+    arrays.values.push_back(values);
+    arrays.legal_actions.insert(arrays.legal_actions.end(),
+                                values->legal_actions.begin(),
+                                values->legal_actions.end());
+    arrays.cumulative_regrets.insert(arrays.cumulative_regrets.end(),
+                                     values->cumulative_regrets.begin(),
+                                     values->cumulative_regrets.end());
+    arrays.cumulative_policy.insert(arrays.cumulative_policy.end(),
+                                    values->cumulative_policy.begin(),
+                                    values->cumulative_policy.end());
+    arrays.current_policy.insert(arrays.current_policy.end(),
+                                 values->current_policy.begin(),
+                                 values->current_policy.end());
+    arrays.offsets.push_back(arrays.legal_actions.size());
+  }
+}
+
+void CFRSolverBase::CopyInfoStateArraysToTable() {
+  const InfoStateArrays& arrays = info_state_arrays_;
+  for (int i = 0; i < arrays.values.size(); ++i) {
+    CFRInfoStateValues& values = *arrays.values[i];
+    const int begin = arrays.offsets[i];
+    const int end = arrays.offsets[i + 1];
+    std::copy(arrays.cumulative_regrets.begin() + begin,
+              arrays.cumulative_regrets.begin() + end,
+              values.cumulative_regrets.begin());
+    std::copy(arrays.cumulative_policy.begin() + begin,
+              arrays.cumulative_policy.begin() + end,
+              values.cumulative_policy.begin());
+    std::copy(arrays.current_policy.begin() + begin,
+              arrays.current_policy.begin() + end,
+              values.current_policy.begin());
   }
 }
 
@@ -185,7 +357,7 @@ void CFRSolverBase::EvaluateAndUpdatePolicy() {
 }
 
 static double CounterFactualReachProb(
-    const std::vector<double>& reach_probabilities, const int player) {
+    absl::Span<const double> reach_probabilities, const int player) {
   double cfr_reach_prob = 1.0;
   for (int i = 0; i < reach_probabilities.size(); i++) {
     if (i != player) {
@@ -195,6 +367,38 @@ static double CounterFactualReachProb(
   return cfr_reach_prob;
 }
 
+std::vector<double> CFRSolverBase::ComputeCounterFactualRegret(
+    const State& state, const std::optional<int>& alternating_player,
+    const std::vector<double>& reach_probabilities,
+    const std::vector<const Policy*>* policy_overrides) {
+  if (!precompiled_) {
+    return ComputeCounterFactualRegret(state, alternating_player,
+                                       reach_probabilities, policy_overrides,
+                                       /*node=*/nullptr);
+  }
+  // The decision nodes are numbered from the root.
+  SPIEL_CHECK_EQ(state.History(), root_state_->History());
+  if (compiled_tree_) {
+    SPIEL_CHECK_EQ(reach_probabilities.size(), game_.NumPlayers() + 1);
+    ++override_call_;
+    std::vector<double> values(game_.NumPlayers());
+    if (pool_ != nullptr && policy_overrides == nullptr) {
+      ComputeParallelTreeRegret(reach_probabilities.data(), alternating_player,
+                                values.data());
+    } else {
+      TreeWalk walk{WalkPhase::kSerial, scratch_.data()};
+      ComputeCompiledTreeRegret(/*tree_node=*/0, /*depth=*/0,
+                                reach_probabilities.data(), alternating_player,
+                                policy_overrides, values.data(), &walk);
+    }
+    return values;
+  }
+  int node = 0;
+  return ComputeCounterFactualRegret(state, alternating_player,
+                                     reach_probabilities, policy_overrides,
+                                     &node);
+}
+
 // Compute counterfactual regrets. Alternates recursively with
 // ComputeCounterFactualRegretForActionProbs.
 //
@@ -203,13 +407,14 @@ static double CounterFactualReachProb(
 // - alternating_player: Optionally only update this player.
 // - reach_probabilities: The reach probabilities of this state for each
 //      player, ending with the chance player.
+// - node: In precompiled mode, the index of the state's first decision node.
 //
 // Returns:
 //   The value of the state for each player (excluding the chance player).
 std::vector<double> CFRSolverBase::ComputeCounterFactualRegret(
     const State& state, const std::optional<int>& alternating_player,
     const std::vector<double>& reach_probabilities,
-    const std::vector<const Policy*>* policy_overrides) {
+    const std::vector<const Policy*>* policy_overrides, int* node) {
   if (state.IsTerminal()) {
     return state.Returns();
   }
@@ -223,27 +428,59 @@ std::vector<double> CFRSolverBase::ComputeCounterFactualRegret(
     }
     return ComputeCounterFactualRegretForActionProbs(
         state, alternating_player, reach_probabilities, chance_player_, dist,
-        outcomes, nullptr, policy_overrides);
+        outcomes, nullptr, policy_overrides, node);
   }
   if (AllPlayersHaveZeroReachProb(reach_probabilities)) {
     // The value returned is not used: if the reach probability for all players
     // is 0, then the last taken action has probability 0, so the
     // returned value is not impacting the parent node value.
+    if (node != nullptr) *node += node_subtree_sizes_[*node];
     return std::vector<double>(game_.NumPlayers(), 0.0);
   }
 
   int current_player = state.CurrentPlayer();
-  std::string info_state = state.InformationStateString();
-  std::vector<Action> legal_actions = state.LegalActions(current_player);
+  std::string info_state;
+  std::vector<Action> legal_actions_vector;
+  absl::Span<const Action> legal_actions;
+  absl::Span<double> cumulative_regrets;
+  absl::Span<double> cumulative_policy;
+  absl::Span<const double> current_policy;
+  if (node != nullptr) {
+    // The values are in the arrays, at the information state's index.
+    InfoStateArrays& arrays = info_state_arrays_;
+    const int index = node_info_states_[(*node)++];
+    const int begin = arrays.offsets[index];
+    const int num_actions = arrays.offsets[index + 1] - begin;
+    legal_actions = absl::MakeConstSpan(&arrays.legal_actions[begin],
+                                        num_actions);
+    cumulative_regrets =
+        absl::MakeSpan(&arrays.cumulative_regrets[begin], num_actions);
+    cumulative_policy =
+        absl::MakeSpan(&arrays.cumulative_policy[begin], num_actions);
+    current_policy =
+        absl::MakeConstSpan(&arrays.current_policy[begin], num_actions);
+    if (policy_overrides && policy_overrides->at(current_player)) {
+      info_state = *arrays.keys[index];
+    }
+  } else {
+    info_state = state.InformationStateString();
+    legal_actions_vector = state.LegalActions(current_player);
+    legal_actions = legal_actions_vector;
+    CFRInfoStateValues& is_vals = info_states_[info_state];
+    if (is_vals.empty()) is_vals = CFRInfoStateValues(legal_actions_vector);
+    cumulative_regrets = absl::MakeSpan(is_vals.cumulative_regrets);
+    cumulative_policy = absl::MakeSpan(is_vals.cumulative_policy);
+    current_policy = is_vals.current_policy;
+  }
 
   // Load current policy.
-  std::vector<double> info_state_policy;
+  std::vector<double> override_policy;
+  absl::Span<const double> info_state_policy = current_policy;
   if (policy_overrides && policy_overrides->at(current_player)) {
-    GetInfoStatePolicyFromPolicy(&info_state_policy, legal_actions,
+    GetInfoStatePolicyFromPolicy(&override_policy, legal_actions,
                                  policy_overrides->at(current_player),
                                  info_state);
-  } else {
-    info_state_policy = GetPolicy(info_state, legal_actions);
+    info_state_policy = override_policy;
   }
 
   std::vector<double> child_utilities;
@@ -251,13 +488,11 @@ std::vector<double> CFRSolverBase::ComputeCounterFactualRegret(
   const std::vector<double> state_value =
       ComputeCounterFactualRegretForActionProbs(
           state, alternating_player, reach_probabilities, current_player,
-          info_state_policy, legal_actions, &child_utilities, policy_overrides);
+          info_state_policy, legal_actions, &child_utilities, policy_overrides,
+          node);
 
   // Perform regret and average strategy updates.
   if (!alternating_player || *alternating_player == current_player) {
-    CFRInfoStateValues is_vals = info_states_[info_state];
-    SPIEL_CHECK_FALSE(is_vals.empty());
-
     const double self_reach_prob = reach_probabilities[current_player];
     const double cfr_reach_prob =
         CounterFactualReachProb(reach_probabilities, current_player);
@@ -267,27 +502,190 @@ std::vector<double> CFRSolverBase::ComputeCounterFactualRegret(
       double cfr_regret = cfr_reach_prob *
                           (child_utilities[aidx] - state_value[current_player]);
 
-      is_vals.cumulative_regrets[aidx] += cfr_regret;
+      cumulative_regrets[aidx] += cfr_regret;
 
       // Update average policy.
       if (linear_averaging_) {
-        is_vals.cumulative_policy[aidx] +=
+        cumulative_policy[aidx] +=
             iteration_ * self_reach_prob * info_state_policy[aidx];
       } else {
-        is_vals.cumulative_policy[aidx] +=
-            self_reach_prob * info_state_policy[aidx];
+        cumulative_policy[aidx] += self_reach_prob * info_state_policy[aidx];
       }
     }
-
-    info_states_[info_state] = is_vals;
   }
 
   return state_value;
 }
 
+// As ComputeCounterFactualRegret() and
+// ComputeCounterFactualRegretForActionProbs(), with the same floating-point
+// operations in the same order, so that the results are identical.
+void CFRSolverBase::ComputeCompiledTreeRegret(
+    int tree_node, int depth, const double* reach_probabilities,
+    const std::optional<int>& alternating_player,
+    const std::vector<const Policy*>* policy_overrides, double* values,
+    TreeWalk* walk) {
+  using NodeType = CompiledTree::NodeType;
+  const CompiledTree::Node& node = tree_.nodes[tree_node];
+  const int num_players = game_.NumPlayers();
+  if (node.type == NodeType::kTerminal) {
+    std::copy_n(&tree_.utilities[node.index], num_players, values);
+    return;
+  }
+  std::fill_n(values, num_players, 0.0);
+  if (depth == split_depth_ && walk->phase == WalkPhase::kCollect) {
+    if (num_tasks_ == tasks_.size()) {
+      tasks_.emplace_back();
+      tasks_.back().scratch.resize(scratch_.size());
+    }
+    TreeTask& task = tasks_[num_tasks_++];
+    task.tree_node = tree_node;
+    task.reach_probabilities.assign(reach_probabilities,
+                                    reach_probabilities + num_players + 1);
+    return;
+  }
+  if (depth == split_depth_ && walk->phase == WalkPhase::kCombine) {
+    const TreeTask& task = tasks_[walk->next_task++];
+    SPIEL_CHECK_EQ(task.tree_node, tree_node);
+    ApplyTreeUpdates(task);
+    absl::c_copy(task.values, values);
+    return;
+  }
+  const absl::Span<const double> reach =
+      absl::MakeConstSpan(reach_probabilities, num_players + 1);
+  const bool is_decision = node.type == NodeType::kDecision;
+  if (is_decision && AllPlayersHaveZeroReachProb(reach)) return;
+
+  // The node's policy: the current one, an override, or chance's.
+  const int current_player = node.player;
+  InfoStateArrays& arrays = info_state_arrays_;
+  const double* policy = nullptr;
+  int begin = 0;
+  if (is_decision) {
+    begin = arrays.offsets[node.index];
+    policy = &arrays.current_policy[begin];
+    if (policy_overrides && policy_overrides->at(current_player)) {
+      policy = OverridePolicy(node.index, policy_overrides->at(current_player))
+                   .data();
+    }
+  } else {
+    policy = &tree_.chance_probs[node.first_child];
+  }
+
+  double* child_reach = &walk->scratch[depth * scratch_stride_];
+  double* child_value = child_reach + num_players + 1;
+  double* child_utilities = child_value + num_players;
+  for (int aidx = 0; aidx < node.num_children; ++aidx) {
+    const double prob = policy[aidx];
+    std::copy_n(reach_probabilities, num_players + 1, child_reach);
+    child_reach[current_player] *= prob;
+    ComputeCompiledTreeRegret(node.first_child + aidx, depth + 1, child_reach,
+                              alternating_player, policy_overrides,
+                              child_value, walk);
+    for (int i = 0; i < num_players; ++i) {
+      values[i] += prob * child_value[i];
+    }
+    child_utilities[aidx] = child_value[current_player];
+  }
+
+  // Perform regret and average strategy updates, or in a task log them.
+  if (is_decision && walk->phase != WalkPhase::kCollect &&
+      (!alternating_player || *alternating_player == current_player)) {
+    const double self_reach_prob = reach[current_player];
+    const double cfr_reach_prob =
+        CounterFactualReachProb(reach, current_player);
+    double* cumulative_regrets = &arrays.cumulative_regrets[begin];
+    double* cumulative_policy = &arrays.cumulative_policy[begin];
+    if (walk->phase == WalkPhase::kTask) {
+      std::vector<double>& increments = walk->task->update_increments;
+      walk->task->update_info_states.push_back(node.index);
+      const int offset = increments.size();
+      increments.resize(offset + 2 * node.num_children);
+      cumulative_regrets = &increments[offset];
+      cumulative_policy = &increments[offset + node.num_children];
+    }
+    for (int aidx = 0; aidx < node.num_children; ++aidx) {
+      cumulative_regrets[aidx] +=
+          cfr_reach_prob * (child_utilities[aidx] - values[current_player]);
+      if (linear_averaging_) {
+        cumulative_policy[aidx] += iteration_ * self_reach_prob * policy[aidx];
+      } else {
+        cumulative_policy[aidx] += self_reach_prob * policy[aidx];
+      }
+    }
+  }
+}
+
+void CFRSolverBase::ComputeParallelTreeRegret(
+    const double* reach_probabilities,
+    const std::optional<int>& alternating_player, double* values) {
+  num_tasks_ = 0;
+  TreeWalk collect{WalkPhase::kCollect, scratch_.data()};
+  ComputeCompiledTreeRegret(/*tree_node=*/0, /*depth=*/0, reach_probabilities,
+                            alternating_player, /*policy_overrides=*/nullptr,
+                            values, &collect);
+
+  pool_->ParallelFor(num_tasks_, [&](int i) {
+    TreeTask& task = tasks_[i];
+    task.values.resize(game_.NumPlayers());
+    task.update_info_states.clear();
+    task.update_increments.clear();
+    TreeWalk walk{WalkPhase::kTask, task.scratch.data(), &task};
+    ComputeCompiledTreeRegret(task.tree_node, split_depth_,
+                              task.reach_probabilities.data(),
+                              alternating_player, /*policy_overrides=*/nullptr,
+                              task.values.data(), &walk);
+  });
+
+  // The same walk as the collection, which now finds the tasks in order.
+  TreeWalk combine{WalkPhase::kCombine, scratch_.data()};
+  ComputeCompiledTreeRegret(/*tree_node=*/0, /*depth=*/0, reach_probabilities,
+                            alternating_player, /*policy_overrides=*/nullptr,
+                            values, &combine);
+  SPIEL_CHECK_EQ(combine.next_task, num_tasks_);
+}
+
+void CFRSolverBase::ApplyTreeUpdates(const TreeTask& task) {
+  // Adding each increment on its own, rather than their sums, rounds as the
+  // serial traversal does.
+  InfoStateArrays& arrays = info_state_arrays_;
+  const double* increments = task.update_increments.data();
+  for (int index : task.update_info_states) {
+    const int begin = arrays.offsets[index];
+    const int num_actions = arrays.offsets[index + 1] - begin;
+    for (int aidx = 0; aidx < num_actions; ++aidx) {
+      arrays.cumulative_regrets[begin + aidx] += increments[aidx];
+    }
+    increments += num_actions;
+    for (int aidx = 0; aidx < num_actions; ++aidx) {
+      arrays.cumulative_policy[begin + aidx] += increments[aidx];
+    }
+    increments += num_actions;
+  }
+}
+
+absl::Span<const double> CFRSolverBase::OverridePolicy(int index,
+                                                       const Policy* policy) {
+  const InfoStateArrays& arrays = info_state_arrays_;
+  const int begin = arrays.offsets[index];
+  const int num_actions = arrays.offsets[index + 1] - begin;
+  absl::Span<double> override_policy =
+      absl::MakeSpan(&override_policies_[begin], num_actions);
+  if (override_calls_[index] != override_call_) {
+    override_calls_[index] = override_call_;
+    std::vector<double> info_state_policy;
+    GetInfoStatePolicyFromPolicy(
+        &info_state_policy,
+        absl::MakeConstSpan(&arrays.legal_actions[begin], num_actions), policy,
+        *arrays.keys[index]);
+    absl::c_copy(info_state_policy, override_policy.begin());
+  }
+  return override_policy;
+}
+
 void CFRSolverBase::GetInfoStatePolicyFromPolicy(
     std::vector<double>* info_state_policy,
-    const std::vector<Action>& legal_actions, const Policy* policy,
+    absl::Span<const Action> legal_actions, const Policy* policy,
     const std::string& info_state) const {
   ActionsAndProbs actions_and_probs = policy->GetStatePolicy(info_state);
   info_state_policy->reserve(legal_actions.size());
@@ -316,15 +714,16 @@ void CFRSolverBase::GetInfoStatePolicyFromPolicy(
 // - action_probs: The action probabilities to use frp this state.
 // - child_values_out: optional output parameter which is filled with the child
 //           utilities for each action, for current_player.
+// - node: In precompiled mode, the index of the state's first decision node.
 // Returns:
 //   The value of the state for each player (excluding the chance player).
 std::vector<double> CFRSolverBase::ComputeCounterFactualRegretForActionProbs(
     const State& state, const std::optional<int>& alternating_player,
     const std::vector<double>& reach_probabilities, const int current_player,
-    const std::vector<double>& info_state_policy,
-    const std::vector<Action>& legal_actions,
+    absl::Span<const double> info_state_policy,
+    absl::Span<const Action> legal_actions,
     std::vector<double>* child_values_out,
-    const std::vector<const Policy*>* policy_overrides) {
+    const std::vector<const Policy*>* policy_overrides, int* node) {
   std::vector<double> state_value(game_.NumPlayers());
 
   for (int aidx = 0; aidx < legal_actions.size(); ++aidx) {
@@ -335,7 +734,8 @@ std::vector<double> CFRSolverBase::ComputeCounterFactualRegretForActionProbs(
     new_reach_probabilities[current_player] *= prob;
     std::vector<double> child_value =
         ComputeCounterFactualRegret(*new_state, alternating_player,
-                                    new_reach_probabilities, policy_overrides);
+                                    new_reach_probabilities, policy_overrides,
+                                    node);
     for (int i = 0; i < state_value.size(); ++i) {
       state_value[i] += prob * child_value[i];
     }
@@ -347,7 +747,7 @@ std::vector<double> CFRSolverBase::ComputeCounterFactualRegretForActionProbs(
 }
 
 bool CFRSolverBase::AllPlayersHaveZeroReachProb(
-    const std::vector<double>& reach_probabilities) const {
+    absl::Span<const double> reach_probabilities) const {
   for (int i = 0; i < game_.NumPlayers(); i++) {
     if (reach_probabilities[i] != 0.0) {
       return false;
@@ -356,20 +756,6 @@ bool CFRSolverBase::AllPlayersHaveZeroReachProb(
   return true;
 }
 
-std::vector<double> CFRSolverBase::GetPolicy(
-    const std::string& info_state, const std::vector<Action>& legal_actions) {
-  auto entry = info_states_.find(info_state);
-  if (entry == info_states_.end()) {
-    info_states_[info_state] = CFRInfoStateValues(legal_actions);
-    entry = info_states_.find(info_state);
-  }
-
-  SPIEL_CHECK_FALSE(entry == info_states_.end());
-  SPIEL_CHECK_FALSE(entry->second.empty());
-  SPIEL_CHECK_FALSE(entry->second.current_policy.empty());
-  return entry->second.current_policy;
-}
-
 std::string CFRInfoStateValues::ToString() const {
   std::string str = "";
   absl::StrAppend(&str, "Legal actions: ", absl::StrJoin(legal_actions, ", "),
@@ -385,23 +771,7 @@ std::string CFRInfoStateValues::ToString() const {
 }
 
 void CFRInfoStateValues::ApplyRegretMatching() {
-  double sum_positive_regrets = 0.0;
-  for (int aidx = 0; aidx < num_actions(); ++aidx) {
-    if (cumulative_regrets[aidx] > 0) {
-      sum_positive_regrets += cumulative_regrets[aidx];
-    }
-  }
-
-  for (int aidx = 0; aidx < num_actions(); ++aidx) {
-    if (sum_positive_regrets > 0) {
-      current_policy[aidx] =
-          cumulative_regrets[aidx] > 0
-              ? cumulative_regrets[aidx] / sum_positive_regrets
-              : 0;
-    } else {
-      current_policy[aidx] = 1.0 / legal_actions.size();
-    }
-  }
+  RegretMatching(cumulative_regrets, absl::MakeSpan(current_policy));
 }
 
 int CFRInfoStateValues::SampleActionIndex(double epsilon, double z) {
@@ -426,6 +796,12 @@ int CFRInfoStateValues::SampleActionIndex(double epsilon, double z) {
 //  done during the tree traversal (which is done on histories). It is thus
 //  performed as an additional step.
 void CFRSolverBase::ApplyRegretMatchingPlusReset() {
+  if (precompiled_) {
+    for (double& regret : info_state_arrays_.cumulative_regrets) {
+      if (regret < 0) regret = 0;
+    }
+    return;
+  }
   for (auto& entry : info_states_) {
     for (int aidx = 0; aidx < entry.second.num_actions(); ++aidx) {
       if (entry.second.cumulative_regrets[aidx] < 0) {
@@ -436,6 +812,18 @@ void CFRSolverBase::ApplyRegretMatchingPlusReset() {
 }
 
 void CFRSolverBase::ApplyRegretMatching() {
+  if (precompiled_) {
+    InfoStateArrays& arrays = info_state_arrays_;
+    for (int i = 0; i + 1 < arrays.offsets.size(); ++i) {
+      const int begin = arrays.offsets[i];
+      const int num_actions = arrays.offsets[i + 1] - begin;
+      RegretMatching(
+          absl::MakeConstSpan(&arrays.cumulative_regrets[begin], num_actions),
+          absl::MakeSpan(&arrays.current_policy[begin], num_actions));
+    }
+    CopyInfoStateArraysToTable();
+    return;
+  }
   for (auto& entry : info_states_) {
     entry.second.ApplyRegretMatching();
   }
@@ -15,14 +15,17 @@
 #ifndef OPEN_SPIEL_ALGORITHMS_CFR_H_
 #define OPEN_SPIEL_ALGORITHMS_CFR_H_
 
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+#include "open_spiel/abseil-cpp/absl/types/span.h"
 #include "open_spiel/policy.h"
 #include "open_spiel/spiel.h"
+#include "open_spiel/utils/thread.h"
 
 namespace open_spiel {
 namespace algorithms {
@@ -115,10 +118,35 @@ class CFRCurrentPolicy : public Policy {
 // CFR can be view as a policy iteration algorithm. Importantly, the policies
 // themselves do not converge to a Nash policy, but their average does.
 //
+// In precompiled mode, the solver numbers the information states when it walks
+// the game tree on construction, and keeps their values in flat arrays, which
+// it copies to the table after each update. The traversals then find a
+// state's values by its position in the tree, with no information state
+// strings and no hashing. The results are the same in both modes. It is off
+// by default in CFRSolverBase, as it restricts ComputeCounterFactualRegret()
+// to the root state; CFRSolver, CFRPlusSolver and CFRBRSolver turn it on.
+//
+// With a compiled tree, the solver also flattens the whole game tree into
+// arrays on construction: each node's type, player, information state and
+// children, the chance probabilities and the terminal utilities. The
+// traversals then sweep those arrays and never touch a State. This costs
+// memory for every history of the game, and gives the same results again.
+//
+// With more than one thread, each traversal of the compiled tree is split at
+// the first depth with a few subtrees per thread, such as the deals of a poker
+// game. The subtrees are walked in parallel, each logging its updates instead
+// of applying them, and the logs are then applied in the order of a serial
+// traversal, so the results are still the same. Traversals with policy
+// overrides (CFR-BR) stay serial.
+//
 class CFRSolverBase {
  public:
+  // compiled_tree implies precompiled, and more than one thread needs
+  // compiled_tree.
   CFRSolverBase(const Game& game, bool alternating_updates,
-                bool linear_averaging, bool regret_matching_plus);
+                bool linear_averaging, bool regret_matching_plus,
+                bool precompiled = false, bool compiled_tree = false,
+                int num_threads = 1);
   virtual ~CFRSolverBase() = default;
 
   // Performs one step of the CFR algorithm.
@@ -154,6 +182,7 @@ class CFRSolverBase {
   // will disable this feature. Otherwise it should be a [num_players] vector,
   // and if `policy_overrides[p] != nullptr` it will be used instead of the
   // current policy. This feature exists to support CFR-BR.
+  // In precompiled and compiled-tree modes, the state must be the root state.
   std::vector<double> ComputeCounterFactualRegret(
       const State& state, const std::optional<int>& alternating_player,
       const std::vector<double>& reach_probabilities,
@@ -163,41 +192,173 @@ class CFRSolverBase {
   void ApplyRegretMatching();
 
  private:
+  // The values of the information states in precompiled mode. Those of
+  // information state i are at [offsets[i], offsets[i + 1]) of each array.
+  struct InfoStateArrays {
+    std::vector<int> offsets;
+    std::vector<Action> legal_actions;
+    std::vector<double> cumulative_regrets;
+    std::vector<double> cumulative_policy;
+    std::vector<double> current_policy;
+    // Per information state: its key and its entry in info_states_.
+    std::vector<const std::string*> keys;
+    std::vector<CFRInfoStateValues*> values;
+  };
+
+  // The game tree in compiled-tree mode. The children of a node are next to
+  // each other, after it.
+  struct CompiledTree {
+    enum class NodeType : int8_t { kTerminal, kChance, kDecision };
+    struct Node {
+      NodeType type;
+      int player;  // The current player, or the chance player.
+      // The information state of a decision node, or the offset of a terminal
+      // node's utilities.
+      int index;
+      int first_child;
+      int num_children;
+    };
+    std::vector<Node> nodes;
+    std::vector<double> chance_probs;  // Per node below a chance node.
+    std::vector<double> utilities;  // Per terminal node, one per player.
+    int max_depth = 0;  // The root is at depth 0.
+    int max_children = 0;
+  };
+
+  // How a walk of tree_ treats the nodes. A parallel traversal walks the
+  // nodes above split_depth_ once to collect the subtrees at that depth as
+  // tasks, walks the tasks in parallel, and walks the nodes above once more to
+  // combine the tasks' values and updates.
+  enum class WalkPhase { kSerial, kCollect, kTask, kCombine };
+
+  // A subtree of a parallel traversal.
+  struct TreeTask {
+    int tree_node;
+    std::vector<double> reach_probabilities;
+    std::vector<double> values;
+    std::vector<double> scratch;
+    // The updates, in order: the information states, and for each its regret
+    // increments followed by its policy increments.
+    std::vector<int> update_info_states;
+    std::vector<double> update_increments;
+  };
+
+  struct TreeWalk {
+    WalkPhase phase;
+    double* scratch;  // See scratch_.
+    TreeTask* task = nullptr;  // kTask only.
+    int next_task = 0;  // kCombine only.
+  };
+
+  // As above. In precompiled mode, *node is the index of the state's first
+  // decision node in the depth-first order of the tree walk, which the call
+  // advances past the state's subtree; otherwise node is nullptr.
+  std::vector<double> ComputeCounterFactualRegret(
+      const State& state, const std::optional<int>& alternating_player,
+      const std::vector<double>& reach_probabilities,
+      const std::vector<const Policy*>* policy_overrides, int* node);
+
   std::vector<double> ComputeCounterFactualRegretForActionProbs(
       const State& state, const std::optional<int>& alternating_player,
       const std::vector<double>& reach_probabilities, const int current_player,
-      const std::vector<double>& info_state_policy,
-      const std::vector<Action>& legal_actions,
+      absl::Span<const double> info_state_policy,
+      absl::Span<const Action> legal_actions,
       std::vector<double>* child_values_out,
-      const std::vector<const Policy*>* policy_overrides);
-
-  void InitializeInfostateNodes(const State& state);
+      const std::vector<const Policy*>* policy_overrides, int* node);
+
+  // Adds the information states below the state to info_states_. In
+  // precompiled mode, also numbers them in order of first visit, with
+  // `indices` mapping the keys to the numbers, and records the decision nodes.
+  // In compiled-tree mode, tree_node is the state's node in tree_, which the
+  // call fills in, and otherwise -1.
+  void InitializeInfostateNodes(const State& state,
+                                std::unordered_map<std::string, int>* indices,
+                                int tree_node);
+
+  // Fills in a node of tree_, appends its children and returns the index of
+  // the first one.
+  int AddTreeChildren(int tree_node, CompiledTree::NodeType type, int player,
+                      int index, int num_children);
+
+  // Computes the depth and the widest node of tree_, allocates scratch_ and
+  // picks split_depth_.
+  void FinishCompiledTree(int num_threads);
+
+  // ComputeCounterFactualRegret() over tree_. `reach_probabilities` has an
+  // entry per player and one for chance, and the node's value for each player
+  // is written to `values`.
+  void ComputeCompiledTreeRegret(
+      int tree_node, int depth, const double* reach_probabilities,
+      const std::optional<int>& alternating_player,
+      const std::vector<const Policy*>* policy_overrides, double* values,
+      TreeWalk* walk);
+
+  // As above from the root, in parallel.
+  void ComputeParallelTreeRegret(const double* reach_probabilities,
+                                 const std::optional<int>& alternating_player,
+                                 double* values);
+
+  // Applies the updates logged by a task.
+  void ApplyTreeUpdates(const TreeTask& task);
+
+  // The policy of an overridden player at an information state, read from
+  // the override once per call to ComputeCounterFactualRegret().
+  absl::Span<const double> OverridePolicy(int index, const Policy* policy);
+
+  // Copies the values of info_states_ to info_state_arrays_, in the order of
+  // the indices.
+  void InitializeInfoStateArrays(
+      const std::unordered_map<std::string, int>& indices);
+
+  // Copies the values of info_state_arrays_ to info_states_.
+  void CopyInfoStateArraysToTable();
 
   // Fills `info_state_policy` to be a [num_actions] vector of the probabilities
   // found in `policy` at the given `info_state`.
   void GetInfoStatePolicyFromPolicy(std::vector<double>* info_state_policy,
-                                    const std::vector<Action>& legal_actions,
+                                    absl::Span<const Action> legal_actions,
                                     const Policy* policy,
                                     const std::string& info_state) const;
 
-  // Get the policy at this information state. The probabilities are ordered in
-  // the same order as legal_actions.
-  std::vector<double> GetPolicy(const std::string& info_state,
-                                const std::vector<Action>& legal_actions);
-
   void ApplyRegretMatchingPlusReset();
 
-  std::vector<double> RegretMatching(const std::string& info_state,
-                                     const std::vector<Action>& legal_actions);
-
   bool AllPlayersHaveZeroReachProb(
-      const std::vector<double>& reach_probabilities) const;
+      absl::Span<const double> reach_probabilities) const;
 
   const bool regret_matching_plus_;
   const bool alternating_updates_;
   const bool linear_averaging_;
+  const bool precompiled_;
+  const bool compiled_tree_;
 
   const int chance_player_;
+
+  // Precompiled mode only.
+  InfoStateArrays info_state_arrays_;
+  // Per decision node of the tree, in depth-first order: the index of its
+  // information state, and the number of decision nodes in its subtree,
+  // itself included.
+  std::vector<int> node_info_states_;
+  std::vector<int> node_subtree_sizes_;
+
+  // Compiled-tree mode only.
+  CompiledTree tree_;
+  // The policies of overridden players, laid out as the info state arrays,
+  // and per information state the call in which its policy was read.
+  std::vector<double> override_policies_;
+  std::vector<int> override_calls_;
+  int override_call_ = 0;
+  // The scratch space of a serial walk. Per depth: the reach probabilities
+  // and the values of a child, and the current player's value of each child.
+  std::vector<double> scratch_;
+  int scratch_stride_ = 0;
+
+  // Parallel traversals only. The tasks are reused across traversals, and
+  // the first num_tasks_ are those of the current one.
+  int split_depth_ = -1;
+  std::vector<TreeTask> tasks_;
+  int num_tasks_ = 0;
+  std::unique_ptr<ThreadPool> pool_;  // nullptr for a single thread.
 };
 
 // Standard CFR implementation.
@@ -205,11 +366,13 @@ class CFRSolverBase {
 // See https://poker.cs.ualberta.ca/publications/NIPS07-cfr.pdf
 class CFRSolver : public CFRSolverBase {
  public:
-  explicit CFRSolver(const Game& game)
+  explicit CFRSolver(const Game& game, bool compiled_tree = false,
+                     int num_threads = 1)
       : CFRSolverBase(game,
                       /*alternating_updates=*/true,
                       /*linear_averaging=*/false,
-                      /*regret_matching_plus=*/false) {}
+                      /*regret_matching_plus=*/false,
+                      /*precompiled=*/true, compiled_tree, num_threads) {}
 };
 
 // CFR+ implementation.
@@ -222,11 +385,13 @@ class CFRSolver : public CFRSolverBase {
 // - use linear averaging.
 class CFRPlusSolver : public CFRSolverBase {
  public:
-  CFRPlusSolver(const Game& game)
+  CFRPlusSolver(const Game& game, bool compiled_tree = false,
+                int num_threads = 1)
       : CFRSolverBase(game,
                       /*alternating_updates=*/true,
                       /*linear_averaging=*/true,
-                      /*regret_matching_plus=*/true) {}
+                      /*regret_matching_plus=*/true,
+                      /*precompiled=*/true, compiled_tree, num_threads) {}
 };
 
 }  // namespace algorithms
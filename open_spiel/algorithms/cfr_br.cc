@@ -20,11 +20,12 @@
 namespace open_spiel {
 namespace algorithms {
 
-CFRBRSolver::CFRBRSolver(const Game& game)
+CFRBRSolver::CFRBRSolver(const Game& game, bool compiled_tree)
     : CFRSolverBase(game,
                     /*alternating_updates=*/false,
                     /*linear_averaging=*/false,
-                    /*regret_matching_plus=*/false),
+                    /*regret_matching_plus=*/false,
+                    /*precompiled=*/true, compiled_tree),
       policy_overrides_(game.NumPlayers(), nullptr),
       uniform_policy_(GetUniformPolicy(game)) {
   for (int p = 0; p < game_.NumPlayers(); ++p) {
@@ -33,7 +33,7 @@ namespace algorithms {
 
 class CFRBRSolver : public CFRSolverBase {
  public:
-  explicit CFRBRSolver(const Game& game);
+  explicit CFRBRSolver(const Game& game, bool compiled_tree = false);
 
   void EvaluateAndUpdatePolicy() override;
 
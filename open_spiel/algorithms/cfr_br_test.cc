@@ -59,6 +59,31 @@ void CFRBRTest_LeducPoker() {
             << std::endl;
 }
 
+// The compiled tree gives the same policies, with the best responses as
+// policy overrides.
+void CFRBRTest_CompiledTree() {
+  std::shared_ptr<const Game> game = LoadGame("kuhn_poker");
+  CFRBRSolver solver(*game);
+  CFRBRSolver compiled(*game, /*compiled_tree=*/true);
+  for (int i = 0; i < 20; i++) {
+    solver.EvaluateAndUpdatePolicy();
+    compiled.EvaluateAndUpdatePolicy();
+  }
+  const std::unique_ptr<Policy> policy = compiled.AveragePolicy();
+  const std::unique_ptr<Policy> expected = solver.AveragePolicy();
+  const TabularPolicy uniform_policy = GetUniformPolicy(*game);
+  for (const auto& [info_state, actions_and_probs] :
+       uniform_policy.PolicyTable()) {
+    ActionsAndProbs probs = policy->GetStatePolicy(info_state);
+    ActionsAndProbs expected_probs = expected->GetStatePolicy(info_state);
+    SPIEL_CHECK_EQ(probs.size(), expected_probs.size());
+    for (int i = 0; i < probs.size(); ++i) {
+      SPIEL_CHECK_EQ(probs[i].first, expected_probs[i].first);
+      SPIEL_CHECK_EQ(probs[i].second, expected_probs[i].second);
+    }
+  }
+}
+
 }  // namespace
 }  // namespace algorithms
 }  // namespace open_spiel
@@ -68,4 +93,5 @@ namespace algorithms = open_spiel::algorithms;
 int main(int argc, char** argv) {
   algorithms::CFRBRTest_KuhnPoker();
   algorithms::CFRBRTest_LeducPoker();
+  algorithms::CFRBRTest_CompiledTree();
 }
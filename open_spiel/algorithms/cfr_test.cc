@@ -182,6 +182,97 @@ void CFRTest_TicTacToe(int num_iterations, double nashconv_upper_bound) {
   }
 }
 
+// Checks that the policies agree exactly at every decision node below state.
+void CheckSamePolicies(const State& state, const Policy& policy,
+                       const Policy& expected) {
+  if (state.IsTerminal()) return;
+  if (!state.IsChanceNode()) {
+    ActionsAndProbs actions_and_probs = policy.GetStatePolicy(state);
+    ActionsAndProbs expected_actions_and_probs = expected.GetStatePolicy(state);
+    SPIEL_CHECK_EQ(actions_and_probs.size(), expected_actions_and_probs.size());
+    for (int i = 0; i < actions_and_probs.size(); ++i) {
+      SPIEL_CHECK_EQ(actions_and_probs[i].first,
+                     expected_actions_and_probs[i].first);
+      SPIEL_CHECK_EQ(actions_and_probs[i].second,
+                     expected_actions_and_probs[i].second);
+    }
+  }
+  for (Action action : state.LegalActions()) {
+    CheckSamePolicies(*state.Child(action), policy, expected);
+  }
+}
+
+// The precompiled and compiled-tree modes give the same policies as the
+// string-keyed one, on one thread or several.
+void CFRTest_PrecompiledMatches(const Game& game, int num_iterations,
+                                bool alternating_updates,
+                                bool linear_averaging,
+                                bool regret_matching_plus) {
+  CFRSolverBase precompiled(game, alternating_updates, linear_averaging,
+                            regret_matching_plus, /*precompiled=*/true);
+  CFRSolverBase compiled_tree(game, alternating_updates, linear_averaging,
+                              regret_matching_plus, /*precompiled=*/true,
+                              /*compiled_tree=*/true);
+  CFRSolverBase parallel(game, alternating_updates, linear_averaging,
+                         regret_matching_plus, /*precompiled=*/true,
+                         /*compiled_tree=*/true, /*num_threads=*/3);
+  CFRSolverBase string_keyed(game, alternating_updates, linear_averaging,
+                             regret_matching_plus, /*precompiled=*/false);
+  for (int i = 0; i < num_iterations; i++) {
+    precompiled.EvaluateAndUpdatePolicy();
+    compiled_tree.EvaluateAndUpdatePolicy();
+    parallel.EvaluateAndUpdatePolicy();
+    string_keyed.EvaluateAndUpdatePolicy();
+  }
+  const std::unique_ptr<State> root = game.NewInitialState();
+  for (const CFRSolverBase* solver :
+       {&precompiled, &compiled_tree, &parallel}) {
+    CheckSamePolicies(*root, *solver->AveragePolicy(),
+                      *string_keyed.AveragePolicy());
+    CheckSamePolicies(*root, *solver->CurrentPolicy(),
+                      *string_keyed.CurrentPolicy());
+  }
+}
+
+void CFRTest_Precompiled() {
+  std::shared_ptr<const Game> kuhn_3p =
+      LoadGame("kuhn_poker", {{"players", GameParameter(3)}});
+  for (bool flag : {false, true}) {
+    CFRTest_PrecompiledMatches(*kuhn_3p, 10, /*alternating_updates=*/flag,
+                               /*linear_averaging=*/flag,
+                               /*regret_matching_plus=*/flag);
+  }
+  CFRTest_PrecompiledMatches(*LoadGame("leduc_poker"), 5,
+                             /*alternating_updates=*/true,
+                             /*linear_averaging=*/true,
+                             /*regret_matching_plus=*/true);
+  std::shared_ptr<const Game> goofspiel = LoadGameAsTurnBased(
+      "goofspiel", {{"imp_info", GameParameter(true)},
+                    {"points_order", GameParameter(std::string("random"))},
+                    {"num_cards", GameParameter(4)}});
+  CFRTest_PrecompiledMatches(*goofspiel, 5, /*alternating_updates=*/true,
+                             /*linear_averaging=*/false,
+                             /*regret_matching_plus=*/false);
+}
+
+void CFRTest_CompiledTreeSolvers() {
+  std::shared_ptr<const Game> game = LoadGame("kuhn_poker");
+  CFRSolver solver(*game);
+  CFRSolver compiled(*game, /*compiled_tree=*/true);
+  CFRPlusSolver plus_solver(*game);
+  CFRPlusSolver plus_compiled(*game, /*compiled_tree=*/true);
+  for (int i = 0; i < 50; i++) {
+    solver.EvaluateAndUpdatePolicy();
+    compiled.EvaluateAndUpdatePolicy();
+    plus_solver.EvaluateAndUpdatePolicy();
+    plus_compiled.EvaluateAndUpdatePolicy();
+  }
+  const std::unique_ptr<State> root = game->NewInitialState();
+  CheckSamePolicies(*root, *compiled.AveragePolicy(), *solver.AveragePolicy());
+  CheckSamePolicies(*root, *plus_compiled.AveragePolicy(),
+                    *plus_solver.AveragePolicy());
+}
+
 }  // namespace
 }  // namespace algorithms
 }  // namespace open_spiel
@@ -190,6 +281,8 @@ namespace algorithms = open_spiel::algorithms;
 
 int main(int argc, char** argv) {
   algorithms::CFRTest_KuhnPoker();
+  algorithms::CFRTest_Precompiled();
+  algorithms::CFRTest_CompiledTreeSolvers();
   algorithms::CFRTest_IIGoof4();
   algorithms::CFRPlusTest_KuhnPoker();
   algorithms::CFRTest_KuhnPokerRunsWithThreePlayers(
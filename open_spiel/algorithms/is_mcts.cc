@@ -19,6 +19,7 @@
 
 #include "open_spiel/abseil-cpp/absl/random/discrete_distribution.h"
 #include "open_spiel/abseil-cpp/absl/random/distributions.h"
+#include "open_spiel/abseil-cpp/absl/time/clock.h"
 #include "open_spiel/abseil-cpp/absl/time/time.h"
 #include "open_spiel/spiel.h"
 #include "open_spiel/spiel_utils.h"
@@ -33,7 +34,8 @@ ISMCTSBot::ISMCTSBot(int seed, std::shared_ptr<Evaluator> evaluator,
                      double uct_c, int max_simulations, int max_world_samples,
                      ISMCTSFinalPolicyType final_policy_type,
                      bool use_observation_string,
-                     bool allow_inconsistent_action_sets)
+                     bool allow_inconsistent_action_sets,
+                     int64_t max_time_ms, bool stop_early)
     : rng_(seed),
       evaluator_(evaluator),
       uct_c_(uct_c),
@@ -41,7 +43,12 @@ ISMCTSBot::ISMCTSBot(int seed, std::shared_ptr<Evaluator> evaluator,
       max_world_samples_(max_world_samples),
       final_policy_type_(final_policy_type),
       use_observation_string_(use_observation_string),
-      allow_inconsistent_action_sets_(allow_inconsistent_action_sets) {}
+      allow_inconsistent_action_sets_(allow_inconsistent_action_sets),
+      max_time_ms_(max_time_ms),
+      stop_early_(stop_early),
+      deadline_(absl::InfiniteFuture()),
+      simulations_(0),
+      stop_reason_(SearchStopReason::kNone) {}
 
 double ISMCTSBot::RandomNumber() { return absl::Uniform(rng_, 0.0, 1.0); }
 
@@ -60,6 +67,12 @@ ISMCTSStateKey ISMCTSBot::GetStateKey(const State& state) const {
 }
 
 ActionsAndProbs ISMCTSBot::RunSearch(const State& state) {
+  absl::Time deadline = deadline_;
+  if (max_time_ms_ > 0) {
+    deadline =
+        std::min(deadline, absl::Now() + absl::Milliseconds(max_time_ms_));
+  }
+  deadline_ = absl::InfiniteFuture();
   Reset();
   SPIEL_CHECK_EQ(state.GetGame()->GetType().dynamics,
                  GameType::Dynamics::kSequential);
@@ -70,19 +83,41 @@ ActionsAndProbs ISMCTSBot::RunSearch(const State& state) {
   // do not support ResampleFromInfostate in certain specific (single action)
   // states.
   std::vector<Action> legal_actions = state.LegalActions();
-  if (legal_actions.size() == 1) return {{legal_actions[0], 1.0}};
+  if (legal_actions.size() == 1) {
+    simulations_ = 0;
+    stop_reason_ = SearchStopReason::kSingleAction;
+    return {{legal_actions[0], 1.0}};
+  }
 
   root_node_ = CreateNewNode(state);
   SPIEL_CHECK_TRUE(root_node_ != nullptr);
 
   auto root_infostate_key = GetStateKey(state);
 
-  for (int sim = 0; sim < max_simulations_; ++sim) {
+  // The most visited action is only the final choice with kMaxVisitCount, and
+  // with inconsistent action sets the root may count actions that are not
+  // legal here.
+  const bool stop_early =
+      stop_early_ &&
+      final_policy_type_ == ISMCTSFinalPolicyType::kMaxVisitCount &&
+      !allow_inconsistent_action_sets_;
+  SearchBudget budget(max_simulations_, deadline);
+  int since_check = 0;
+  while (budget.Claim()) {
     std::unique_ptr<State> sampled_root_state = SampleRootState(state);
     SPIEL_CHECK_TRUE(root_infostate_key == GetStateKey(*sampled_root_state));
     SPIEL_CHECK_TRUE(sampled_root_state != nullptr);
     RunSimulation(sampled_root_state.get());
+    if (stop_early && ++since_check == SearchBudget::kCheckInterval) {
+      since_check = 0;
+      const int64_t remaining = budget.RemainingSimulations();
+      if (remaining > 0 && RootDecided(remaining)) {
+        budget.Stop(SearchStopReason::kDecided);
+      }
+    }
   }
+  simulations_ = budget.simulations();
+  stop_reason_ = budget.stop_reason();
 
   if (allow_inconsistent_action_sets_) {
     // Filter illegals for this state.
@@ -180,6 +215,22 @@ ActionsAndProbs ISMCTSBot::GetFinalPolicy(const State& state,
   return policy;
 }
 
+bool ISMCTSBot::RootDecided(int64_t remaining) const {
+  // Actions that were not tried yet count as having no visits.
+  int most = 0;
+  int second = 0;
+  for (const auto& action_and_child : root_node_->child_info) {
+    const int visits = action_and_child.second.visits;
+    if (visits > most) {
+      second = most;
+      most = visits;
+    } else {
+      second = std::max(second, visits);
+    }
+  }
+  return most - second > remaining;
+}
+
 std::unique_ptr<State> ISMCTSBot::ISMCTSBot::SampleRootState(
     const State& state) {
   if (max_world_samples_ == kUnlimitedNumWorldSamples) {
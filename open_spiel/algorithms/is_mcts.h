@@ -22,6 +22,7 @@
 #include <vector>
 
 #include "open_spiel/abseil-cpp/absl/container/flat_hash_map.h"
+#include "open_spiel/abseil-cpp/absl/time/time.h"
 #include "open_spiel/algorithms/mcts.h"
 #include "open_spiel/spiel.h"
 #include "open_spiel/spiel_bots.h"
@@ -69,12 +70,19 @@ class ISMCTSBot : public Bot {
   // (information state string or observation string) which can happen when
   // using observations or with game that have imperfect recall.
   //
+  // As in MCTSBot, a search also stops after max_time_ms, if it is positive,
+  // or at the deadline given to SetDeadline(), and with a time limit
+  // max_simulations may be 0 for no simulation limit. With stop_early and the
+  // kMaxVisitCount final policy it stops once the most visited action leads
+  // the others by more visits than the remaining simulations could give them.
+  //
   // Important note: this bot requires that State::ResampleFromInfostate is
   // implemented.
   ISMCTSBot(int seed, std::shared_ptr<Evaluator> evaluator, double uct_c,
             int max_simulations, int max_world_samples,
             ISMCTSFinalPolicyType final_policy_type,
-            bool use_observation_string, bool allow_inconsistent_action_sets);
+            bool use_observation_string, bool allow_inconsistent_action_sets,
+            int64_t max_time_ms = 0, bool stop_early = false);
 
   // An IS-MCTS with sensible defaults.
   ISMCTSBot(int seed, std::shared_ptr<Evaluator> evaluator, double uct_c,
@@ -92,6 +100,13 @@ class ISMCTSBot : public Bot {
 
   ActionsAndProbs RunSearch(const State& state);
 
+  // Makes the next search also stop at the deadline.
+  void SetDeadline(absl::Time deadline) { deadline_ = deadline; }
+
+  // The simulations run by the last search, and why it stopped.
+  int simulations() const { return simulations_; }
+  SearchStopReason stop_reason() const { return stop_reason_; }
+
   // Bot maintains no history, so these are empty.
   void Restart() override {}
   void RestartAt(const State& state) override {}
@@ -109,6 +124,10 @@ class ISMCTSBot : public Bot {
                                 const std::vector<Action>& legal_actions);
   Action SelectActionUCB(ISMCTSNode* node);
   ActionsAndProbs GetFinalPolicy(const State& state, ISMCTSNode* node) const;
+
+  // Whether the most visited action at the root leads every other action by
+  // more than `remaining` visits.
+  bool RootDecided(int64_t remaining) const;
   void ExpandIfNecessary(ISMCTSNode* node, Action action) const;
 
   // Check if an expansion is possible (i.e. node does not contain all the
@@ -140,6 +159,11 @@ class ISMCTSBot : public Bot {
   const ISMCTSFinalPolicyType final_policy_type_;
   const bool use_observation_string_;
   const bool allow_inconsistent_action_sets_;
+  const int64_t max_time_ms_;
+  const bool stop_early_;
+  absl::Time deadline_;  // Of the next search only.
+  int simulations_;
+  SearchStopReason stop_reason_;
   ISMCTSNode* root_node_;
 };
 
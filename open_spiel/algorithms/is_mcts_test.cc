@@ -98,6 +98,42 @@ void ISMCTS_LeducObservationTest() {
   PlayGame(*game, bot.get(), &rng);
 }
 
+void ISMCTS_SearchBudgetTest() {
+  std::shared_ptr<const Game> game = LoadGame("leduc_poker");
+  std::unique_ptr<State> state = game->NewInitialState();
+  state->ApplyAction(0);
+  state->ApplyAction(3);
+  auto evaluator =
+      std::make_shared<algorithms::RandomRolloutEvaluator>(1, kSeed);
+
+  algorithms::ISMCTSBot timed(
+      kSeed, evaluator, 5.0, /*max_simulations=*/0,
+      algorithms::kUnlimitedNumWorldSamples,
+      algorithms::ISMCTSFinalPolicyType::kMaxVisitCount, false, false,
+      /*max_time_ms=*/20, /*stop_early=*/false);
+  timed.GetPolicy(*state);
+  SPIEL_CHECK_GT(timed.simulations(), 1);
+  SPIEL_CHECK_TRUE(timed.stop_reason() == algorithms::SearchStopReason::kTime);
+
+  // The early stop keeps the action that the full search picks.
+  algorithms::ISMCTSBot early(
+      kSeed, evaluator, 5.0, /*max_simulations=*/10000,
+      algorithms::kUnlimitedNumWorldSamples,
+      algorithms::ISMCTSFinalPolicyType::kMaxVisitCount, false, false,
+      /*max_time_ms=*/0, /*stop_early=*/true);
+  algorithms::ISMCTSBot full(
+      kSeed, evaluator, 5.0, /*max_simulations=*/10000,
+      algorithms::kUnlimitedNumWorldSamples,
+      algorithms::ISMCTSFinalPolicyType::kMaxVisitCount, false, false);
+  const Action early_action = early.Step(*state);
+  SPIEL_CHECK_LT(early.simulations(), 10000);
+  SPIEL_CHECK_TRUE(early.stop_reason() ==
+                   algorithms::SearchStopReason::kDecided);
+  const Action full_action = full.Step(*state);
+  SPIEL_CHECK_EQ(full.simulations(), 10000);
+  SPIEL_CHECK_EQ(early_action, full_action);
+}
+
 }  // namespace
 }  // namespace open_spiel
 
@@ -105,4 +141,5 @@ int main(int argc, char** argv) {
   open_spiel::ISMCTS_BasicPlayGameTest_Kuhn();
   open_spiel::ISMCTS_BasicPlayGameTest_Leduc();
   open_spiel::ISMCTS_LeducObservationTest();
+  open_spiel::ISMCTS_SearchBudgetTest();
 }
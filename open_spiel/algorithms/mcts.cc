@@ -22,6 +22,7 @@
 #include <vector>
 
 #include "open_spiel/abseil-cpp/absl/algorithm/container.h"
+#include "open_spiel/abseil-cpp/absl/hash/hash.h"
 #include "open_spiel/abseil-cpp/absl/random/distributions.h"
 #include "open_spiel/abseil-cpp/absl/strings/str_cat.h"
 #include "open_spiel/abseil-cpp/absl/strings/str_format.h"
@@ -29,47 +30,463 @@
 #include "open_spiel/abseil-cpp/absl/time/time.h"
 #include "open_spiel/spiel.h"
 #include "open_spiel/spiel_utils.h"
+#include "open_spiel/utils/random.h"
+#include "open_spiel/utils/thread.h"
 
 namespace open_spiel {
 namespace algorithms {
 
 int MIN_GC_LIMIT = 5;
 
-int MemoryUsedMb(int nodes) {
-  return nodes * sizeof(SearchNode) / (1 << 20);
+// Number of locks guarding node children in tree-parallel searches.
+constexpr int kNumChildrenLocks = 1024;
+
+// The size of the slabs a SearchNodeArena allocates from. Larger blocks of
+// children get a slab of their own.
+constexpr int64_t kSlabBytes = 1 << 16;
+
+static_assert(sizeof(SearchNode) <= 40, "SearchNode should stay compact.");
+
+double MemoryUsedMb(int64_t bytes) { return bytes / double{1 << 20}; }
+
+// Copies `from` and the subtree below it into `to`, allocating in `arena`.
+// Children of nodes explored fewer than min_explore_count times are left out.
+// With `copies`, children shared by several nodes are copied once, and the map
+// records the copy of each block of children. Returns the number of nodes
+// copied below `to`.
+int CopyTree(const SearchNode& from, int min_explore_count,
+             SearchNodeArena* arena, SearchNode* to,
+             absl::flat_hash_map<const SearchNode*, SearchNode*>* copies) {
+  *to = from;
+  if (from.solved()) to->outcome_values = arena->NewOutcome(from.outcome());
+  if (from.num_children == 0 || from.explore_count < min_explore_count) {
+    to->first_child = nullptr;
+    to->num_children = 0;
+    return 0;
+  }
+  if (copies != nullptr) {
+    auto [it, inserted] = copies->insert({from.first_child, nullptr});
+    if (!inserted) {
+      to->first_child = it->second;
+      return 0;
+    }
+    it->second = arena->NewNodes(from.num_children);
+    to->first_child = it->second;
+  } else {
+    to->first_child = arena->NewNodes(from.num_children);
+  }
+  int nodes = from.num_children;
+  for (int i = 0; i < from.num_children; ++i) {
+    nodes += CopyTree(from.first_child[i], min_explore_count, arena,
+                      &to->first_child[i], copies);
+  }
+  return nodes;
 }
 
-std::vector<double> RandomRolloutEvaluator::Evaluate(const State& state) {
-  std::vector<double> result;
-  for (int i = 0; i < n_rollouts_; ++i) {
-    std::unique_ptr<State> working_state = state.Clone();
-    while (!working_state->IsTerminal()) {
-      if (working_state->IsChanceNode()) {
-        ActionsAndProbs outcomes = working_state->ChanceOutcomes();
-        working_state->ApplyAction(SampleAction(outcomes, rng_).first);
-      } else {
-        std::vector<Action> actions = working_state->LegalActions();
-        working_state->ApplyAction(
-            actions[absl::Uniform(rng_, 0u, actions.size())]);
-      }
+void* SearchNodeArena::Allocate(int64_t bytes) {
+  // Everything handed out is a multiple of 8 bytes, so it stays aligned.
+  bytes = (bytes + 7) & ~int64_t{7};
+  while (slab_ < slabs_.size() && offset_ + bytes > slabs_[slab_].size) {
+    ++slab_;
+    offset_ = 0;
+  }
+  if (slab_ == slabs_.size()) {
+    const int64_t size = std::max(kSlabBytes, bytes);
+    slabs_.push_back({std::make_unique<char[]>(size), size});
+  }
+  void* memory = slabs_[slab_].memory.get() + offset_;
+  offset_ += bytes;
+  bytes_used_ += bytes;
+  return memory;
+}
+
+SearchNode* SearchNodeArena::NewNodes(int count) {
+  if (count == 0) return nullptr;
+  SearchNode* nodes =
+      static_cast<SearchNode*>(Allocate(count * sizeof(SearchNode)));
+  std::uninitialized_default_construct_n(nodes, count);
+  return nodes;
+}
+
+const double* SearchNodeArena::NewOutcome(absl::Span<const double> outcome) {
+  double* values =
+      static_cast<double*>(Allocate(outcome.size() * sizeof(double)));
+  std::copy(outcome.begin(), outcome.end(), values);
+  return values;
+}
+
+void SearchNodeArena::Reset() {
+  slab_ = 0;
+  offset_ = 0;
+  bytes_used_ = 0;
+}
+
+MCTSTranspositionTable::MCTSTranspositionTable(int size)
+    : entries_(size > 0 ? (size + kWays - 1) / kWays * kWays : 0) {}
+
+int MCTSTranspositionTable::BucketStart(uint64_t hash, int move_number) const {
+  const size_t num_buckets = entries_.size() / kWays;
+  return absl::Hash<std::pair<uint64_t, int>>{}({hash, move_number}) %
+         num_buckets * kWays;
+}
+
+const MCTSTranspositionTable::Entry* MCTSTranspositionTable::Find(
+    uint64_t hash, int move_number) const {
+  const int start = BucketStart(hash, move_number);
+  for (int i = start; i < start + kWays; ++i) {
+    const Entry& entry = entries_[i];
+    if (entry.children != nullptr && entry.hash == hash &&
+        entry.move_number == move_number) {
+      return &entry;
+    }
+  }
+  return nullptr;
+}
+
+void MCTSTranspositionTable::Insert(uint64_t hash, int move_number,
+                                    SearchNode* children, int num_children) {
+  const int start = BucketStart(hash, move_number);
+  Entry* replaced = nullptr;
+  for (int i = start; i < start + kWays; ++i) {
+    Entry& entry = entries_[i];
+    if (entry.children == nullptr) {
+      replaced = &entry;
+      break;
     }
+    if (entry.move_number >= move_number &&
+        (replaced == nullptr || entry.move_number > replaced->move_number)) {
+      replaced = &entry;
+    }
+  }
+  if (replaced != nullptr) {
+    *replaced = {hash, move_number, num_children, children};
+  }
+}
 
-    std::vector<double> returns = working_state->Returns();
-    if (result.empty()) {
-      result.swap(returns);
-    } else {
-      SPIEL_CHECK_EQ(returns.size(), result.size());
-      for (int i = 0; i < result.size(); ++i) {
-        result[i] += returns[i];
+void MCTSTranspositionTable::Clear() {
+  std::fill(entries_.begin(), entries_.end(), Entry());
+}
+
+void MCTSTranspositionTable::Remap(
+    const absl::flat_hash_map<const SearchNode*, SearchNode*>& copies) {
+  for (Entry& entry : entries_) {
+    if (entry.children == nullptr) continue;
+    auto it = copies.find(entry.children);
+    entry.children = it != copies.end() ? it->second : nullptr;
+  }
+}
+
+std::string SearchStopReasonToString(SearchStopReason reason) {
+  switch (reason) {
+    case SearchStopReason::kNone:
+      return "not stopped";
+    case SearchStopReason::kSimulations:
+      return "simulations";
+    case SearchStopReason::kTime:
+      return "time";
+    case SearchStopReason::kSolved:
+      return "solved";
+    case SearchStopReason::kSingleAction:
+      return "single action";
+    case SearchStopReason::kDecided:
+      return "decided";
+  }
+  SpielFatalError("Unknown SearchStopReason.");
+}
+
+SearchBudget::SearchBudget(int max_simulations, absl::Time deadline)
+    : start_(absl::Now()),
+      deadline_(deadline),
+      left_(max_simulations <= 0 && deadline != absl::InfiniteFuture()
+                ? std::numeric_limits<int>::max()
+                : max_simulations),
+      claimed_(0),
+      reason_(SearchStopReason::kNone) {}
+
+bool SearchBudget::Claim() {
+  if (left_.fetch_sub(1) <= 0) return false;
+  const int claimed = claimed_.fetch_add(1);
+  // Reading the clock is cheap next to a simulation, but not free. The first
+  // simulation always runs, so that the root gets expanded.
+  if (claimed % kCheckInterval == 1 && deadline_ != absl::InfiniteFuture() &&
+      absl::Now() >= deadline_) {
+    Stop(SearchStopReason::kTime);
+    claimed_ -= 1;
+    return false;
+  }
+  return true;
+}
+
+void SearchBudget::Unclaim() {
+  claimed_ -= 1;
+  if (reason_ == SearchStopReason::kNone) left_ += 1;
+}
+
+void SearchBudget::Stop(SearchStopReason reason) {
+  SearchStopReason none = SearchStopReason::kNone;
+  reason_.compare_exchange_strong(none, reason);
+  left_ = 0;
+}
+
+int64_t SearchBudget::RemainingSimulations() const {
+  const int64_t left = std::max(left_.load(), 0);
+  if (deadline_ == absl::InfiniteFuture()) return left;
+  const absl::Time now = absl::Now();
+  const double elapsed = absl::ToDoubleSeconds(now - start_);
+  if (elapsed <= 0 || claimed_ == 0) return left;
+  const double rate = claimed_ / elapsed;
+  const double by_time =
+      std::max(rate * absl::ToDoubleSeconds(deadline_ - now), 0.0);
+  return std::min<int64_t>(left, std::ceil(by_time));
+}
+
+SearchStopReason SearchBudget::stop_reason() const {
+  const SearchStopReason reason = reason_;
+  return reason == SearchStopReason::kNone ? SearchStopReason::kSimulations
+                                           : reason;
+}
+
+double MCTSSearchStats::BranchingFactor() const {
+  return expansions > 0 ? static_cast<double>(expanded_children) / expansions
+                        : 0;
+}
+
+double MCTSSearchStats::MeanDepth() const {
+  int64_t count = 0;
+  double sum = 0;
+  for (int depth = 0; depth < depth_histogram.size(); ++depth) {
+    count += depth_histogram[depth];
+    sum += static_cast<double>(depth) * depth_histogram[depth];
+  }
+  return count > 0 ? sum / count : 0;
+}
+
+void MCTSSearchStats::Merge(const MCTSSearchStats& other) {
+  simulations += other.simulations;
+  if (stop_reason == SearchStopReason::kNone) stop_reason = other.stop_reason;
+  wall_seconds = std::max(wall_seconds, other.wall_seconds);
+  selection_seconds += other.selection_seconds;
+  expansion_seconds += other.expansion_seconds;
+  evaluation_seconds += other.evaluation_seconds;
+  backpropagation_seconds += other.backpropagation_seconds;
+  gc_seconds += other.gc_seconds;
+  evaluator_calls += other.evaluator_calls;
+  evaluator_batches += other.evaluator_batches;
+  tree_nodes += other.tree_nodes;
+  tree_bytes += other.tree_bytes;
+  reused_nodes += other.reused_nodes;
+  new_nodes += other.new_nodes;
+  expansions += other.expansions;
+  expanded_children += other.expanded_children;
+  gc_passes += other.gc_passes;
+  gc_nodes_freed += other.gc_nodes_freed;
+  transposition_lookups += other.transposition_lookups;
+  transposition_hits += other.transposition_hits;
+  if (depth_histogram.size() < other.depth_histogram.size()) {
+    depth_histogram.resize(other.depth_histogram.size());
+  }
+  for (int depth = 0; depth < other.depth_histogram.size(); ++depth) {
+    depth_histogram[depth] += other.depth_histogram[depth];
+  }
+}
+
+json::Object MCTSSearchStats::ToJson() const {
+  return {
+      {"simulations", simulations},
+      {"stop_reason", SearchStopReasonToString(stop_reason)},
+      {"wall_seconds", wall_seconds},
+      {"phase_seconds", json::Object({
+          {"selection", selection_seconds},
+          {"expansion", expansion_seconds},
+          {"evaluation", evaluation_seconds},
+          {"backpropagation", backpropagation_seconds},
+          {"gc", gc_seconds},
+      })},
+      {"evaluator", json::Object({
+          {"calls", evaluator_calls},
+          {"batches", evaluator_batches},
+      })},
+      {"tree", json::Object({
+          {"nodes", tree_nodes},
+          {"bytes", tree_bytes},
+          {"reused_nodes", reused_nodes},
+          {"new_nodes", new_nodes},
+          {"expansions", expansions},
+          {"branching_factor", BranchingFactor()},
+      })},
+      {"depth", json::Object({
+          {"mean", MeanDepth()},
+          {"max", MaxDepth()},
+          {"histogram", json::CastToArray(depth_histogram)},
+      })},
+      {"gc", json::Object({
+          {"passes", gc_passes},
+          {"nodes_freed", gc_nodes_freed},
+      })},
+      {"transpositions", json::Object({
+          {"lookups", transposition_lookups},
+          {"hits", transposition_hits},
+      })},
+  };
+}
+
+std::vector<Evaluator::Evaluation> Evaluator::EvaluateBatch(
+    absl::Span<const State* const> states) {
+  std::vector<Evaluation> evaluations;
+  evaluations.reserve(states.size());
+  for (const State* state : states) {
+    evaluations.push_back({Evaluate(*state), Prior(*state)});
+  }
+  return evaluations;
+}
+
+std::vector<double> Evaluator::EvaluateInPlace(State* state) {
+  return Evaluate(*state);
+}
+
+std::vector<double> Evaluator::Evaluate(const State& state,
+                                        std::mt19937* rng) {
+  return Evaluate(state);
+}
+
+std::vector<double> Evaluator::EvaluateInPlace(State* state,
+                                               std::mt19937* rng) {
+  return EvaluateInPlace(state);
+}
+
+std::vector<Evaluator::Evaluation> Evaluator::EvaluateBatch(
+    absl::Span<const State* const> states, std::mt19937* rng) {
+  return EvaluateBatch(states);
+}
+
+// How many tasks the rollouts of a multi-threaded RandomRolloutEvaluator are
+// split into per thread, so that threads finishing early can take more.
+constexpr int kRolloutTasksPerThread = 2;
+
+// Plays random moves until the end of the game, recording them in `moves` if
+// given, and adds the returns to `sums`.
+void PlayOut(State* state, Xoshiro256* rng,
+             std::vector<State::PlayerAction>* moves,
+             std::vector<double>* sums) {
+  while (!state->IsTerminal()) {
+    const double z = rng->UniformDouble();
+    const Action action =
+        state->IsChanceNode() ? SampleAction(state->ChanceOutcomes(), z).first
+                              : state->UniformRandomLegalAction(z);
+    if (moves != nullptr) moves->push_back({state->CurrentPlayer(), action});
+    state->ApplyAction(action);
+  }
+  const std::vector<double> returns = state->Returns();
+  SPIEL_CHECK_EQ(returns.size(), sums->size());
+  for (int i = 0; i < sums->size(); ++i) {
+    (*sums)[i] += returns[i];
+  }
+}
+
+RandomRolloutEvaluator::RandomRolloutEvaluator(int n_rollouts, int seed,
+                                               int num_threads)
+    : n_rollouts_(n_rollouts),
+      seed_(seed),
+      rng_(seed),
+      num_tasks_(num_threads > 1 ? num_threads * kRolloutTasksPerThread : 1),
+      pool_(num_threads > 1 ? std::make_unique<ThreadPool>(num_threads - 1)
+                            : nullptr) {
+  SPIEL_CHECK_GE(n_rollouts_, 1);
+}
+
+std::vector<double> RandomRolloutEvaluator::RunTasks(const State& state,
+                                                     State* working_state,
+                                                     std::mt19937* rng) {
+  const bool undo = state.GetGame()->GetType().provides_undo;
+  const int num_tasks = std::min(n_rollouts_, num_tasks_);
+  SPIEL_CHECK_TRUE(working_state == nullptr || (undo && num_tasks == 1));
+  std::vector<uint64_t> seeds(num_tasks);
+  if (rng != nullptr) {
+    // Evaluators with different seeds still play different rollouts.
+    for (uint64_t& seed : seeds) {
+      seed = ((uint64_t{(*rng)()} << 32) | (*rng)()) ^ seed_;
+    }
+  } else {
+    absl::MutexLock lock(&rng_mutex_);
+    for (uint64_t& seed : seeds) seed = (uint64_t{rng_()} << 32) | rng_();
+  }
+  std::vector<std::vector<double>> sums(
+      num_tasks, std::vector<double>(state.NumPlayers(), 0));
+
+  auto run_task = [&](int task) {
+    Xoshiro256 task_rng(seeds[task]);
+    const int count =
+        n_rollouts_ / num_tasks + (task < n_rollouts_ % num_tasks ? 1 : 0);
+    if (!undo) {
+      for (int i = 0; i < count; ++i) {
+        std::unique_ptr<State> copy = state.Clone();
+        PlayOut(copy.get(), &task_rng, nullptr, &sums[task]);
+      }
+      return;
+    }
+    std::unique_ptr<State> copy;
+    State* task_state = working_state;
+    if (task_state == nullptr) {
+      copy = state.Clone();
+      task_state = copy.get();
+    }
+    // Reused by the rollouts of every task run on this thread.
+    thread_local std::vector<State::PlayerAction> moves;
+    for (int i = 0; i < count; ++i) {
+      moves.clear();
+      PlayOut(task_state, &task_rng, &moves, &sums[task]);
+      for (auto move = moves.rbegin(); move != moves.rend(); ++move) {
+        task_state->UndoAction(move->player, move->action);
       }
     }
+  };
+  if (pool_ != nullptr && num_tasks > 1) {
+    pool_->ParallelFor(num_tasks, run_task);
+  } else {
+    run_task(0);
   }
-  for (int i = 0; i < result.size(); ++i) {
-    result[i] /= n_rollouts_;
+
+  // Adding up the tasks in order keeps the result independent of timing.
+  std::vector<double> result = sums[0];
+  for (int task = 1; task < num_tasks; ++task) {
+    for (int i = 0; i < result.size(); ++i) result[i] += sums[task][i];
   }
+  for (double& value : result) value /= n_rollouts_;
   return result;
 }
 
+std::vector<double> RandomRolloutEvaluator::Evaluate(const State& state) {
+  return RunTasks(state, nullptr, nullptr);
+}
+
+std::vector<double> RandomRolloutEvaluator::EvaluateInPlace(State* state) {
+  return EvaluateInPlace(state, nullptr);
+}
+
+std::vector<double> RandomRolloutEvaluator::Evaluate(const State& state,
+                                                     std::mt19937* rng) {
+  return RunTasks(state, nullptr, rng);
+}
+
+std::vector<double> RandomRolloutEvaluator::EvaluateInPlace(
+    State* state, std::mt19937* rng) {
+  if (!state->GetGame()->GetType().provides_undo ||
+      std::min(n_rollouts_, num_tasks_) > 1) {
+    return RunTasks(*state, nullptr, rng);
+  }
+  return RunTasks(*state, state, rng);
+}
+
+std::vector<Evaluator::Evaluation> RandomRolloutEvaluator::EvaluateBatch(
+    absl::Span<const State* const> states, std::mt19937* rng) {
+  std::vector<Evaluation> evaluations;
+  evaluations.reserve(states.size());
+  for (const State* state : states) {
+    evaluations.push_back({Evaluate(*state, rng), Prior(*state)});
+  }
+  return evaluations;
+}
+
 ActionsAndProbs RandomRolloutEvaluator::Prior(const State& state) {
   // Returns equal probability for all actions.
   if (state.IsChanceNode()) {
@@ -87,32 +504,32 @@ ActionsAndProbs RandomRolloutEvaluator::Prior(const State& state) {
 
 // UCT value of given child
 double SearchNode::UCTValue(int parent_explore_count, double uct_c) const {
-  if (!outcome.empty()) {
-    return outcome[player];
+  if (solved()) {
+    return outcome_values[player];
   }
 
   if (explore_count == 0) return std::numeric_limits<double>::infinity();
 
   // The "greedy-value" of choosing a given child is always with respect to
   // the current player for this node.
-  return total_reward / explore_count +
+  return double{total_reward} / explore_count +
          uct_c * std::sqrt(std::log(parent_explore_count) / explore_count);
 }
 
 double SearchNode::PUCTValue(int parent_explore_count, double uct_c) const {
   // Returns the PUCT value of this node.
-  if (!outcome.empty()) {
-    return outcome[player];
+  if (solved()) {
+    return outcome_values[player];
   }
 
-  return ((explore_count != 0 ? total_reward / explore_count : 0) +
+  return ((explore_count != 0 ? double{total_reward} / explore_count : 0) +
           uct_c * prior * std::sqrt(parent_explore_count) /
               (explore_count + 1));
 }
 
 bool SearchNode::CompareFinal(const SearchNode& b) const {
-  double out = (outcome.empty() ? 0 : outcome[player]);
-  double out_b = (b.outcome.empty() ? 0 : b.outcome[b.player]);
+  double out = (solved() ? outcome_values[player] : 0);
+  double out_b = (b.solved() ? b.outcome_values[b.player] : 0);
   if (out != out_b) {
     return out < out_b;
   }
@@ -134,7 +551,7 @@ const SearchNode& SearchNode::BestChild() const {
   // - Hardest loss if everything is a loss
   // - Highest expected reward if explore counts are equal (unlikely).
   // - Longest win, if multiple are proven (unlikely due to early stopping).
-  return *std::max_element(children.begin(), children.end(),
+  return *std::max_element(children().begin(), children().end(),
                            [](const SearchNode& a, const SearchNode& b) {
                              return a.CompareFinal(b);
                            });
@@ -142,10 +559,10 @@ const SearchNode& SearchNode::BestChild() const {
 
 std::string SearchNode::ChildrenStr(const State& state) const {
   std::string out;
-  if (!children.empty()) {
+  if (num_children > 0) {
     std::vector<const SearchNode*> refs;  // Sort a list of refs, not a copy.
-    refs.reserve(children.size());
-    for (const SearchNode& child : children) {
+    refs.reserve(num_children);
+    for (const SearchNode& child : children()) {
       refs.push_back(&child);
     }
     std::sort(refs.begin(), refs.end(),
@@ -167,11 +584,11 @@ std::string SearchNode::ToString(const State& state) const {
                                 : "none"),
       player, prior, (explore_count ? total_reward / explore_count : 0.),
       explore_count,
-      (outcome.empty()
-           ? "none"
-           : absl::StrFormat("%4.1f",
-                             outcome[player == kChancePlayerId ? 0 : player])),
-      children.size());
+      (!solved() ? "none"
+                 : absl::StrFormat(
+                       "%4.1f",
+                       outcome_values[player == kChancePlayerId ? 0 : player])),
+      num_children);
 }
 
 std::vector<double> dirichlet_noise(int count, double alpha,
@@ -195,56 +612,212 @@ MCTSBot::MCTSBot(const Game& game, std::shared_ptr<Evaluator> evaluator,
                  double uct_c, int max_simulations, int64_t max_memory_mb,
                  bool solve, int seed, bool verbose,
                  ChildSelectionPolicy child_selection_policy,
-                 double dirichlet_alpha, double dirichlet_epsilon)
+                 double dirichlet_alpha, double dirichlet_epsilon,
+                 int num_threads, int batch_size,
+                 int transposition_table_size, bool use_undo,
+                 int64_t max_time_ms, bool stop_early)
     : uct_c_{uct_c},
       max_simulations_{max_simulations},
-      max_nodes_((max_memory_mb << 20) / sizeof(SearchNode) + 1),
+      max_time_ms_(max_time_ms),
+      stop_early_(stop_early),
+      deadline_(absl::InfiniteFuture()),
+      max_memory_(max_memory_mb << 20),
       nodes_(0),
       gc_limit_(MIN_GC_LIMIT),
       verbose_(verbose),
       solve_(solve),
       max_utility_(game.MaxUtility()),
+      min_utility_(game.MinUtility()),
       dirichlet_alpha_(dirichlet_alpha),
       dirichlet_epsilon_(dirichlet_epsilon),
       rng_(seed),
       child_selection_policy_(child_selection_policy),
-      evaluator_(evaluator) {
+      evaluator_(evaluator),
+      root_(nullptr),
+      transpositions_(transposition_table_size),
+      num_threads_(num_threads),
+      batch_size_(batch_size),
+      use_undo_(use_undo && game.GetType().provides_undo),
+      virtual_loss_(num_threads > 1 || batch_size > 1) {
   GameType game_type = game.GetType();
   if (game_type.reward_model != GameType::RewardModel::kTerminal)
     SpielFatalError("Game must have terminal rewards.");
   if (game_type.dynamics != GameType::Dynamics::kSequential)
     SpielFatalError("Game must have sequential turns.");
+  if (solve_ && transposition_table_size > 0)
+    SpielFatalError("Solving is not supported with a transposition table.");
+  SPIEL_CHECK_GE(num_threads_, 1);
+  SPIEL_CHECK_GE(batch_size_, 1);
+  if (num_threads_ > 1) {
+    children_locks_ = std::make_unique<absl::Mutex[]>(kNumChildrenLocks);
+    stats_locks_ = std::make_unique<absl::Mutex[]>(kNumChildrenLocks);
+  }
+}
+
+void MCTSBot::ThreadStats::StartSimulation() {
+  timed = simulations++ % MCTSSearchStats::kTimingInterval == 0;
+  if (timed) lap_start = std::chrono::steady_clock::now();
+}
+
+void MCTSBot::ThreadStats::Lap(double* phase_seconds) {
+  if (!timed) return;
+  const auto now = std::chrono::steady_clock::now();
+  *phase_seconds += std::chrono::duration<double>(now - lap_start).count() *
+                    MCTSSearchStats::kTimingInterval;
+  lap_start = now;
+}
+
+void MCTSBot::ThreadStats::AddDepth(int depth) {
+  std::vector<int64_t>& histogram = stats.depth_histogram;
+  if (depth >= histogram.size()) histogram.resize(depth + 1);
+  histogram[depth] += 1;
+}
+
+absl::Mutex* MCTSBot::ChildrenLock(const SearchNode* node) const {
+  if (num_threads_ == 1) return nullptr;
+  const uintptr_t address = reinterpret_cast<uintptr_t>(node);
+  return &children_locks_[address / sizeof(SearchNode) % kNumChildrenLocks];
+}
+
+absl::Mutex* MCTSBot::StatsLock(const SearchNode* parent) const {
+  if (num_threads_ == 1) return nullptr;
+  const uintptr_t address =
+      reinterpret_cast<uintptr_t>(parent ? parent->first_child : nullptr);
+  return &stats_locks_[address / sizeof(SearchNode) % kNumChildrenLocks];
+}
+
+void MCTSBot::Restart() {
+  root_ = nullptr;
+  root_history_.clear();
+  arena_.Reset();
+  transpositions_.Clear();
+}
+
+void MCTSBot::RestartAt(const State& state) { AdvanceRoot(state.History()); }
+
+void MCTSBot::InformAction(const State& state, Player player_id,
+                           Action action) {
+  std::vector<Action> history = state.History();
+  history.push_back(action);
+  AdvanceRoot(history);
+}
+
+void MCTSBot::AdvanceRoot(const std::vector<Action>& history) {
+  if (root_ == nullptr) return;
+  if (history.size() < root_history_.size() ||
+      !std::equal(root_history_.begin(), root_history_.end(),
+                  history.begin())) {
+    Restart();
+    return;
+  }
+  if (history.size() == root_history_.size()) return;
+  const SearchNode* node = root_;
+  for (int i = root_history_.size(); i < history.size(); ++i) {
+    absl::Span<const SearchNode> children = node->children();
+    auto child = absl::c_find_if(
+        children, [&](const SearchNode& c) { return c.action == history[i]; });
+    if (child == children.end() || child->num_children == 0) {
+      Restart();
+      return;
+    }
+    node = &*child;
+  }
+  Rebuild(*node, 0);
+  root_history_ = history;
+  root_noised_ = false;
+}
+
+void MCTSBot::NewTree(const State& state) {
+  arena_.Reset();
+  transpositions_.Clear();
+  root_ = arena_.NewNodes(1);
+  *root_ = SearchNode(kInvalidAction, state.CurrentPlayer(), 1);
+  root_history_ = state.History();
+  nodes_ = 1;
+  // PreparePriors() adds the noise when it expands the root.
+  root_noised_ = true;
+}
+
+const SearchNode* MCTSBot::ContinueSearch(const State& state) {
+  StartSearch(state, absl::Now());
+  return root_;
+}
+
+void MCTSBot::StartSearch(const State& state, absl::Time start) {
+  AdvanceRoot(state.History());
+  if (root_ == nullptr) {
+    NewTree(state);
+  } else if (dirichlet_alpha_ > 0 && !root_noised_) {
+    // The root was expanded without noise when it was an inner node.
+    std::vector<double> noise =
+        dirichlet_noise(root_->num_children, dirichlet_alpha_, &rng_);
+    for (int i = 0; i < root_->num_children; ++i) {
+      SearchNode& child = root_->first_child[i];
+      child.prior =
+          (1 - dirichlet_epsilon_) * child.prior + dirichlet_epsilon_ * noise[i];
+    }
+    root_noised_ = true;
+  }
+  Search(state, start);
 }
 
 Action MCTSBot::Step(const State& state) {
   absl::Time start = absl::Now();
-  std::unique_ptr<SearchNode> root = MCTSearch(state);
-  SPIEL_CHECK_GT(root->children.size(), 0);
+  StartSearch(state, start);
+  SPIEL_CHECK_GT(root_->num_children, 0);
 
-  const SearchNode& best = root->BestChild();
+  const SearchNode& best = root_->BestChild();
+  const Action action = best.action;
 
   if (verbose_) {
     double seconds = absl::ToDoubleSeconds(absl::Now() - start);
     std::cerr
         << absl::StrFormat(
-               ("Finished %d sims in %.3f secs, %.1f sims/s, "
-                "tree size: %d nodes / %d mb."),
-               root->explore_count, seconds, (root->explore_count / seconds),
-               nodes_, MemoryUsedMb(nodes_))
+               ("Finished %d sims in %.3f secs, %.1f sims/s, stopped by %s, "
+                "tree size: %d nodes / %.1f mb, %d reused / %d new nodes, "
+                "%d evaluator calls."),
+               stats_.simulations, seconds, (stats_.simulations / seconds),
+               SearchStopReasonToString(stats_.stop_reason), stats_.tree_nodes,
+               MemoryUsedMb(stats_.tree_bytes), stats_.reused_nodes,
+               stats_.new_nodes, stats_.evaluator_calls)
         << std::endl;
+    std::cerr << absl::StrFormat(
+                     ("Phases: selection %.3f, expansion %.3f, evaluation "
+                      "%.3f, backpropagation %.3f, gc %.3f secs; depth: mean "
+                      "%.1f, max %d; branching factor %.1f; %d gc passes."),
+                     stats_.selection_seconds, stats_.expansion_seconds,
+                     stats_.evaluation_seconds,
+                     stats_.backpropagation_seconds, stats_.gc_seconds,
+                     stats_.MeanDepth(), stats_.MaxDepth(),
+                     stats_.BranchingFactor(), stats_.gc_passes)
+              << std::endl;
+    if (transpositions_.enabled()) {
+      const int64_t lookups = stats_.transposition_lookups;
+      std::cerr << absl::StrFormat(
+                       "Transpositions: %d hits in %d lookups (%.1f%%).",
+                       stats_.transposition_hits, lookups,
+                       lookups > 0
+                           ? 100.0 * stats_.transposition_hits / lookups
+                           : 0.0)
+                << std::endl;
+    }
     std::cerr << "Root:" << std::endl;
-    std::cerr << root->ToString(state) << std::endl;
+    std::cerr << root_->ToString(state) << std::endl;
     std::cerr << "Children:" << std::endl;
-    std::cerr << root->ChildrenStr(state) << std::endl;
-    if (!best.children.empty()) {
+    std::cerr << root_->ChildrenStr(state) << std::endl;
+    if (best.num_children > 0) {
       std::unique_ptr<State> chosen_state = state.Clone();
-      chosen_state->ApplyAction(best.action);
+      chosen_state->ApplyAction(action);
       std::cerr << "Children of chosen:" << std::endl;
       std::cerr << best.ChildrenStr(*chosen_state) << std::endl;
     }
   }
 
-  return best.action;
+  // The caller plays the action without informing this bot.
+  std::vector<Action> history = root_history_;
+  history.push_back(action);
+  AdvanceRoot(history);
+  return action;
 }
 
 std::pair<ActionsAndProbs, Action> MCTSBot::StepWithPolicy(const State& state) {
@@ -252,123 +825,224 @@ std::pair<ActionsAndProbs, Action> MCTSBot::StepWithPolicy(const State& state) {
   return {{{action, 1.}}, action};
 }
 
-std::unique_ptr<State> MCTSBot::ApplyTreePolicy(
-    SearchNode* root, const State& state,
-    std::vector<SearchNode*>* visit_path) {
+void MCTSBot::PreparePriors(bool root, std::mt19937* rng,
+                            ActionsAndProbs* priors) {
+  if (root && dirichlet_alpha_ > 0) {
+    std::vector<double> noise =
+        dirichlet_noise(priors->size(), dirichlet_alpha_, rng);
+    for (int i = 0; i < priors->size(); i++) {
+      (*priors)[i].second = (1 - dirichlet_epsilon_) * (*priors)[i].second +
+                            dirichlet_epsilon_ * noise[i];
+    }
+  }
+  // Reduce bias from move generation order.
+  std::shuffle(priors->begin(), priors->end(), *rng);
+}
+
+bool MCTSBot::ExpandLocked(SearchNode* node, const State& state,
+                           const ActionsAndProbs& priors) {
+  if (node->num_children > 0) return false;
+  const Player player = state.CurrentPlayer();
+  SearchNode* children = NewNodes(priors.size());
+  for (int i = 0; i < priors.size(); ++i) {
+    children[i] = SearchNode(priors[i].first, player, priors[i].second);
+  }
+  node->first_child = children;
+  node->num_children = priors.size();
+  nodes_ += priors.size();
+  if (transpositions_.enabled()) {
+    absl::MutexLockMaybe lock(num_threads_ > 1 ? &transpositions_mutex_
+                                               : nullptr);
+    transpositions_.Insert(state.HashValue(), state.MoveNumber(), children,
+                           priors.size());
+  }
+  return true;
+}
+
+bool MCTSBot::LinkTransposition(SearchNode* node, const State& state,
+                                MCTSSearchStats* stats) {
+  absl::MutexLockMaybe lock(ChildrenLock(node));
+  // Most nodes on a descent are expanded already, and need no hash.
+  if (node->num_children > 0) return true;
+  const uint64_t hash = state.HashValue();
+  stats->transposition_lookups += 1;
+  absl::MutexLockMaybe table_lock(num_threads_ > 1 ? &transpositions_mutex_
+                                                   : nullptr);
+  const MCTSTranspositionTable::Entry* entry =
+      transpositions_.Find(hash, state.MoveNumber());
+  if (entry == nullptr) return false;
+  stats->transposition_hits += 1;
+  node->first_child = entry->children;
+  node->num_children = entry->num_children;
+  return true;
+}
+
+State* MCTSBot::WorkingState(const State& state, State* undo_state,
+                             std::unique_ptr<State>* copy) const {
+  if (use_undo_) return undo_state;
+  *copy = state.Clone();
+  return copy->get();
+}
+
+void MCTSBot::UndoPath(const std::vector<SearchNode*>& visit_path,
+                       State* working_state) const {
+  if (!use_undo_) return;
+  // Each node holds the player who took its action, and the action.
+  for (int i = visit_path.size() - 1; i > 0; --i) {
+    working_state->UndoAction(visit_path[i]->player, visit_path[i]->action);
+  }
+}
+
+void MCTSBot::ApplyTreePolicy(SearchNode* root, State* working_state,
+                              std::vector<SearchNode*>* visit_path,
+                              std::mt19937* rng, ThreadStats* thread) {
+  // With several threads or batches, every node on the path takes a virtual
+  // loss as it is entered, and the backup turns it into the real result.
   visit_path->push_back(root);
-  std::unique_ptr<State> working_state = state.Clone();
   SearchNode* current_node = root;
-  while (!working_state->IsTerminal() && current_node->explore_count > 0) {
-    if (current_node->children.empty()) {
+  int explore_count;
+  {
+    absl::MutexLockMaybe lock(StatsLock(nullptr));
+    explore_count = root->explore_count;
+    if (virtual_loss_) {
+      root->explore_count += 1;
+      root->total_reward += min_utility_;
+    }
+  }
+  while (!working_state->IsTerminal()) {
+    bool expanded;
+    if (transpositions_.enabled()) {
+      // A new node whose position was expanded elsewhere takes the children
+      // of that node, and the descent goes on below them.
+      expanded =
+          LinkTransposition(current_node, *working_state, &thread->stats);
+      if (!expanded && explore_count == 0) break;
+    } else {
+      if (explore_count == 0) break;
+      absl::MutexLockMaybe lock(ChildrenLock(current_node));
+      expanded = current_node->num_children > 0;
+    }
+    // Batched searches expand a leaf when its evaluation arrives, so a visited
+    // node without children is still waiting for it (or lost its children to
+    // garbage collection), and is a leaf again.
+    if (!expanded && batch_size_ > 1) break;
+    ActionsAndProbs legal_actions;
+    if (!expanded) {
       // For a new node, initialize its state, then choose a child as normal.
-      ActionsAndProbs legal_actions = evaluator_->Prior(*working_state);
-      if (current_node == root && dirichlet_alpha_ > 0) {
-        std::vector<double> noise =
-            dirichlet_noise(legal_actions.size(), dirichlet_alpha_, &rng_);
-        for (int i = 0; i < legal_actions.size(); i++) {
-          legal_actions[i].second =
-              (1 - dirichlet_epsilon_) * legal_actions[i].second +
-              dirichlet_epsilon_ * noise[i];
-        }
-      }
-      // Reduce bias from move generation order.
-      std::shuffle(legal_actions.begin(), legal_actions.end(), rng_);
-      Player player = working_state->CurrentPlayer();
-      current_node->children.reserve(legal_actions.size());
-      for (auto [action, prior] : legal_actions) {
-        current_node->children.emplace_back(action, player, prior);
-      }
-      nodes_ += current_node->children.capacity();
+      thread->Lap(&thread->stats.selection_seconds);
+      legal_actions = evaluator_->Prior(*working_state);
+      thread->stats.evaluator_calls += 1;
+      PreparePriors(current_node == root, rng, &legal_actions);
     }
-
-    SearchNode* chosen_child = nullptr;
+    Action chance_action = kInvalidAction;
     if (working_state->IsChanceNode()) {
       // For chance nodes, rollout according to chance node's probability
       // distribution
-      Action chosen_action =
-          SampleAction(working_state->ChanceOutcomes(), rng_).first;
+      chance_action = SampleAction(working_state->ChanceOutcomes(), *rng).first;
+    }
 
-      for (SearchNode& child : current_node->children) {
-        if (child.action == chosen_action) {
-          chosen_child = &child;
-          break;
-        }
+    if (!expanded) {
+      bool created;
+      {
+        absl::MutexLockMaybe lock(ChildrenLock(current_node));
+        // Another thread may have expanded the node in the meantime.
+        created = ExpandLocked(current_node, *working_state, legal_actions);
       }
-    } else {
-      // Otherwise choose node with largest UCT value.
-      double max_value = -std::numeric_limits<double>::infinity();
-      for (SearchNode& child : current_node->children) {
-        double val;
-        switch (child_selection_policy_) {
-          case ChildSelectionPolicy::UCT:
-            val = child.UCTValue(current_node->explore_count, uct_c_);
-            break;
-          case ChildSelectionPolicy::PUCT:
-            val = child.PUCTValue(current_node->explore_count, uct_c_);
+      if (created) {
+        thread->stats.expansions += 1;
+        thread->stats.expanded_children += legal_actions.size();
+      }
+      thread->Lap(&thread->stats.expansion_seconds);
+    }
+
+    SearchNode* chosen_child = nullptr;
+    {
+      absl::MutexLockMaybe lock(StatsLock(current_node));
+      if (working_state->IsChanceNode()) {
+        for (SearchNode& child : current_node->children()) {
+          if (child.action == chance_action) {
+            chosen_child = &child;
             break;
+          }
         }
-        if (val > max_value) {
-          max_value = val;
-          chosen_child = &child;
+      } else {
+        // Otherwise choose node with largest UCT value. The parent's count is
+        // the one read when it was chosen, plus this simulation's visit. A node
+        // that took a transposition's children may not have been visited.
+        const int parent_explore_count =
+            std::max(explore_count + int{virtual_loss_}, 1);
+        double max_value = -std::numeric_limits<double>::infinity();
+        for (SearchNode& child : current_node->children()) {
+          double val;
+          switch (child_selection_policy_) {
+            case ChildSelectionPolicy::UCT:
+              val = child.UCTValue(parent_explore_count, uct_c_);
+              break;
+            case ChildSelectionPolicy::PUCT:
+              val = child.PUCTValue(parent_explore_count, uct_c_);
+              break;
+          }
+          if (val > max_value) {
+            max_value = val;
+            chosen_child = &child;
+          }
         }
       }
+      explore_count = chosen_child->explore_count;
+      if (virtual_loss_) {
+        chosen_child->explore_count += 1;
+        chosen_child->total_reward += min_utility_;
+      }
     }
 
     working_state->ApplyAction(chosen_child->action);
     current_node = chosen_child;
     visit_path->push_back(current_node);
   }
-
-  return working_state;
 }
 
-std::unique_ptr<SearchNode> MCTSBot::MCTSearch(const State& state) {
-  Player player_id = state.CurrentPlayer();
-  nodes_ = 1;
-  gc_limit_ = MIN_GC_LIMIT;
-  auto root = std::make_unique<SearchNode>(kInvalidAction, player_id, 1);
-  std::vector<SearchNode*> visit_path;
-  std::vector<double> returns;
-  visit_path.reserve(64);
-  for (int i = 0; i < max_simulations_; ++i) {
-    visit_path.clear();
-    returns.clear();
-
-    std::unique_ptr<State> working_state =
-        ApplyTreePolicy(root.get(), state, &visit_path);
-
-    bool solved;
-    if (working_state->IsTerminal()) {
-      returns = working_state->Returns();
-      visit_path[visit_path.size() - 1]->outcome = returns;
-      solved = solve_;
-    } else {
-      returns = evaluator_->Evaluate(*working_state);
-      solved = false;
-    }
-
-    // Propagate values back.
-    for (auto it = visit_path.rbegin(); it != visit_path.rend(); ++it) {
-      SearchNode* node = *it;
+std::vector<double> MCTSBot::SolveLeaf(
+    const State& terminal_state, const std::vector<SearchNode*>& visit_path) {
+  std::vector<double> returns = terminal_state.Returns();
+  absl::MutexLockMaybe lock(StatsLock(
+      visit_path.size() > 1 ? visit_path[visit_path.size() - 2] : nullptr));
+  SearchNode* leaf = visit_path[visit_path.size() - 1];
+  if (!leaf->solved()) {
+    leaf->outcome_values = NewOutcome(returns);
+    leaf->outcome_size = returns.size();
+  }
+  return returns;
+}
 
-      node->total_reward +=
-          returns[node->player == kChancePlayerId ? player_id : node->player];
-      node->explore_count += 1;
+void MCTSBot::Backpropagate(const std::vector<SearchNode*>& visit_path,
+                            const std::vector<double>& returns,
+                            Player player_id, bool solved) {
+  for (int i = visit_path.size() - 1; i >= 0; --i) {
+    SearchNode* node = visit_path[i];
 
-      // Back up solved results as well.
-      if (solved && !node->children.empty()) {
-        Player player = node->children[0].player;
+    // Back up solved results as well. Outcomes never change once set, so
+    // the node shares the array of the child that solves it, which is read
+    // under the children's lock.
+    const double* outcome_values = nullptr;
+    int outcome_size = 0;
+    if (solved) {
+      const SearchNode* solved_by = nullptr;
+      absl::MutexLockMaybe lock(ChildrenLock(node));
+      absl::MutexLockMaybe stats_lock(StatsLock(node));
+      if (node->num_children > 0) {
+        Player player = node->first_child[0].player;
         if (player == kChancePlayerId) {
           // Only back up chance nodes if all have the same outcome.
           // An alternative would be to back up the weighted average of
           // outcomes if all children are solved, but that is less clear.
-          const std::vector<double>& outcome = node->children[0].outcome;
-          if (!outcome.empty() &&
-              std::all_of(node->children.begin() + 1, node->children.end(),
-                          [&outcome](const SearchNode& c) {
-                            return c.outcome == outcome;
+          const SearchNode& first = node->first_child[0];
+          absl::Span<const SearchNode> children = node->children();
+          if (first.solved() &&
+              std::all_of(children.begin() + 1, children.end(),
+                          [&first](const SearchNode& c) {
+                            return c.outcome() == first.outcome();
                           })) {
-            node->outcome = outcome;
+            solved_by = &first;
           } else {
             solved = false;
           }
@@ -377,69 +1051,451 @@ std::unique_ptr<SearchNode> MCTSBot::MCTSearch(const State& state) {
           // choose the one best for the player choosing.
           const SearchNode* best = nullptr;
           bool all_solved = true;
-          for (const SearchNode& child : node->children) {
-            if (child.outcome.empty()) {
+          for (const SearchNode& child : node->children()) {
+            if (!child.solved()) {
               all_solved = false;
-            } else if (best == nullptr ||
-                       child.outcome[player] > best->outcome[player]) {
+            } else if (best == nullptr || child.outcome_values[player] >
+                                              best->outcome_values[player]) {
               best = &child;
             }
           }
           if (best != nullptr &&
-              (all_solved || best->outcome[player] == max_utility_)) {
-            node->outcome = best->outcome;
+              (all_solved || best->outcome_values[player] == max_utility_)) {
+            solved_by = best;
           } else {
             solved = false;
           }
         }
       }
+      if (solved_by != nullptr) {
+        outcome_values = solved_by->outcome_values;
+        outcome_size = solved_by->outcome_size;
+      }
     }
 
-    if (!root->outcome.empty() ||  // Full game tree is solved.
-        root->children.size() == 1) {
-      break;
+    absl::MutexLockMaybe lock(StatsLock(i > 0 ? visit_path[i - 1] : nullptr));
+    node->total_reward +=
+        returns[node->player == kChancePlayerId ? player_id : node->player];
+    if (virtual_loss_) {
+      node->total_reward -= min_utility_;
+    } else {
+      node->explore_count += 1;
+    }
+    if (outcome_values != nullptr) {
+      node->outcome_values = outcome_values;
+      node->outcome_size = outcome_size;
+    }
+  }
+}
+
+void MCTSBot::RevertVirtualLoss(const std::vector<SearchNode*>& visit_path) {
+  for (int i = 0; i < visit_path.size(); ++i) {
+    absl::MutexLockMaybe lock(StatsLock(i > 0 ? visit_path[i - 1] : nullptr));
+    visit_path[i]->explore_count -= 1;
+    visit_path[i]->total_reward -= min_utility_;
+  }
+}
+
+SearchStopReason MCTSBot::RootDone(const SearchNode* root) const {
+  {
+    absl::MutexLockMaybe lock(StatsLock(nullptr));
+    // Full game tree is solved.
+    if (root->solved()) return SearchStopReason::kSolved;
+  }
+  absl::MutexLockMaybe lock(ChildrenLock(root));
+  return root->num_children == 1 ? SearchStopReason::kSingleAction
+                                 : SearchStopReason::kNone;
+}
+
+bool MCTSBot::RootDecided(const SearchNode* root, int64_t remaining) const {
+  absl::MutexLockMaybe children_lock(ChildrenLock(root));
+  if (root->num_children < 2) return false;
+  absl::MutexLockMaybe stats_lock(StatsLock(root));
+  const SearchNode* most = nullptr;
+  int second = 0;
+  for (const SearchNode& child : root->children()) {
+    if (most == nullptr || child.explore_count > most->explore_count) {
+      if (most != nullptr) second = most->explore_count;
+      most = &child;
+    } else {
+      second = std::max(second, child.explore_count);
+    }
+  }
+  // A solved child may still be picked over the most visited one.
+  return &root->BestChild() == most &&
+         most->explore_count - second > remaining;
+}
+
+bool MCTSBot::CheckStop(const SearchNode* root, bool check_decided,
+                        SearchBudget* budget) const {
+  SearchStopReason reason = RootDone(root);
+  if (reason == SearchStopReason::kNone && check_decided && stop_early_) {
+    const int64_t remaining = budget->RemainingSimulations();
+    if (remaining > 0 && RootDecided(root, remaining)) {
+      reason = SearchStopReason::kDecided;
+    }
+  }
+  if (reason == SearchStopReason::kNone) return false;
+  budget->Stop(reason);
+  return true;
+}
+
+void MCTSBot::MaybeGarbageCollect(int simulations, ThreadStats* thread) {
+  if (max_memory_ == 0 || MemoryUsed() < max_memory_) return;
+  absl::MutexLockMaybe gc_lock(num_threads_ > 1 ? &tree_mutex_ : nullptr);
+  // Another thread may have collected already.
+  if (arena_.bytes_used() < max_memory_) return;
+  if (verbose_) {
+    std::cerr << absl::StrFormat(
+        ("%.1f mb in %d nodes after %d sims, garbage collecting with "
+         "limit %d ... "),
+        MemoryUsedMb(arena_.bytes_used()), nodes_.load(),
+        simulations, gc_limit_);
+  }
+  const int nodes_before = nodes_;
+  const absl::Time start = absl::Now();
+  GarbageCollect();
+  thread->stats.gc_seconds += absl::ToDoubleSeconds(absl::Now() - start);
+  thread->stats.gc_passes += 1;
+  thread->stats.gc_nodes_freed += nodes_before - nodes_;
+
+  // Slowly increase or decrease to target releasing half the memory.
+  gc_limit_ *= (arena_.bytes_used() > max_memory_ / 2 ? 1.25 : 0.9);
+  gc_limit_ = std::max(MIN_GC_LIMIT, gc_limit_);
+  if (verbose_) {
+    std::cerr << absl::StrFormat("%.1f mb in %d nodes remaining\n",
+                                 MemoryUsedMb(arena_.bytes_used()),
+                                 nodes_.load());
+  }
+}
+
+void MCTSBot::RunSimulations(const State& state, SearchBudget* budget,
+                             std::mt19937* rng, ThreadStats* thread) {
+  const Player player_id = state.CurrentPlayer();
+  std::vector<SearchNode*> visit_path;
+  visit_path.reserve(64);
+  std::unique_ptr<State> undo_state = use_undo_ ? state.Clone() : nullptr;
+  std::unique_ptr<State> copy;
+  int since_check = 0;
+  while (budget->Claim()) {
+    thread->StartSimulation();
+    visit_path.clear();
+    if (num_threads_ > 1) tree_mutex_.ReaderLock();
+    // Garbage collection moves the root, so it is only read under the lock.
+    SearchNode* root = root_;
+
+    State* working_state = WorkingState(state, undo_state.get(), &copy);
+    ApplyTreePolicy(root, working_state, &visit_path, rng, thread);
+    thread->Lap(&thread->stats.selection_seconds);
+    thread->AddDepth(visit_path.size() - 1);
+
+    const bool terminal = working_state->IsTerminal();
+    std::vector<double> returns;
+    if (terminal) {
+      returns = SolveLeaf(*working_state, visit_path);
+    } else {
+      thread->stats.evaluator_calls += 1;
+      returns = use_undo_ ? evaluator_->EvaluateInPlace(working_state, rng)
+                          : evaluator_->Evaluate(*working_state, rng);
     }
-    if (max_nodes_ > 1 && nodes_ >= max_nodes_) {
-      // Note that actual memory used as counted by ps/top might exceed the
-      // counted value here, possibly by a significant margin (1.5x even!). Part
-      // of that is not counting the outcome array, but most of that is due to
-      // memory fragmentation and is out of our control without writing our own
-      // memory manager.
-      if (verbose_) {
-        std::cerr << absl::StrFormat(
-            ("Approx %d mb in %d nodes after %d sims, garbage collecting with "
-             "limit %d ... "),
-            MemoryUsedMb(nodes_), nodes_, i, gc_limit_);
+    thread->Lap(&thread->stats.evaluation_seconds);
+
+    Backpropagate(visit_path, returns, player_id, terminal && solve_);
+    UndoPath(visit_path, working_state);
+    const bool check_decided = ++since_check == SearchBudget::kCheckInterval;
+    if (check_decided) since_check = 0;
+    const bool done = CheckStop(root, check_decided, budget);
+    if (num_threads_ > 1) tree_mutex_.ReaderUnlock();
+    thread->Lap(&thread->stats.backpropagation_seconds);
+
+    if (done) break;
+    MaybeGarbageCollect(budget->simulations(), thread);
+  }
+}
+
+void MCTSBot::RunBatchedSimulations(const State& state, SearchBudget* budget,
+                                    std::mt19937* rng, ThreadStats* thread) {
+  const Player player_id = state.CurrentPlayer();
+  std::vector<std::vector<SearchNode*>> visit_paths;
+  std::vector<std::unique_ptr<State>> leaves;
+  std::vector<const State*> batch;
+  std::unique_ptr<State> undo_state = use_undo_ ? state.Clone() : nullptr;
+  int since_check = 0;
+  bool done = false;
+  while (!done) {
+    thread->StartSimulation();
+    visit_paths.clear();
+    leaves.clear();
+    batch.clear();
+    if (num_threads_ > 1) tree_mutex_.ReaderLock();
+    SearchNode* root = root_;
+
+    // Descend up to batch_size_ times. Terminal leaves need no evaluation, so
+    // they are backed up straight away.
+    while (visit_paths.size() < batch_size_) {
+      if (!budget->Claim()) {
+        done = true;
+        break;
       }
-      GarbageCollect(root.get());
-
-      // Slowly increase or decrease to target releasing half the memory.
-      gc_limit_ *= (nodes_ > max_nodes_ / 2 ? 1.25 : 0.9);
-      gc_limit_ = std::max(MIN_GC_LIMIT, gc_limit_);
-      if (verbose_) {
-        std::cerr << absl::StrFormat(
-            "%d mb in %d nodes remaining\n",
-            MemoryUsedMb(nodes_), nodes_);
+      ++since_check;
+      std::vector<SearchNode*> visit_path;
+      std::unique_ptr<State> copy;
+      State* working_state = WorkingState(state, undo_state.get(), &copy);
+      ApplyTreePolicy(root, working_state, &visit_path, rng, thread);
+      thread->Lap(&thread->stats.selection_seconds);
+      if (working_state->IsTerminal()) {
+        thread->AddDepth(visit_path.size() - 1);
+        std::vector<double> returns = SolveLeaf(*working_state, visit_path);
+        thread->Lap(&thread->stats.evaluation_seconds);
+        Backpropagate(visit_path, returns, player_id, solve_);
+        UndoPath(visit_path, working_state);
+        thread->Lap(&thread->stats.backpropagation_seconds);
+        if (RootDone(root) != SearchStopReason::kNone) break;
+        continue;
       }
+      // Reaching a leaf that is already in the batch ends the round, and the
+      // simulation is taken back rather than evaluating the leaf twice.
+      if (absl::c_any_of(visit_paths, [&](const std::vector<SearchNode*>& p) {
+            return p.back() == visit_path.back();
+          })) {
+        RevertVirtualLoss(visit_path);
+        UndoPath(visit_path, working_state);
+        thread->Lap(&thread->stats.backpropagation_seconds);
+        budget->Unclaim();
+        --since_check;
+        break;
+      }
+      // The leaves of a batch are evaluated together, so each needs a state of
+      // its own.
+      thread->AddDepth(visit_path.size() - 1);
+      leaves.push_back(use_undo_ ? working_state->Clone() : std::move(copy));
+      UndoPath(visit_path, working_state);
+      visit_paths.push_back(std::move(visit_path));
+      thread->Lap(&thread->stats.evaluation_seconds);
     }
+
+    if (!leaves.empty()) {
+      for (const std::unique_ptr<State>& leaf : leaves) {
+        batch.push_back(leaf.get());
+      }
+      std::vector<Evaluator::Evaluation> evaluations =
+          evaluator_->EvaluateBatch(batch, rng);
+      thread->stats.evaluator_calls += batch.size();
+      thread->stats.evaluator_batches += 1;
+      SPIEL_CHECK_EQ(evaluations.size(), batch.size());
+      thread->Lap(&thread->stats.evaluation_seconds);
+      for (int i = 0; i < leaves.size(); ++i) {
+        SearchNode* leaf = visit_paths[i].back();
+        PreparePriors(leaf == root, rng, &evaluations[i].prior);
+        bool created;
+        {
+          absl::MutexLockMaybe lock(ChildrenLock(leaf));
+          created = ExpandLocked(leaf, *leaves[i], evaluations[i].prior);
+        }
+        if (created) {
+          thread->stats.expansions += 1;
+          thread->stats.expanded_children += evaluations[i].prior.size();
+        }
+        thread->Lap(&thread->stats.expansion_seconds);
+        Backpropagate(visit_paths[i], evaluations[i].values, player_id,
+                      /*solved=*/false);
+        thread->Lap(&thread->stats.backpropagation_seconds);
+      }
+    }
+    const bool check_decided = since_check >= SearchBudget::kCheckInterval;
+    if (check_decided) since_check = 0;
+    if (CheckStop(root, check_decided, budget)) done = true;
+    if (num_threads_ > 1) tree_mutex_.ReaderUnlock();
+    thread->Lap(&thread->stats.backpropagation_seconds);
+
+    if (!done) MaybeGarbageCollect(budget->simulations(), thread);
   }
+}
 
-  return root;
+const SearchNode* MCTSBot::MCTSearch(const State& state) {
+  const absl::Time start = absl::Now();
+  NewTree(state);
+  Search(state, start);
+  return root_;
 }
 
-void MCTSBot::GarbageCollect(SearchNode* node) {
-  if (node->children.empty()) {
-    return;
+void MCTSBot::Search(const State& state, absl::Time start) {
+  gc_limit_ = MIN_GC_LIMIT;
+  stats_ = MCTSSearchStats();
+  stats_.reused_nodes = nodes_;
+  absl::Time deadline = deadline_;
+  if (max_time_ms_ > 0) {
+    deadline = std::min(deadline, start + absl::Milliseconds(max_time_ms_));
   }
-  bool clear_children = node->explore_count < gc_limit_;
-  for (SearchNode& child : node->children) {
-    GarbageCollect(&child);
+  deadline_ = absl::InfiniteFuture();
+  SearchBudget budget(max_simulations_, deadline);
+
+  // The calling thread is one of the search threads, and keeps using rng_ so
+  // that single-threaded searches are reproducible.
+  std::vector<std::mt19937> rngs;
+  for (int i = 1; i < num_threads_; ++i) rngs.emplace_back(rng_());
+  std::vector<ThreadStats> thread_stats(num_threads_);
+  std::vector<Thread> threads;
+  threads.reserve(num_threads_ - 1);
+  auto run = [&](std::mt19937* rng, ThreadStats* thread) {
+    if (batch_size_ > 1) {
+      RunBatchedSimulations(state, &budget, rng, thread);
+    } else {
+      RunSimulations(state, &budget, rng, thread);
+    }
+  };
+  for (int i = 1; i < num_threads_; ++i) {
+    threads.emplace_back([&, i]() { run(&rngs[i - 1], &thread_stats[i]); });
   }
-  if (clear_children) {
-    nodes_ -= node->children.capacity();
-    node->children.clear();
-    node->children.shrink_to_fit();  // release the memory
+  run(&rng_, &thread_stats[0]);
+  for (Thread& thread : threads) thread.join();
+
+  for (const ThreadStats& thread : thread_stats) stats_.Merge(thread.stats);
+  stats_.simulations = budget.simulations();
+  stats_.stop_reason = budget.stop_reason();
+  stats_.wall_seconds = absl::ToDoubleSeconds(absl::Now() - start);
+  stats_.tree_nodes = nodes_;
+  stats_.tree_bytes = arena_.bytes_used();
+  stats_.new_nodes = stats_.expanded_children;
+}
+
+SearchNode* MCTSBot::NewNodes(int count) {
+  absl::MutexLockMaybe lock(num_threads_ > 1 ? &arena_mutex_ : nullptr);
+  return arena_.NewNodes(count);
+}
+
+const double* MCTSBot::NewOutcome(absl::Span<const double> outcome) {
+  absl::MutexLockMaybe lock(num_threads_ > 1 ? &arena_mutex_ : nullptr);
+  return arena_.NewOutcome(outcome);
+}
+
+int64_t MCTSBot::MemoryUsed() {
+  absl::MutexLockMaybe lock(num_threads_ > 1 ? &arena_mutex_ : nullptr);
+  return arena_.bytes_used();
+}
+
+void MCTSBot::GarbageCollect() { Rebuild(*root_, gc_limit_); }
+
+void MCTSBot::Rebuild(const SearchNode& node, int min_explore_count) {
+  SearchNodeArena compacted;
+  SearchNode* root = compacted.NewNodes(1);
+  if (transpositions_.enabled()) {
+    absl::flat_hash_map<const SearchNode*, SearchNode*> copies;
+    nodes_ = 1 + CopyTree(node, min_explore_count, &compacted, root, &copies);
+    transpositions_.Remap(copies);
+  } else {
+    nodes_ = 1 + CopyTree(node, min_explore_count, &compacted, root, nullptr);
+  }
+  // Threads outside the tree lock may still be checking MemoryUsed().
+  absl::MutexLockMaybe lock(num_threads_ > 1 ? &arena_mutex_ : nullptr);
+  arena_ = std::move(compacted);
+  root_ = root;
+}
+
+RootParallelMCTSBot::RootParallelMCTSBot(
+    const Game& game, std::shared_ptr<Evaluator> evaluator, double uct_c,
+    int max_simulations, int64_t max_memory_mb, bool solve, int seed,
+    bool verbose, int num_searches,
+    ChildSelectionPolicy child_selection_policy, double dirichlet_alpha,
+    double dirichlet_epsilon, int64_t max_time_ms)
+    : verbose_(verbose) {
+  SPIEL_CHECK_GE(num_searches, 1);
+  for (int i = 0; i < num_searches; ++i) {
+    searches_.push_back(std::make_unique<MCTSBot>(
+        game, evaluator, uct_c, max_simulations, max_memory_mb, solve,
+        seed + i, /*verbose=*/false, child_selection_policy, dirichlet_alpha,
+        dirichlet_epsilon, /*num_threads=*/1, /*batch_size=*/1,
+        /*transposition_table_size=*/0, /*use_undo=*/true, max_time_ms));
+  }
+  if (num_searches > 1) {
+    pool_ = std::make_unique<ThreadPool>(num_searches - 1);
+  }
+}
+
+void RootParallelMCTSBot::Restart() {
+  for (auto& search : searches_) search->Restart();
+}
+
+void RootParallelMCTSBot::RestartAt(const State& state) {
+  for (auto& search : searches_) search->RestartAt(state);
+}
+
+void RootParallelMCTSBot::InformAction(const State& state, Player player_id,
+                                       Action action) {
+  for (auto& search : searches_) {
+    search->InformAction(state, player_id, action);
+  }
+}
+
+void RootParallelMCTSBot::SetDeadline(absl::Time deadline) {
+  for (auto& search : searches_) search->SetDeadline(deadline);
+}
+
+Action RootParallelMCTSBot::Step(const State& state) {
+  absl::Time start = absl::Now();
+  std::vector<const SearchNode*> roots(searches_.size());
+  auto search = [&](int i) { roots[i] = searches_[i]->ContinueSearch(state); };
+  if (pool_ != nullptr) {
+    pool_->ParallelFor(searches_.size(), search);
+  } else {
+    search(0);
+  }
+
+  // The children of the roots, summed per action. The searches may have
+  // shuffled them differently. Outcomes point into the searches' trees, which
+  // stay put until they are moved below.
+  SearchNode root(kInvalidAction, state.CurrentPlayer(), 1);
+  std::vector<SearchNode> children;
+  absl::flat_hash_map<Action, int> index;
+  stats_ = MCTSSearchStats();
+  for (int i = 0; i < searches_.size(); ++i) {
+    stats_.Merge(searches_[i]->search_stats());
+    root.explore_count += roots[i]->explore_count;
+    root.total_reward += roots[i]->total_reward;
+    for (const SearchNode& child : roots[i]->children()) {
+      auto [it, inserted] = index.emplace(child.action, children.size());
+      if (inserted) {
+        children.push_back(child);
+        children.back().first_child = nullptr;
+        children.back().num_children = 0;
+        continue;
+      }
+      SearchNode& sum = children[it->second];
+      sum.explore_count += child.explore_count;
+      sum.total_reward += child.total_reward;
+      if (!sum.solved() && child.solved()) {
+        sum.outcome_values = child.outcome_values;
+        sum.outcome_size = child.outcome_size;
+      }
+    }
+  }
+  SPIEL_CHECK_FALSE(children.empty());
+  root.first_child = children.data();
+  root.num_children = children.size();
+  const Action action = root.BestChild().action;
+
+  if (verbose_) {
+    double seconds = absl::ToDoubleSeconds(absl::Now() - start);
+    std::cerr << absl::StrFormat(
+                     "Finished %d sims in %d searches in %.3f secs, "
+                     "%.1f sims/s.",
+                     stats_.simulations, searches_.size(), seconds,
+                     stats_.simulations / seconds)
+              << std::endl;
+    std::cerr << "Merged root:" << std::endl;
+    std::cerr << root.ToString(state) << std::endl;
+    std::cerr << "Children:" << std::endl;
+    std::cerr << root.ChildrenStr(state) << std::endl;
   }
+
+  InformAction(state, state.CurrentPlayer(), action);
+  return action;
+}
+
+std::pair<ActionsAndProbs, Action> RootParallelMCTSBot::StepWithPolicy(
+    const State& state) {
+  Action action = Step(state);
+  return {{{action, 1.}}, action};
 }
 
 }  // namespace algorithms
@@ -17,14 +17,23 @@
 
 #include <stdint.h>
 
+#include <atomic>
+#include <chrono>  // NOLINT
 #include <memory>
 #include <random>
 #include <string>
+#include <thread>  // NOLINT
 #include <utility>
 #include <vector>
 
+#include "open_spiel/abseil-cpp/absl/container/flat_hash_map.h"
+#include "open_spiel/abseil-cpp/absl/synchronization/mutex.h"
+#include "open_spiel/abseil-cpp/absl/time/time.h"
+#include "open_spiel/abseil-cpp/absl/types/span.h"
 #include "open_spiel/spiel.h"
 #include "open_spiel/spiel_bots.h"
+#include "open_spiel/utils/json.h"
+#include "open_spiel/utils/thread.h"
 
 // A vanilla Monte Carlo Tree Search algorithm.
 //
@@ -43,6 +52,52 @@
 // At the end of the search, the chosen action is the action that has been
 // explored most often. This is the action that is returned.
 //
+// MCTSBot keeps its tree between moves: after Step() the root moves to the
+// chosen child, and the actions reported through InformAction() (or found in
+// the history of the next state passed to Step()) move it further, so each
+// search starts with the statistics gathered below the new position.
+//
+// With num_threads > 1 the simulations run on that many threads sharing one
+// tree (tree parallelism). A simulation counts as a loss (a visit with
+// Game::MinUtility()) for every node on its path until it is backed up, so
+// that concurrent simulations spread over different branches (virtual loss).
+// The children of a node are created under a lock picked by the node's
+// address, and their statistics are guarded by a lock picked by the address of
+// the children, so threads only contend on the nodes they share.
+//
+// With batch_size > 1 each search thread descends batch_size times, again with
+// virtual losses, and evaluates the leaves it reached with a single call to
+// Evaluator::EvaluateBatch(). Each leaf is expanded with the priors returned
+// for it. A model-based evaluator then sees full batches without needing
+// several threads to fill them.
+//
+// Each simulation starts from a copy of the searched state, except in games
+// whose GameType::provides_undo is set: then every search thread keeps one
+// working state, plays each simulation on it and takes the moves back with
+// State::UndoAction(), and the evaluator may do the same for its rollouts.
+//
+// A search runs max_simulations, or until max_time_ms have passed since Step()
+// was called or the deadline given to SetDeadline() is reached, whichever comes
+// first; with a time limit max_simulations may be 0 for no simulation limit.
+// The clock is read once every SearchBudget::kCheckInterval simulations. It
+// also stops once the root is solved or has a single child, and with
+// stop_early once the most visited child leads the others by more visits than
+// the remaining simulations could give them. The remaining simulations under
+// a time limit are estimated from the rate so far.
+//
+// With transposition_table_size > 0 the search shares statistics between the
+// move orders that reach the same position. Expanded positions are entered in
+// an MCTSTranspositionTable under State::HashValue() and State::MoveNumber(),
+// and a node reaching a position that is in the table takes the children of
+// the node first expanded there instead of evaluating it again, so the tree
+// becomes a directed acyclic graph. This assumes that the hash identifies the
+// position, and that positions with equal hashes at the same move number
+// continue the same way. Games with draws by repetition, such as battle_chess,
+// break that assumption: a child may be a repetition draw along one history
+// and not along another. So a proven outcome found below a shared node would
+// not hold for all the nodes sharing it, and solve cannot be combined with a
+// transposition table.
+//
 // This implementation supports sequential n-player games, with or without
 // chance nodes. All players maximize their own reward and ignore the other
 // players' rewards. This corresponds to max^n for n-player games. It is the
@@ -76,55 +131,244 @@ enum class ChildSelectionPolicy {
   PUCT,
 };
 
+// Why a search stopped.
+enum class SearchStopReason {
+  kNone,          // The search has not stopped.
+  kSimulations,   // It ran all of its simulations.
+  kTime,          // It reached its time limit or deadline.
+  kSolved,        // The root was solved.
+  kSingleAction,  // The root has a single action.
+  kDecided,       // The best action could not be overtaken any more.
+};
+
+std::string SearchStopReasonToString(SearchStopReason reason);
+
+// The simulations and time left to a search, shared by its search threads.
+class SearchBudget {
+ public:
+  // How many simulations run between the checks of the clock, and of whether
+  // the best action is decided.
+  static constexpr int kCheckInterval = 16;
+
+  // A max_simulations <= 0 does not limit the simulations, if there is a
+  // deadline. Pass absl::InfiniteFuture() for no deadline. The first
+  // simulation is never refused for lack of time.
+  SearchBudget(int max_simulations, absl::Time deadline);
+
+  // Takes one simulation from the budget. Returns false once the search has
+  // stopped, or there is no budget left.
+  bool Claim();
+  // Gives back a simulation that was claimed but not run.
+  void Unclaim();
+
+  // Stops the search for the reason, unless it has stopped already.
+  void Stop(SearchStopReason reason);
+
+  // Simulations claimed so far.
+  int simulations() const { return claimed_; }
+  // An estimate of how many more simulations the search can run: the
+  // simulations left, or those that fit before the deadline at the rate so
+  // far, whichever is fewer.
+  int64_t RemainingSimulations() const;
+  // kSimulations if the budget ran out before anything else stopped it.
+  SearchStopReason stop_reason() const;
+
+ private:
+  const absl::Time start_;
+  const absl::Time deadline_;
+  std::atomic<int> left_;
+  std::atomic<int> claimed_;
+  std::atomic<SearchStopReason> reason_;
+};
+
+// What one MCTS search did, and where its time went.
+//
+// The time of each simulation is split into four phases:
+// - selection: descending the tree from the root to a leaf,
+// - expansion: getting the priors of a node and creating its children,
+// - evaluation: evaluating the leaf, or reading the returns of a terminal one,
+// - backpropagation: backing up the returns, and undoing the moves played.
+// Reading the clock costs about as much as a simulation of a small game, so
+// the phases are timed in one simulation out of kTimingInterval (one round of
+// batched simulations), and scaled up: they are estimates. Garbage collection
+// is rare, and timed on its own every time. The phase times are summed over
+// the search threads, so with several threads they add up to more than
+// wall_seconds.
+struct MCTSSearchStats {
+  static constexpr int kTimingInterval = 16;
+
+  int simulations = 0;
+  SearchStopReason stop_reason = SearchStopReason::kNone;
+  double wall_seconds = 0;
+  double selection_seconds = 0;
+  double expansion_seconds = 0;
+  double evaluation_seconds = 0;
+  double backpropagation_seconds = 0;
+  double gc_seconds = 0;
+
+  // States passed to the evaluator, and calls to EvaluateBatch().
+  int64_t evaluator_calls = 0;
+  int64_t evaluator_batches = 0;
+
+  // The tree after the search, the nodes carried over from earlier moves and
+  // the nodes added by the search.
+  int tree_nodes = 0;
+  int64_t tree_bytes = 0;
+  int reused_nodes = 0;
+  int new_nodes = 0;
+  // Nodes given children, and the children given to them.
+  int64_t expansions = 0;
+  int64_t expanded_children = 0;
+  // Garbage collections, and the nodes they released.
+  int gc_passes = 0;
+  int64_t gc_nodes_freed = 0;
+  int64_t transposition_lookups = 0;
+  int64_t transposition_hits = 0;
+
+  // depth_histogram[d] counts the simulations whose leaf was d moves below
+  // the root.
+  std::vector<int64_t> depth_histogram;
+
+  // The mean number of children of an expanded node.
+  double BranchingFactor() const;
+  double MeanDepth() const;
+  int MaxDepth() const { return static_cast<int>(depth_histogram.size()) - 1; }
+
+  // Adds the counts and times of another thread or search. The wall time is
+  // the longer of the two.
+  void Merge(const MCTSSearchStats& other);
+
+  // A record for DataLogger::Write().
+  json::Object ToJson() const;
+};
+
 // Abstract class representing an evaluation function for a game.
 // The evaluation function takes in an intermediate state in the game and
 // returns an evaluation of that state, which should correlate with chances of
 // winning the game for player 0.
+//
+// An MCTSBot with num_threads > 1 calls its evaluator from several threads at
+// once, so evaluators used that way must be thread-safe.
 class Evaluator {
  public:
+  // The value and prior of one state, as returned by EvaluateBatch().
+  struct Evaluation {
+    std::vector<double> values;
+    ActionsAndProbs prior;
+  };
+
   virtual ~Evaluator() = default;
 
   // Return a value of this state for each player.
   virtual std::vector<double> Evaluate(const State& state) = 0;
 
+  // The same as Evaluate(), for a state that the evaluator may change as long
+  // as it restores it before returning, e.g. by playing moves and undoing
+  // them. The default calls Evaluate().
+  virtual std::vector<double> EvaluateInPlace(State* state);
+
   // Return a policy: the probability of the current player playing each action.
   virtual ActionsAndProbs Prior(const State& state) = 0;
+
+  // Return the value and prior of each state, in order. Evaluators backed by a
+  // model should override this to run one inference for the whole batch; the
+  // default calls Evaluate() and Prior() on each state.
+  virtual std::vector<Evaluation> EvaluateBatch(
+      absl::Span<const State* const> states);
+
+  // As above, for a caller that owns `rng`, the random generator of the
+  // calling thread. MCTSBot passes the generator of each search thread, so
+  // that evaluators drawing from it are reproducible from the bot's seed
+  // whichever threads run the search. The defaults ignore rng.
+  virtual std::vector<double> Evaluate(const State& state, std::mt19937* rng);
+  virtual std::vector<double> EvaluateInPlace(State* state, std::mt19937* rng);
+  virtual std::vector<Evaluation> EvaluateBatch(
+      absl::Span<const State* const> states, std::mt19937* rng);
 };
 
 // A simple evaluator that returns the average outcome of playing random actions
 // from the given state until the end of the game.
 // n_rollouts is the number of random outcomes to be considered.
+//
+// The moves are picked with State::UniformRandomLegalAction() and a
+// Xoshiro256 generator. With num_threads > 1 the rollouts are split into tasks
+// that run on a ThreadPool of num_threads - 1 threads and on the calling
+// thread. Each task draws from a generator seeded for it by the caller, so the
+// result does not depend on which thread runs it. In games that provide undo a
+// task plays its rollouts on one copy of the state (none for a single task in
+// EvaluateInPlace()) and takes each one back with UndoAction().
+//
+// The task seeds are drawn from the caller's generator, mixed with `seed`, or
+// without one from the evaluator's own generator seeded with `seed`, under a
+// lock. It is thread-safe, and reproducible as long as each generator is only
+// used by one thread at a time.
 class RandomRolloutEvaluator : public Evaluator {
  public:
-  explicit RandomRolloutEvaluator(int n_rollouts, int seed)
-      : n_rollouts_(n_rollouts), rng_(seed) {}
+  RandomRolloutEvaluator(int n_rollouts, int seed, int num_threads = 1);
 
   // Runs random games, returning the average returns.
   std::vector<double> Evaluate(const State& state) override;
+  std::vector<double> EvaluateInPlace(State* state) override;
+  std::vector<double> Evaluate(const State& state, std::mt19937* rng) override;
+  std::vector<double> EvaluateInPlace(State* state,
+                                      std::mt19937* rng) override;
+  std::vector<Evaluation> EvaluateBatch(absl::Span<const State* const> states,
+                                        std::mt19937* rng) override;
 
   // Returns equal probability for each action.
   ActionsAndProbs Prior(const State& state) override;
 
  private:
+  // Splits the rollouts into tasks, runs them and returns the average returns.
+  // A single task in a game with undo may play on `working_state` if given.
+  // The task seeds come from rng, or from rng_ if it is nullptr.
+  std::vector<double> RunTasks(const State& state, State* working_state,
+                               std::mt19937* rng);
+
   int n_rollouts_;
-  std::mt19937 rng_;
+  int seed_;
+  absl::Mutex rng_mutex_;
+  std::mt19937 rng_ ABSL_GUARDED_BY(rng_mutex_);
+  int num_tasks_;
+  std::unique_ptr<ThreadPool> pool_;  // nullptr for a single thread.
 };
 
-// A node in the search tree for MCTS
+// A node in the search tree for MCTS.
+//
+// Nodes are allocated from the SearchNodeArena of the MCTSBot that built the
+// tree: the children of a node are one contiguous block, and the outcome of a
+// solved node is an array in the same arena. Statistics are kept in single
+// precision so that a node takes 40 bytes, and a scan over the children in the
+// selection loop touches as few cache lines as possible.
 struct SearchNode {
-  Action action = 0;            // The action taken to get to this node.
-  double prior = 0;             // The prior probability of playing this action.
-  Player player = 0;            // Which player gets to make this action.
-  int explore_count = 0;        // Number of times this node was explored.
-  double total_reward = 0;      // Total reward passing through this node.
-  std::vector<double> outcome;  // The reward if each players plays perfectly.
-  std::vector<SearchNode> children;  // The successors to this state.
+  SearchNode* first_child = nullptr;  // The successors to this state.
+  const double* outcome_values = nullptr;  // Set once the node is solved.
+  int32_t action = 0;        // The action taken to get to this node.
+  float prior = 0;           // The prior probability of playing this action.
+  float total_reward = 0;    // Total reward passing through this node.
+  int explore_count = 0;     // Number of times this node was explored.
+  int num_children = 0;
+  int16_t player = 0;        // Which player gets to make this action.
+  int16_t outcome_size = 0;  // The number of players, once solved.
 
   SearchNode() {}
 
   SearchNode(Action action_, Player player_, double prior_)
       : action(action_), prior(prior_), player(player_) {}
 
+  absl::Span<SearchNode> children() {
+    return absl::MakeSpan(first_child, num_children);
+  }
+  absl::Span<const SearchNode> children() const {
+    return absl::MakeConstSpan(first_child, num_children);
+  }
+
+  // The reward if each players plays perfectly, or empty if not solved.
+  absl::Span<const double> outcome() const {
+    return absl::MakeConstSpan(outcome_values, outcome_size);
+  }
+  bool solved() const { return outcome_values != nullptr; }
+
   // The value as returned by the UCT formula.
   double UCTValue(int parent_explore_count, double uct_c) const;
 
@@ -141,6 +385,72 @@ struct SearchNode {
   std::string ChildrenStr(const State& state) const;
 };
 
+// Hands out the nodes and outcomes of a search tree from large slabs. Nothing
+// is freed individually: Reset() makes all of the memory available again in
+// O(1), and invalidates every node handed out before.
+class SearchNodeArena {
+ public:
+  // Returns `count` contiguous default-constructed nodes.
+  SearchNode* NewNodes(int count);
+
+  // Returns a copy of the outcome, which lives as long as the nodes.
+  const double* NewOutcome(absl::Span<const double> outcome);
+
+  void Reset();
+
+  // The memory handed out since the last Reset(), in bytes.
+  int64_t bytes_used() const { return bytes_used_; }
+
+ private:
+  void* Allocate(int64_t bytes);
+
+  struct Slab {
+    std::unique_ptr<char[]> memory;
+    int64_t size;
+  };
+  std::vector<Slab> slabs_;
+  int slab_ = 0;        // The slab being allocated from.
+  int64_t offset_ = 0;  // The first free byte in it.
+  int64_t bytes_used_ = 0;
+};
+
+// Maps positions to the children of the node that was expanded there, so that
+// other nodes reaching the same position can share them. The table has a fixed
+// number of entries in buckets of kWays. A full bucket gives up its deepest
+// entry, since positions nearer the root head larger subtrees, and keeps all
+// of its entries when the new position is deeper than each of them.
+class MCTSTranspositionTable {
+ public:
+  static constexpr int kWays = 4;
+
+  struct Entry {
+    uint64_t hash = 0;  // State::HashValue() of the position.
+    int move_number = -1;  // State::MoveNumber() of the position.
+    int num_children = 0;
+    SearchNode* children = nullptr;  // nullptr for an empty entry.
+  };
+
+  explicit MCTSTranspositionTable(int size);
+
+  bool enabled() const { return !entries_.empty(); }
+
+  // Returns the entry for the position, or nullptr.
+  const Entry* Find(uint64_t hash, int move_number) const;
+  void Insert(uint64_t hash, int move_number, SearchNode* children,
+              int num_children);
+  void Clear();
+
+  // Points the entries at the copies of their children, as made by CopyTree,
+  // and drops the entries whose children were not copied.
+  void Remap(const absl::flat_hash_map<const SearchNode*, SearchNode*>& copies);
+
+ private:
+  // The index of the first entry in the position's bucket.
+  int BucketStart(uint64_t hash, int move_number) const;
+
+  std::vector<Entry> entries_;
+};
+
 // A SpielBot that uses the MCTS algorithm as its policy.
 class MCTSBot : public Bot {
  public:
@@ -161,12 +471,28 @@ class MCTSBot : public Bot {
       bool solve,             // Whether to back up solved states.
       int seed, bool verbose,
       ChildSelectionPolicy child_selection_policy = ChildSelectionPolicy::UCT,
-      double dirichlet_alpha = 0, double dirichlet_epsilon = 0);
+      double dirichlet_alpha = 0, double dirichlet_epsilon = 0,
+      int num_threads = 1, int batch_size = 1,
+      // Must be 0 with solve, see above.
+      int transposition_table_size = 0,
+      // Whether to play simulations on one state with UndoAction(), in games
+      // that provide undo.
+      bool use_undo = true,
+      // The time limit of each search, or 0 for none.
+      int64_t max_time_ms = 0,
+      // Whether to stop once the best action can't be overtaken.
+      bool stop_early = false);
   ~MCTSBot() = default;
 
-  void Restart() override {}
-  void RestartAt(const State& state) override {}
+  // Drops the retained tree.
+  void Restart() override;
+  // Keeps the part of the retained tree below `state`, if any.
+  void RestartAt(const State& state) override;
+  // Moves the retained tree's root along the action.
+  void InformAction(const State& state, Player player_id,
+                    Action action) override;
   // Run MCTS for one step, choosing the action, and printing some information.
+  // The search continues from the retained tree when it reaches `state`.
   Action Step(const State& state) override;
 
   // Implements StepWithPolicy. This is equivalent to calling Step, but wraps
@@ -175,10 +501,73 @@ class MCTSBot : public Bot {
   std::pair<ActionsAndProbs, Action> StepWithPolicy(
       const State& state) override;
 
-  // Run MCTS on a given state, and return the resulting search tree.
-  std::unique_ptr<SearchNode> MCTSearch(const State& state);
+  // Run MCTS on a given state from a new tree, and return the resulting search
+  // tree. The tree belongs to the bot: it is kept as the retained tree, and
+  // stays valid until the next call that searches or moves it.
+  const SearchNode* MCTSearch(const State& state);
+
+  // Runs the search of Step() without choosing an action, and returns the
+  // root. The root stays at `state` until the next call that moves it, e.g.
+  // InformAction() with the action that is played.
+  const SearchNode* ContinueSearch(const State& state);
+
+  // Makes the next search also stop at the deadline.
+  void SetDeadline(absl::Time deadline) { deadline_ = deadline; }
+
+  // What the last search did.
+  const MCTSSearchStats& search_stats() const { return stats_; }
+
+  // The simulations run by the last search, and why it stopped.
+  int simulations() const { return stats_.simulations; }
+  SearchStopReason stop_reason() const { return stats_.stop_reason; }
+  // Nodes carried over from earlier moves at the start of the last Step().
+  int reused_nodes() const { return stats_.reused_nodes; }
+  // Nodes added by the last search.
+  int new_nodes() const { return stats_.new_nodes; }
+  // Positions looked up in the transposition table by the last search, and
+  // how many of them were found.
+  int64_t transposition_lookups() const {
+    return stats_.transposition_lookups;
+  }
+  int64_t transposition_hits() const { return stats_.transposition_hits; }
+  // States passed to Evaluate(), Prior() or EvaluateBatch() by the last search.
+  int64_t evaluator_calls() const { return stats_.evaluator_calls; }
 
  private:
+  // The statistics gathered by one search thread, merged into stats_ once the
+  // search is over, and the clock it charges the phases of its simulations to.
+  struct ThreadStats {
+    MCTSSearchStats stats;
+    int64_t simulations = 0;
+    bool timed = false;  // Whether the current simulation is timed.
+    std::chrono::steady_clock::time_point lap_start;
+
+    // Starts a simulation, or a round of them, which is timed once every
+    // MCTSSearchStats::kTimingInterval.
+    void StartSimulation();
+    // Adds the time since the last lap, scaled up, to the phase if the current
+    // simulation is timed.
+    void Lap(double* phase_seconds);
+    // Counts a simulation that reached a leaf `depth` moves below the root.
+    void AddDepth(int depth);
+  };
+
+  // Moves the retained tree to `state`, or starts a new one, and searches it.
+  void StartSearch(const State& state, absl::Time start);
+
+  // Runs the simulations of one search from root_, which may already be
+  // expanded. The time limit counts from `start`.
+  void Search(const State& state, absl::Time start);
+
+  // Starts a new tree, with `state` at its root.
+  void NewTree(const State& state);
+
+  // Moves root_ down to the position reached by `history`, copying its subtree
+  // into a new arena so that the rest of the tree is released. Drops the tree
+  // if `history` does not extend root_history_ or leads to a node that was
+  // never expanded.
+  void AdvanceRoot(const std::vector<Action>& history);
+
   // Applies the UCT policy to play the game until reaching a leaf node.
   //
   // A leaf node is defined as a node that is terminal or has not been evaluated
@@ -187,29 +576,196 @@ class MCTSBot : public Bot {
   //
   // Args:
   //   root: The root node in the search tree.
-  //   state: The state of the game at the root node.
+  //   working_state: The state of the game at the root node, which is played
+  //     forward to the state at the leaf node.
   //   visit_path: A vector of nodes to be filled in descending from the root
   //     node to a leaf node.
   //
-  // Returns: The state of the game at the leaf node.
-  std::unique_ptr<State> ApplyTreePolicy(SearchNode* root, const State& state,
-                                         std::vector<SearchNode*>* visit_path);
+  //   rng: The random generator of the calling thread.
+  //   thread: The statistics of the calling thread. The expansions are
+  //     charged to their phase, and the rest of the descent is left to the
+  //     caller to charge to selection.
+  void ApplyTreePolicy(SearchNode* root, State* working_state,
+                       std::vector<SearchNode*>* visit_path,
+                       std::mt19937* rng, ThreadStats* thread);
+
+  // Returns the state to play a simulation on: `undo_state` when undoing
+  // moves, and otherwise a new copy of `state`, kept in `copy`.
+  State* WorkingState(const State& state, State* undo_state,
+                      std::unique_ptr<State>* copy) const;
+
+  // Takes back the moves along the path when undoing moves.
+  void UndoPath(const std::vector<SearchNode*>& visit_path,
+                State* working_state) const;
+
+  // Runs simulations from the root until the budget runs out or CheckStop()
+  // stops the search. Called by every search thread.
+  void RunSimulations(const State& state, SearchBudget* budget,
+                      std::mt19937* rng, ThreadStats* thread);
+
+  // The same for batch_size > 1: runs rounds of up to batch_size simulations
+  // whose leaves are evaluated together.
+  void RunBatchedSimulations(const State& state, SearchBudget* budget,
+                             std::mt19937* rng, ThreadStats* thread);
+
+  // Adds the root's Dirichlet noise to the priors of a new node, and shuffles
+  // them to reduce bias from move generation order.
+  void PreparePriors(bool root, std::mt19937* rng, ActionsAndProbs* priors);
+
+  // Creates the children of the node unless it already has some, and enters
+  // them in the transposition table. The caller holds ChildrenLock(node).
+  // Returns whether it created them.
+  bool ExpandLocked(SearchNode* node, const State& state,
+                    const ActionsAndProbs& priors);
+
+  // Gives a node without children the children of the position's entry in the
+  // transposition table. Returns whether the node has children.
+  bool LinkTransposition(SearchNode* node, const State& state,
+                         MCTSSearchStats* stats);
+
+  // Records the returns of the terminal state as the outcome of the last node
+  // on the path, and returns them.
+  std::vector<double> SolveLeaf(const State& terminal_state,
+                                const std::vector<SearchNode*>& visit_path);
+
+  // Adds the returns to the nodes on the path, replacing their virtual losses,
+  // and with `solved` backs up the outcomes of solved children.
+  void Backpropagate(const std::vector<SearchNode*>& visit_path,
+                     const std::vector<double>& returns, Player player_id,
+                     bool solved);
+
+  // Takes back the virtual losses of a simulation that is abandoned.
+  void RevertVirtualLoss(const std::vector<SearchNode*>& visit_path);
 
-  void GarbageCollect(SearchNode* node);
+  // Whether the search can stop early: kSolved or kSingleAction, or kNone.
+  SearchStopReason RootDone(const SearchNode* root) const;
+
+  // Whether the most visited child of the root leads every other child by
+  // more than `remaining` visits, and is the one BestChild() would pick.
+  bool RootDecided(const SearchNode* root, int64_t remaining) const;
+
+  // Stops the search if RootDone(), or with `check_decided` and stop_early if
+  // RootDecided() for the remaining budget. Returns whether it has stopped.
+  bool CheckStop(const SearchNode* root, bool check_decided,
+                 SearchBudget* budget) const;
+
+  // Collects garbage if the tree has outgrown max_memory_mb, and charges it
+  // to the thread.
+  void MaybeGarbageCollect(int simulations, ThreadStats* thread);
+
+  // The lock guarding the children pointer of the given node, held to expand
+  // it. Returns nullptr for single-threaded searches, as does StatsLock().
+  absl::Mutex* ChildrenLock(const SearchNode* node) const;
+
+  // The lock guarding the statistics and outcomes of the given node's
+  // children, once it has them. It is picked by the children's address, as
+  // transpositions share them between nodes. The root's own statistics use
+  // StatsLock(nullptr). Taken after ChildrenLock() when both are held.
+  absl::Mutex* StatsLock(const SearchNode* parent) const;
+
+  // Arena allocations, which are serialized between search threads.
+  SearchNode* NewNodes(int count);
+  const double* NewOutcome(absl::Span<const double> outcome);
+  int64_t MemoryUsed();
+
+  // Copies the tree into a new arena, leaving out the children of nodes
+  // explored fewer than gc_limit_ times.
+  void GarbageCollect();
+
+  // Copies the subtree below `node` into a new arena as the new root, and
+  // updates the transposition table.
+  void Rebuild(const SearchNode& node, int min_explore_count);
 
   double uct_c_;
   int max_simulations_;
-  int max_nodes_;  // Max nodes allowed in the tree
-  int nodes_;  // Nodes used in the tree.
+  int64_t max_time_ms_;
+  bool stop_early_;
+  absl::Time deadline_;  // Of the next search only.
+  MCTSSearchStats stats_;  // Of the last search.
+  int64_t max_memory_;  // Max bytes allowed in the tree
+  std::atomic<int> nodes_;  // Nodes used in the tree.
   int gc_limit_;
   bool verbose_;
   bool solve_;
   double max_utility_;
+  double min_utility_;  // The reward of a virtual loss.
   double dirichlet_alpha_;
   double dirichlet_epsilon_;
   std::mt19937 rng_;
   const ChildSelectionPolicy child_selection_policy_;
   std::shared_ptr<Evaluator> evaluator_;
+
+  // The tree kept between moves, and the history of the state at its root.
+  SearchNodeArena arena_;
+  absl::Mutex arena_mutex_;
+  SearchNode* root_;
+  std::vector<Action> root_history_;
+  // Whether the root's priors have their Dirichlet noise, which is added once
+  // per root.
+  bool root_noised_ = false;
+
+  MCTSTranspositionTable transpositions_;
+  absl::Mutex transpositions_mutex_;
+
+  int num_threads_;
+  int batch_size_;
+  bool use_undo_;
+  // Whether descents add virtual losses: with several threads or batches.
+  bool virtual_loss_;
+  // Simulations hold it shared, garbage collection holds it exclusively.
+  absl::Mutex tree_mutex_;
+  std::unique_ptr<absl::Mutex[]> children_locks_;
+  std::unique_ptr<absl::Mutex[]> stats_locks_;
+};
+
+// A SpielBot that runs several independent MCTS searches at once (root
+// parallelism). Each search is a single-threaded MCTSBot with its own tree and
+// seed, running on its own thread, so the searches share no locks. Their
+// root children's visit counts and rewards are summed per action, a child
+// proven by any search keeps its outcome, and the action is picked from the
+// sums like SearchNode::BestChild() does.
+//
+// Every search keeps its tree between moves as an MCTSBot does. The evaluator
+// is shared, so with num_searches > 1 it is called from several threads at
+// once and must be thread-safe. Search i is seeded with seed + i.
+//
+// References:
+// - Chaslot, Winands and van den Herik, Parallel Monte-Carlo Tree Search, 2008,
+//   https://dke.maastrichtuniversity.nl/m.winands/documents/multithreadedMCTS.pdf
+class RootParallelMCTSBot : public Bot {
+ public:
+  // max_simulations, max_memory_mb and max_time_ms apply to each search.
+  RootParallelMCTSBot(
+      const Game& game, std::shared_ptr<Evaluator> evaluator, double uct_c,
+      int max_simulations, int64_t max_memory_mb, bool solve, int seed,
+      bool verbose, int num_searches,
+      ChildSelectionPolicy child_selection_policy = ChildSelectionPolicy::UCT,
+      double dirichlet_alpha = 0, double dirichlet_epsilon = 0,
+      int64_t max_time_ms = 0);
+
+  void Restart() override;
+  void RestartAt(const State& state) override;
+  void InformAction(const State& state, Player player_id,
+                    Action action) override;
+  // Runs the searches and plays the best action of the merged statistics.
+  Action Step(const State& state) override;
+  std::pair<ActionsAndProbs, Action> StepWithPolicy(
+      const State& state) override;
+
+  // Makes the next searches also stop at the deadline.
+  void SetDeadline(absl::Time deadline);
+
+  int num_searches() const { return searches_.size(); }
+  // The statistics of the last searches, merged.
+  const MCTSSearchStats& search_stats() const { return stats_; }
+  // The simulations run by the last searches, summed.
+  int simulations() const { return stats_.simulations; }
+
+ private:
+  bool verbose_;
+  MCTSSearchStats stats_;
+  std::vector<std::unique_ptr<MCTSBot>> searches_;
+  std::unique_ptr<ThreadPool> pool_;  // nullptr for a single search.
 };
 
 // Returns a vector of noise sampled from a dirichlet distribution. See:
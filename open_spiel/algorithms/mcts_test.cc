@@ -14,14 +14,20 @@
 
 #include "open_spiel/algorithms/mcts.h"
 
+#include <algorithm>
+#include <cmath>
 #include <memory>
+#include <tuple>
 #include <utility>
 
 #include "open_spiel/abseil-cpp/absl/strings/string_view.h"
+#include "open_spiel/abseil-cpp/absl/time/clock.h"
+#include "open_spiel/abseil-cpp/absl/time/time.h"
 #include "open_spiel/algorithms/evaluate_bots.h"
 #include "open_spiel/spiel.h"
 #include "open_spiel/spiel_bots.h"
 #include "open_spiel/spiel_utils.h"
+#include "open_spiel/utils/json.h"
 
 namespace open_spiel {
 namespace {
@@ -91,8 +97,11 @@ open_spiel::Action GetAction(const open_spiel::State& state,
   open_spiel::SpielFatalError(absl::StrCat("Illegal action: ", action_str));
 }
 
-std::pair<std::unique_ptr<algorithms::SearchNode>, std::unique_ptr<State>>
-SearchTicTacToeState(const absl::string_view initial_actions) {
+// Returns the bot along with its search tree, which lives in the bot.
+std::tuple<std::unique_ptr<algorithms::MCTSBot>, const algorithms::SearchNode*,
+           std::unique_ptr<State>>
+SearchTicTacToeState(const absl::string_view initial_actions,
+                     int num_threads = 1, int batch_size = 1) {
   auto game = LoadGame("tic_tac_toe");
   std::unique_ptr<State> state = game->NewInitialState();
   for (const auto& action_str : absl::StrSplit(initial_actions, ' ')) {
@@ -100,43 +109,49 @@ SearchTicTacToeState(const absl::string_view initial_actions) {
   }
   auto evaluator =
       std::make_shared<open_spiel::algorithms::RandomRolloutEvaluator>(20, 42);
-  algorithms::MCTSBot bot(*game, evaluator, UCT_C,
-                          /*max_simulations=*/ 10000,
-                          /*max_memory_mb=*/ 10,
-                          /*solve=*/ true,
-                          /*seed=*/ 42,
-                          /*verbose=*/ false);
-  return {bot.MCTSearch(*state), std::move(state)};
+  auto bot = std::make_unique<algorithms::MCTSBot>(
+      *game, evaluator, UCT_C,
+      /*max_simulations=*/ 10000,
+      /*max_memory_mb=*/ 10,
+      /*solve=*/ true,
+      /*seed=*/ 42,
+      /*verbose=*/ false,
+      algorithms::ChildSelectionPolicy::UCT,
+      /*dirichlet_alpha=*/ 0,
+      /*dirichlet_epsilon=*/ 0,
+      num_threads, batch_size);
+  const algorithms::SearchNode* root = bot->MCTSearch(*state);
+  return {std::move(bot), root, std::move(state)};
 }
 
 void MCTSTest_SolveDraw() {
-  auto [root, state] = SearchTicTacToeState("x(1,1) o(0,0) x(2,2)");
+  auto [bot, root, state] = SearchTicTacToeState("x(1,1) o(0,0) x(2,2)");
   SPIEL_CHECK_EQ(state->ToString(), "o..\n.x.\n..x");
-  SPIEL_CHECK_EQ(root->outcome[root->player], 0);
-  for (const algorithms::SearchNode& c : root->children)
-    SPIEL_CHECK_LE(c.outcome[c.player], 0);  // No winning moves.
+  SPIEL_CHECK_EQ(root->outcome()[root->player], 0);
+  for (const algorithms::SearchNode& c : root->children())
+    SPIEL_CHECK_LE(c.outcome()[c.player], 0);  // No winning moves.
   const algorithms::SearchNode& best = root->BestChild();
-  SPIEL_CHECK_EQ(best.outcome[best.player], 0);
+  SPIEL_CHECK_EQ(best.outcome()[best.player], 0);
   std::string action_str = state->ActionToString(best.player, best.action);
   if (action_str != "o(2,0)" && action_str != "o(0,2)")  // All others lose.
     SPIEL_CHECK_EQ(action_str, "o(2,0)");  // "o(0,2)" is also valid.
 }
 
 void MCTSTest_SolveLoss() {
-  auto [root, state] =
+  auto [bot, root, state] =
       SearchTicTacToeState("x(1,1) o(0,0) x(2,2) o(0,1) x(0,2)");
   SPIEL_CHECK_EQ(state->ToString(), "oox\n.x.\n..x");
-  SPIEL_CHECK_EQ(root->outcome[root->player], -1);
-  for (const algorithms::SearchNode& c : root->children)
-    SPIEL_CHECK_EQ(c.outcome[c.player], -1);  // All losses.
+  SPIEL_CHECK_EQ(root->outcome()[root->player], -1);
+  for (const algorithms::SearchNode& c : root->children())
+    SPIEL_CHECK_EQ(c.outcome()[c.player], -1);  // All losses.
 }
 
 void MCTSTest_SolveWin() {
-  auto [root, state] = SearchTicTacToeState("x(0,1) o(2,2)");
+  auto [bot, root, state] = SearchTicTacToeState("x(0,1) o(2,2)");
   SPIEL_CHECK_EQ(state->ToString(), ".x.\n...\n..o");
-  SPIEL_CHECK_EQ(root->outcome[root->player], 1);
+  SPIEL_CHECK_EQ(root->outcome()[root->player], 1);
   const algorithms::SearchNode& best = root->BestChild();
-  SPIEL_CHECK_EQ(best.outcome[best.player], 1);
+  SPIEL_CHECK_EQ(best.outcome()[best.player], 1);
   SPIEL_CHECK_EQ(state->ActionToString(best.player, best.action), "x(0,2)");
 }
 
@@ -151,11 +166,587 @@ void MCTSTest_GarbageCollect() {
                           /*solve=*/ true,
                           /*seed=*/ 42,
                           /*verbose=*/ true);  // Verify the log output.
-  std::unique_ptr<algorithms::SearchNode> root = bot.MCTSearch(*state);
-  SPIEL_CHECK_TRUE(root->outcome.size() == 2 ||
+  const algorithms::SearchNode* root = bot.MCTSearch(*state);
+  SPIEL_CHECK_TRUE(root->solved() ||
                    root->explore_count == 1000000);
 }
 
+// Every simulation through a node but the one that expanded it continues to
+// exactly one child, and the rewards must be back in the utility range once
+// every virtual loss has been replaced.
+void CheckVisitCounts(const algorithms::SearchNode& node) {
+  SPIEL_CHECK_LE(std::abs(node.total_reward), node.explore_count);
+  if (node.num_children == 0) return;
+  int child_visits = 0;
+  for (const algorithms::SearchNode& child : node.children()) {
+    child_visits += child.explore_count;
+    CheckVisitCounts(child);
+  }
+  SPIEL_CHECK_LE(child_visits, node.explore_count);
+  SPIEL_CHECK_GE(child_visits, node.explore_count - 1);
+}
+
+void MCTSTest_TreeParallel() {
+  auto game = LoadGame("tic_tac_toe");
+  auto evaluator =
+      std::make_shared<open_spiel::algorithms::RandomRolloutEvaluator>(5, 42);
+  algorithms::MCTSBot bot(*game, evaluator, UCT_C,
+                          /*max_simulations=*/ 5000,
+                          /*max_memory_mb=*/ 10,
+                          /*solve=*/ false,
+                          /*seed=*/ 42,
+                          /*verbose=*/ false,
+                          algorithms::ChildSelectionPolicy::UCT,
+                          /*dirichlet_alpha=*/ 0,
+                          /*dirichlet_epsilon=*/ 0,
+                          /*num_threads=*/ 4);
+  std::unique_ptr<State> state = game->NewInitialState();
+  const algorithms::SearchNode* root = bot.MCTSearch(*state);
+  SPIEL_CHECK_EQ(root->explore_count, 5000);
+  CheckVisitCounts(*root);
+
+  // The solver still finds the winning move.
+  auto [solved_bot, solved_root, solved_state] =
+      SearchTicTacToeState("x(0,1) o(2,2)", 4);
+  SPIEL_CHECK_EQ(solved_root->outcome()[solved_root->player], 1);
+  const algorithms::SearchNode& best = solved_root->BestChild();
+  SPIEL_CHECK_EQ(solved_state->ActionToString(best.player, best.action),
+                 "x(0,2)");
+
+  auto bot0 = std::make_unique<algorithms::MCTSBot>(
+      *game, evaluator, UCT_C, /*max_simulations=*/ 200, /*max_memory_mb=*/ 5,
+      /*solve=*/ true, /*seed=*/ 42, /*verbose=*/ false,
+      algorithms::ChildSelectionPolicy::UCT, 0, 0, /*num_threads=*/ 4);
+  auto bot1 = InitBot(*game, 200, evaluator);
+  auto results = EvaluateBots(game->NewInitialState().get(),
+                              {bot0.get(), bot1.get()}, 42);
+  SPIEL_CHECK_EQ(results[0] + results[1], 0);
+}
+
+// Counts the calls made to the wrapped evaluator.
+class CountingEvaluator : public algorithms::Evaluator {
+ public:
+  explicit CountingEvaluator(std::shared_ptr<algorithms::Evaluator> evaluator)
+      : evaluator_(std::move(evaluator)) {}
+
+  std::vector<double> Evaluate(const State& state) override {
+    ++evaluate_calls;
+    return evaluator_->Evaluate(state);
+  }
+  ActionsAndProbs Prior(const State& state) override {
+    ++prior_calls;
+    return evaluator_->Prior(state);
+  }
+  std::vector<Evaluation> EvaluateBatch(
+      absl::Span<const State* const> states) override {
+    batched_states += states.size();
+    max_batch_size = std::max<int>(max_batch_size, states.size());
+    return evaluator_->EvaluateBatch(states);
+  }
+
+  int evaluate_calls = 0;
+  int prior_calls = 0;
+  int batched_states = 0;
+  int max_batch_size = 0;
+
+ private:
+  std::shared_ptr<algorithms::Evaluator> evaluator_;
+};
+
+void MCTSTest_BatchedEvaluation() {
+  auto game = LoadGame("tic_tac_toe");
+  auto rollouts = std::make_shared<algorithms::RandomRolloutEvaluator>(5, 42);
+  auto evaluator = std::make_shared<CountingEvaluator>(rollouts);
+  algorithms::MCTSBot bot(*game, evaluator, UCT_C,
+                          /*max_simulations=*/ 2000,
+                          /*max_memory_mb=*/ 10,
+                          /*solve=*/ false,
+                          /*seed=*/ 42,
+                          /*verbose=*/ false,
+                          algorithms::ChildSelectionPolicy::UCT,
+                          /*dirichlet_alpha=*/ 0,
+                          /*dirichlet_epsilon=*/ 0,
+                          /*num_threads=*/ 1,
+                          /*batch_size=*/ 8);
+  const algorithms::SearchNode* root =
+      bot.MCTSearch(*game->NewInitialState());
+  SPIEL_CHECK_EQ(root->explore_count, 2000);
+  CheckVisitCounts(*root);
+  // Every leaf got its value and prior from a batch.
+  SPIEL_CHECK_EQ(evaluator->max_batch_size, 8);
+  SPIEL_CHECK_EQ(evaluator->prior_calls, 0);
+  SPIEL_CHECK_EQ(evaluator->evaluate_calls, 0);
+  SPIEL_CHECK_GT(evaluator->batched_states, 0);
+
+  // The solver still finds the winning move.
+  auto [solved_bot, solved_root, solved_state] =
+      SearchTicTacToeState("x(0,1) o(2,2)", /*num_threads=*/ 1,
+                           /*batch_size=*/ 8);
+  SPIEL_CHECK_EQ(solved_root->outcome()[solved_root->player], 1);
+  const algorithms::SearchNode& best = solved_root->BestChild();
+  SPIEL_CHECK_EQ(solved_state->ActionToString(best.player, best.action),
+                 "x(0,2)");
+
+  // CountingEvaluator is not thread-safe.
+  auto bot0 = std::make_unique<algorithms::MCTSBot>(
+      *game, rollouts, UCT_C, /*max_simulations=*/ 200, /*max_memory_mb=*/ 5,
+      /*solve=*/ true, /*seed=*/ 42, /*verbose=*/ false,
+      algorithms::ChildSelectionPolicy::UCT, 0, 0, /*num_threads=*/ 2,
+      /*batch_size=*/ 4);
+  auto bot1 = InitBot(*game, 200, rollouts);
+  auto results = EvaluateBots(game->NewInitialState().get(),
+                              {bot0.get(), bot1.get()}, 42);
+  SPIEL_CHECK_EQ(results[0] + results[1], 0);
+}
+
+void MCTSTest_SearchNodeArena() {
+  algorithms::SearchNodeArena arena;
+  algorithms::SearchNode* nodes = arena.NewNodes(3);
+  SPIEL_CHECK_EQ(nodes[2].explore_count, 0);
+  SPIEL_CHECK_FALSE(nodes[2].solved());
+  const double* outcome = arena.NewOutcome({1, -1});
+  SPIEL_CHECK_EQ(outcome[1], -1);
+  SPIEL_CHECK_EQ(arena.bytes_used(),
+                 3 * sizeof(algorithms::SearchNode) + 2 * sizeof(double));
+
+  // Blocks larger than a slab still work.
+  algorithms::SearchNode* large = arena.NewNodes(100000);
+  large[99999].explore_count = 1;
+
+  // The memory is handed out again after a reset.
+  arena.Reset();
+  SPIEL_CHECK_EQ(arena.bytes_used(), 0);
+  SPIEL_CHECK_EQ(arena.NewNodes(3), nodes);
+}
+
+void MCTSTest_SubtreeReuse() {
+  auto game = LoadGame("tic_tac_toe");
+  auto evaluator =
+      std::make_shared<open_spiel::algorithms::RandomRolloutEvaluator>(1, 42);
+  algorithms::MCTSBot bot(*game, evaluator, UCT_C,
+                          /*max_simulations=*/ 1000,
+                          /*max_memory_mb=*/ 10,
+                          /*solve=*/ true,
+                          /*seed=*/ 42,
+                          /*verbose=*/ false);
+  std::unique_ptr<State> state = game->NewInitialState();
+  state->ApplyAction(bot.Step(*state));
+  SPIEL_CHECK_EQ(bot.reused_nodes(), 1);
+  SPIEL_CHECK_GT(bot.new_nodes(), 0);
+
+  // The opponent's move is reported.
+  Action reply = state->LegalActions()[0];
+  bot.InformAction(*state, state->CurrentPlayer(), reply);
+  state->ApplyAction(reply);
+  state->ApplyAction(bot.Step(*state));
+  SPIEL_CHECK_GT(bot.reused_nodes(), 1);
+
+  // The opponent's move is only visible in the history.
+  state->ApplyAction(state->LegalActions()[0]);
+  bot.Step(*state);
+  SPIEL_CHECK_GT(bot.reused_nodes(), 1);
+
+  // A position outside the tree starts a new one.
+  std::unique_ptr<State> other = game->NewInitialState();
+  other->ApplyAction(other->LegalActions().back());
+  bot.RestartAt(*other);
+  bot.Step(*other);
+  SPIEL_CHECK_EQ(bot.reused_nodes(), 1);
+
+  bot.Restart();
+  bot.Step(*game->NewInitialState());
+  SPIEL_CHECK_EQ(bot.reused_nodes(), 1);
+}
+
+void MCTSTest_Transpositions() {
+  auto game = LoadGame("tic_tac_toe");
+  auto evaluator =
+      std::make_shared<open_spiel::algorithms::RandomRolloutEvaluator>(1, 42);
+  auto search = [&](int transposition_table_size) {
+    auto bot = std::make_unique<algorithms::MCTSBot>(
+        *game, evaluator, UCT_C, /*max_simulations=*/ 5000,
+        /*max_memory_mb=*/ 10, /*solve=*/ false, /*seed=*/ 42,
+        /*verbose=*/ false, algorithms::ChildSelectionPolicy::UCT, 0, 0,
+        /*num_threads=*/ 1, /*batch_size=*/ 1, transposition_table_size);
+    const algorithms::SearchNode* root =
+        bot->MCTSearch(*game->NewInitialState());
+    SPIEL_CHECK_EQ(root->explore_count, 5000);
+    return bot;
+  };
+  auto tree = search(0);
+  SPIEL_CHECK_EQ(tree->transposition_lookups(), 0);
+  auto graph = search(1 << 16);
+  SPIEL_CHECK_GT(graph->transposition_hits(), 0);
+  SPIEL_CHECK_LE(graph->transposition_hits(), graph->transposition_lookups());
+  // Positions reached by several move orders are expanded once.
+  SPIEL_CHECK_LT(graph->new_nodes(), tree->new_nodes());
+  SPIEL_CHECK_LT(graph->evaluator_calls(), tree->evaluator_calls());
+
+  // A table too small for the tree still gives a sound search.
+  search(algorithms::MCTSTranspositionTable::kWays);
+
+  // The search still finds the winning move, with several threads and with
+  // batches as well.
+  std::unique_ptr<State> state = game->NewInitialState();
+  for (const char* action_str : {"x(0,1)", "o(2,2)"}) {
+    state->ApplyAction(GetAction(*state, action_str));
+  }
+  for (auto [num_threads, batch_size] : {std::pair{1, 1}, {4, 1}, {1, 8}}) {
+    algorithms::MCTSBot bot(*game, evaluator, UCT_C,
+                            /*max_simulations=*/ 10000,
+                            /*max_memory_mb=*/ 10,
+                            /*solve=*/ false,
+                            /*seed=*/ 42,
+                            /*verbose=*/ false,
+                            algorithms::ChildSelectionPolicy::UCT,
+                            /*dirichlet_alpha=*/ 0,
+                            /*dirichlet_epsilon=*/ 0, num_threads, batch_size,
+                            /*transposition_table_size=*/ 1 << 16);
+    const algorithms::SearchNode& best = bot.MCTSearch(*state)->BestChild();
+    SPIEL_CHECK_EQ(state->ActionToString(best.player, best.action), "x(0,2)");
+  }
+
+  // Garbage collection and subtree reuse keep the shared children shared.
+  algorithms::MCTSBot bot(*game, evaluator, UCT_C,
+                          /*max_simulations=*/ 100000,
+                          /*max_memory_mb=*/ 1,
+                          /*solve=*/ false,
+                          /*seed=*/ 42,
+                          /*verbose=*/ false,
+                          algorithms::ChildSelectionPolicy::UCT,
+                          /*dirichlet_alpha=*/ 0,
+                          /*dirichlet_epsilon=*/ 0,
+                          /*num_threads=*/ 1,
+                          /*batch_size=*/ 1,
+                          /*transposition_table_size=*/ 1 << 16);
+  auto bot1 = InitBot(*game, 200, evaluator);
+  auto results = EvaluateBots(game->NewInitialState().get(),
+                              {&bot, bot1.get()}, 42);
+  SPIEL_CHECK_EQ(results[0] + results[1], 0);
+  SPIEL_CHECK_GE(results[0], 0);
+}
+
+// Searches continued on the same root add its Dirichlet noise once.
+void MCTSTest_DirichletNoiseOnce() {
+  auto game = LoadGame("tic_tac_toe");
+  auto evaluator = std::make_shared<algorithms::RandomRolloutEvaluator>(1, 42);
+  algorithms::MCTSBot bot(*game, evaluator, UCT_C,
+                          /*max_simulations=*/ 50,
+                          /*max_memory_mb=*/ 10,
+                          /*solve=*/ false,
+                          /*seed=*/ 42,
+                          /*verbose=*/ false,
+                          algorithms::ChildSelectionPolicy::PUCT,
+                          /*dirichlet_alpha=*/ 0.3,
+                          /*dirichlet_epsilon=*/ 0.25);
+  std::unique_ptr<State> state = game->NewInitialState();
+  for (int move = 0; move < 2; ++move) {
+    std::vector<double> priors;
+    for (int search = 0; search < 3; ++search) {
+      std::vector<double> search_priors;
+      for (const algorithms::SearchNode& child :
+           bot.ContinueSearch(*state)->children()) {
+        search_priors.push_back(child.prior);
+      }
+      if (search > 0) SPIEL_CHECK_EQ(search_priors, priors);
+      priors = search_priors;
+    }
+    const Action action = bot.Step(*state);
+    state->ApplyAction(action);
+  }
+}
+
+void MCTSTest_UndoMatchesClone() {
+  auto game = LoadGame("tic_tac_toe");
+  SPIEL_CHECK_TRUE(game->GetType().provides_undo);
+  std::unique_ptr<State> state = game->NewInitialState();
+  state->ApplyAction(4);
+
+  // Rollouts played in place leave the state as it was.
+  algorithms::RandomRolloutEvaluator copying(10, 42);
+  algorithms::RandomRolloutEvaluator undoing(10, 42);
+  const std::string before = state->ToString();
+  SPIEL_CHECK_EQ(copying.Evaluate(*state),
+                 undoing.EvaluateInPlace(state.get()));
+  SPIEL_CHECK_EQ(state->ToString(), before);
+  SPIEL_CHECK_EQ(state->History(), std::vector<Action>{4});
+
+  // Searches that undo their moves build the same tree as searches that copy
+  // the state.
+  for (int batch_size : {1, 4}) {
+    std::vector<std::vector<int>> visits;
+    for (bool use_undo : {false, true}) {
+      auto evaluator =
+          std::make_shared<algorithms::RandomRolloutEvaluator>(1, 42);
+      algorithms::MCTSBot bot(*game, evaluator, UCT_C,
+                              /*max_simulations=*/ 1000,
+                              /*max_memory_mb=*/ 10,
+                              /*solve=*/ true,
+                              /*seed=*/ 42,
+                              /*verbose=*/ false,
+                              algorithms::ChildSelectionPolicy::UCT,
+                              /*dirichlet_alpha=*/ 0,
+                              /*dirichlet_epsilon=*/ 0,
+                              /*num_threads=*/ 1, batch_size,
+                              /*transposition_table_size=*/ 0, use_undo);
+      const algorithms::SearchNode* root = bot.MCTSearch(*state);
+      visits.emplace_back();
+      for (const algorithms::SearchNode& child : root->children()) {
+        visits.back().push_back(child.explore_count);
+      }
+      SPIEL_CHECK_EQ(state->ToString(), before);
+    }
+    SPIEL_CHECK_EQ(visits[0], visits[1]);
+  }
+}
+
+std::unique_ptr<algorithms::MCTSBot> InitBudgetBot(const Game& game,
+                                                   int max_simulations,
+                                                   int64_t max_time_ms,
+                                                   bool stop_early) {
+  auto evaluator = std::make_shared<algorithms::RandomRolloutEvaluator>(1, 42);
+  return std::make_unique<algorithms::MCTSBot>(
+      game, evaluator, UCT_C, max_simulations,
+      /*max_memory_mb=*/ 10,
+      /*solve=*/ false,
+      /*seed=*/ 42,
+      /*verbose=*/ false,
+      algorithms::ChildSelectionPolicy::UCT,
+      /*dirichlet_alpha=*/ 0,
+      /*dirichlet_epsilon=*/ 0,
+      /*num_threads=*/ 1,
+      /*batch_size=*/ 1,
+      /*transposition_table_size=*/ 0,
+      /*use_undo=*/ true, max_time_ms, stop_early);
+}
+
+void MCTSTest_SearchBudget() {
+  auto game = LoadGame("tic_tac_toe");
+  std::unique_ptr<State> state = game->NewInitialState();
+
+  auto bot = InitBudgetBot(*game, 1000, 0, false);
+  bot->MCTSearch(*state);
+  SPIEL_CHECK_EQ(bot->simulations(), 1000);
+  SPIEL_CHECK_TRUE(bot->stop_reason() ==
+                   algorithms::SearchStopReason::kSimulations);
+
+  // Without a simulation limit the search runs until its time is up.
+  bot = InitBudgetBot(*game, 0, 20, false);
+  absl::Time start = absl::Now();
+  bot->MCTSearch(*state);
+  SPIEL_CHECK_LT(absl::Now() - start, absl::Seconds(5));
+  SPIEL_CHECK_GT(bot->simulations(), 1);
+  SPIEL_CHECK_TRUE(bot->stop_reason() == algorithms::SearchStopReason::kTime);
+
+  // A deadline that has passed only lets the first simulation run, and only
+  // applies to one search.
+  bot = InitBudgetBot(*game, 1000, 0, false);
+  bot->SetDeadline(absl::Now());
+  bot->MCTSearch(*state);
+  SPIEL_CHECK_EQ(bot->simulations(), 1);
+  SPIEL_CHECK_TRUE(bot->stop_reason() == algorithms::SearchStopReason::kTime);
+  bot->MCTSearch(*state);
+  SPIEL_CHECK_EQ(bot->simulations(), 1000);
+
+  // Stopping early leaves the most visited child ahead by more visits than
+  // the rest of the search could have given another child, so the full search
+  // picks the same action.
+  auto early = InitBudgetBot(*game, 10000, 0, true);
+  const algorithms::SearchNode* early_root = early->MCTSearch(*state);
+  SPIEL_CHECK_LT(early->simulations(), 10000);
+  SPIEL_CHECK_TRUE(early->stop_reason() ==
+                   algorithms::SearchStopReason::kDecided);
+  auto full = InitBudgetBot(*game, 10000, 0, false);
+  const algorithms::SearchNode* full_root = full->MCTSearch(*state);
+  SPIEL_CHECK_EQ(early_root->BestChild().action,
+                 full_root->BestChild().action);
+
+  auto [solver, root, solved_state] =
+      SearchTicTacToeState("x(1,1) o(0,0) x(2,2) o(0,1) x(0,2)");
+  SPIEL_CHECK_TRUE(solver->stop_reason() ==
+                   algorithms::SearchStopReason::kSolved);
+}
+
+void MCTSTest_ParallelRollouts() {
+  for (const char* name : {"tic_tac_toe", "pig"}) {
+    auto game = LoadGame(name);
+    std::unique_ptr<State> state = game->NewInitialState();
+    state->ApplyAction(state->LegalActions()[0]);
+    const std::string before = state->ToString();
+    // The tasks are seeded from the evaluator's generator, so the result does
+    // not depend on which pool thread ran them.
+    algorithms::RandomRolloutEvaluator a(64, 42, /*num_threads=*/4);
+    algorithms::RandomRolloutEvaluator b(64, 42, /*num_threads=*/4);
+    for (int i = 0; i < 10; ++i) {
+      const std::vector<double> values = a.Evaluate(*state);
+      SPIEL_CHECK_EQ(values, b.EvaluateInPlace(state.get()));
+      SPIEL_CHECK_EQ(values.size(), game->NumPlayers());
+      for (double value : values) {
+        SPIEL_CHECK_GE(value, game->MinUtility());
+        SPIEL_CHECK_LE(value, game->MaxUtility());
+      }
+    }
+    SPIEL_CHECK_EQ(state->ToString(), before);
+  }
+
+  // A threaded search with a threaded evaluator.
+  auto game = LoadGame("tic_tac_toe");
+  auto evaluator = std::make_shared<algorithms::RandomRolloutEvaluator>(
+      16, 42, /*num_threads=*/3);
+  algorithms::MCTSBot bot(*game, evaluator, UCT_C,
+                          /*max_simulations=*/ 2000,
+                          /*max_memory_mb=*/ 10,
+                          /*solve=*/ true,
+                          /*seed=*/ 42,
+                          /*verbose=*/ false,
+                          algorithms::ChildSelectionPolicy::UCT,
+                          /*dirichlet_alpha=*/ 0,
+                          /*dirichlet_epsilon=*/ 0,
+                          /*num_threads=*/ 2);
+  const algorithms::SearchNode* root = bot.MCTSearch(*game->NewInitialState());
+  CheckVisitCounts(*root);
+}
+
+
+void MCTSTest_RootParallel() {
+  auto game = LoadGame("tic_tac_toe");
+  auto evaluator =
+      std::make_shared<algorithms::RandomRolloutEvaluator>(20, 42);
+  auto make_bot = [&](int num_searches, int max_simulations) {
+    return std::make_unique<algorithms::RootParallelMCTSBot>(
+        *game, evaluator, UCT_C, max_simulations, /*max_memory_mb=*/5,
+        /*solve=*/true, /*seed=*/42, /*verbose=*/false, num_searches);
+  };
+
+  // It plays through EvaluateBots like any other bot.
+  auto bot0 = make_bot(4, 200);
+  auto bot1 = make_bot(4, 200);
+  auto results =
+      EvaluateBots(game->NewInitialState().get(), {bot0.get(), bot1.get()}, 42);
+  SPIEL_CHECK_EQ(results[0] + results[1], 0);
+
+  // The merged statistics find the winning move.
+  std::unique_ptr<State> state = game->NewInitialState();
+  for (absl::string_view action : {"x(0,1)", "o(2,2)"}) {
+    state->ApplyAction(GetAction(*state, action));
+  }
+  auto bot = make_bot(4, 1000);
+  const Action action = bot->Step(*state);
+  SPIEL_CHECK_EQ(state->ActionToString(state->CurrentPlayer(), action),
+                 "x(0,2)");
+  SPIEL_CHECK_GT(bot->simulations(), 0);
+  SPIEL_CHECK_LE(bot->simulations(), 4 * 1000);
+
+  // A single search plays as an MCTSBot with the same seed, given evaluators
+  // in the same state.
+  evaluator = std::make_shared<algorithms::RandomRolloutEvaluator>(20, 42);
+  auto single = make_bot(1, 300);
+  auto serial_evaluator =
+      std::make_shared<algorithms::RandomRolloutEvaluator>(20, 42);
+  algorithms::MCTSBot serial(*game, serial_evaluator, UCT_C,
+                             /*max_simulations=*/ 300,
+                             /*max_memory_mb=*/ 5,
+                             /*solve=*/ true,
+                             /*seed=*/ 42,
+                             /*verbose=*/ false);
+  state = game->NewInitialState();
+  while (!state->IsTerminal()) {
+    const Action action = single->Step(*state);
+    SPIEL_CHECK_EQ(action, serial.Step(*state));
+    state->ApplyAction(action);
+  }
+
+  // The rollouts of each search are seeded from the search, so several
+  // searches sharing an evaluator are reproducible from the seed.
+  state = game->NewInitialState();
+  auto first = make_bot(4, 300);
+  auto second = make_bot(4, 300);
+  const auto policy = first->StepWithPolicy(*state);
+  const auto expected_policy = second->StepWithPolicy(*state);
+  SPIEL_CHECK_EQ(policy.second, expected_policy.second);
+  SPIEL_CHECK_TRUE(policy.first == expected_policy.first);
+}
+
+
+// The counts of a search add up. The phase times are estimated from a sample
+// of the simulations, which may be preempted, so they are only checked to be
+// there.
+void CheckSearchStats(const algorithms::MCTSSearchStats& stats) {
+  int64_t leaves = 0;
+  for (int64_t count : stats.depth_histogram) leaves += count;
+  SPIEL_CHECK_EQ(leaves, stats.simulations);
+  SPIEL_CHECK_GT(stats.expansions, 0);
+  SPIEL_CHECK_EQ(stats.new_nodes, stats.expanded_children);
+  SPIEL_CHECK_GE(stats.BranchingFactor(), 1);
+  SPIEL_CHECK_LE(stats.MeanDepth(), stats.MaxDepth());
+  SPIEL_CHECK_GT(stats.evaluator_calls, 0);
+  SPIEL_CHECK_GT(stats.selection_seconds, 0);
+  SPIEL_CHECK_GT(stats.evaluation_seconds, 0);
+  SPIEL_CHECK_GT(stats.backpropagation_seconds, 0);
+  SPIEL_CHECK_GT(stats.wall_seconds, 0);
+}
+
+void MCTSTest_SearchStats() {
+  auto game = LoadGame("tic_tac_toe");
+  std::unique_ptr<State> state = game->NewInitialState();
+  auto evaluator =
+      std::make_shared<algorithms::RandomRolloutEvaluator>(1, 42);
+  for (auto [num_threads, batch_size] :
+       {std::pair{1, 1}, std::pair{2, 1}, std::pair{1, 4}}) {
+    algorithms::MCTSBot bot(*game, evaluator, UCT_C,
+                            /*max_simulations=*/ 2000,
+                            /*max_memory_mb=*/ 5,
+                            /*solve=*/ false,
+                            /*seed=*/ 42,
+                            /*verbose=*/ false,
+                            algorithms::ChildSelectionPolicy::UCT,
+                            /*dirichlet_alpha=*/ 0,
+                            /*dirichlet_epsilon=*/ 0,
+                            num_threads, batch_size);
+    bot.MCTSearch(*state);
+    const algorithms::MCTSSearchStats& stats = bot.search_stats();
+    SPIEL_CHECK_EQ(stats.simulations, 2000);
+    SPIEL_CHECK_TRUE(stats.stop_reason ==
+                     algorithms::SearchStopReason::kSimulations);
+    SPIEL_CHECK_EQ(stats.reused_nodes, 1);
+    SPIEL_CHECK_EQ(stats.tree_nodes, 1 + stats.new_nodes);
+    SPIEL_CHECK_LE(stats.BranchingFactor(), 9);
+    SPIEL_CHECK_LE(stats.MaxDepth(), 9);
+    SPIEL_CHECK_EQ(stats.evaluator_batches > 0, batch_size > 1);
+    CheckSearchStats(stats);
+
+    json::Object json = stats.ToJson();
+    SPIEL_CHECK_EQ(json["simulations"], 2000);
+    SPIEL_CHECK_EQ(json["stop_reason"], "simulations");
+    SPIEL_CHECK_EQ(json["tree"].GetObject().at("new_nodes"), stats.new_nodes);
+    SPIEL_CHECK_EQ(json["depth"].GetObject().at("histogram").GetArray().size(),
+                   stats.depth_histogram.size());
+  }
+
+  // Garbage collection is counted.
+  algorithms::MCTSBot bot(*game, evaluator, UCT_C,
+                          /*max_simulations=*/ 100000,
+                          /*max_memory_mb=*/ 1,
+                          /*solve=*/ false,
+                          /*seed=*/ 42,
+                          /*verbose=*/ false);
+  bot.MCTSearch(*state);
+  const algorithms::MCTSSearchStats& stats = bot.search_stats();
+  SPIEL_CHECK_GT(stats.gc_passes, 0);
+  SPIEL_CHECK_GT(stats.gc_nodes_freed, 0);
+  SPIEL_CHECK_EQ(stats.tree_nodes,
+                 1 + stats.new_nodes - stats.gc_nodes_freed);
+  CheckSearchStats(stats);
+
+  // The root-parallel bot merges the statistics of its searches.
+  algorithms::RootParallelMCTSBot parallel(
+      *game, evaluator, UCT_C, /*max_simulations=*/ 500, /*max_memory_mb=*/ 5,
+      /*solve=*/ false, /*seed=*/ 42, /*verbose=*/ false, /*num_searches=*/ 3);
+  parallel.Step(*state);
+  SPIEL_CHECK_EQ(parallel.search_stats().simulations, 3 * 500);
+  CheckSearchStats(parallel.search_stats());
+}
+
 }  // namespace
 }  // namespace open_spiel
 
@@ -168,4 +759,15 @@ int main(int argc, char** argv) {
   open_spiel::MCTSTest_SolveLoss();
   open_spiel::MCTSTest_SolveWin();
   open_spiel::MCTSTest_GarbageCollect();
+  open_spiel::MCTSTest_TreeParallel();
+  open_spiel::MCTSTest_BatchedEvaluation();
+  open_spiel::MCTSTest_SearchNodeArena();
+  open_spiel::MCTSTest_SubtreeReuse();
+  open_spiel::MCTSTest_Transpositions();
+  open_spiel::MCTSTest_DirichletNoiseOnce();
+  open_spiel::MCTSTest_UndoMatchesClone();
+  open_spiel::MCTSTest_SearchBudget();
+  open_spiel::MCTSTest_ParallelRollouts();
+  open_spiel::MCTSTest_RootParallel();
+  open_spiel::MCTSTest_SearchStats();
 }
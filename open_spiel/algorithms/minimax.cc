@@ -15,8 +15,13 @@
 #include "open_spiel/algorithms/minimax.h"
 
 #include <algorithm>  // std::max
+#include <cmath>
 #include <limits>
 
+#include "open_spiel/abseil-cpp/absl/base/casts.h"
+#include "open_spiel/abseil-cpp/absl/hash/hash.h"
+#include "open_spiel/abseil-cpp/absl/strings/str_format.h"
+#include "open_spiel/abseil-cpp/absl/time/clock.h"
 #include "open_spiel/games/tic_tac_toe.h"
 #include "open_spiel/spiel.h"
 #include "open_spiel/spiel_utils.h"
@@ -25,124 +30,438 @@ namespace open_spiel {
 namespace algorithms {
 namespace {
 
-// An alpha-beta algorithm.
-//
-// Implements a min-max algorithm with alpha-beta pruning.
-// See for example https://en.wikipedia.org/wiki/Alpha-beta_pruning
-//
-// Arguments:
-//   state: The current state node of the game.
-//   depth: The maximum depth for the min/max search.
-//   alpha: best value that the MAX player can guarantee (if the value is <=
-//     alpha, the MAX player will avoid it).
-//   beta: the best value that the MIN currently can guarantee (if the value is
-//     >= than beta, the MIN player will avoid it).
-//   value_function: An optional functioon mapping a Spiel `State` to a
-//     numerical value, to be used as the value for a node when we reach
-//     `maximum_depth` and the node is not terminal.
-//   maximizing_player_id: The id of the MAX player. The other player is assumed
-//     to be MIN.
-//
-// Returns:
-//   The optimal value of the sub-game starting in state (given alpha/beta).
-double _alpha_beta(State* state, int depth, double alpha, double beta,
-                   std::function<double(const State&)> value_function,
-                   Player maximizing_player, Action* best_action) {
-  if (state->IsTerminal()) {
-    return state->PlayerReturn(maximizing_player);
+// A history score above those of all other moves, for the moves tried first.
+constexpr int64_t kFirstMoveScore = std::numeric_limits<int64_t>::max();
+
+void CheckAlphaBetaGame(const Game& game) {
+  if (game.NumPlayers() != 2) {
+    SpielFatalError("Game must be a 2-player game");
+  }
+  GameType game_info = game.GetType();
+  if (game_info.chance_mode != GameType::ChanceMode::kDeterministic) {
+    SpielFatalError(absl::StrCat("The game must be a Deterministic one, not ",
+                                 game_info.chance_mode));
+  }
+  if (game_info.information != GameType::Information::kPerfectInformation) {
+    SpielFatalError(
+        absl::StrCat("The game must be a perfect information one, not ",
+                     game_info.information));
+  }
+  if (game_info.dynamics != GameType::Dynamics::kSequential) {
+    SpielFatalError(
+        absl::StrCat("The game must be turn-based, not ", game_info.dynamics));
+  }
+  if (game_info.utility != GameType::Utility::kZeroSum) {
+    SpielFatalError(
+        absl::StrCat("The game must be 0-sum, not  ", game_info.utility));
+  }
+}
+
+}  // namespace
+
+double AlphaBetaSearchStats::TTHitRate() const {
+  return tt_lookups > 0 ? static_cast<double>(tt_hits) / tt_lookups : 0;
+}
+
+double AlphaBetaSearchStats::EffectiveBranchingFactor() const {
+  if (depth == 0 || iteration_nodes.empty()) return 0;
+  return std::pow(static_cast<double>(iteration_nodes.back()), 1.0 / depth);
+}
+
+void AlphaBetaSearchStats::AddCounts(const AlphaBetaSearchStats& other) {
+  nodes += other.nodes;
+  tt_lookups += other.tt_lookups;
+  tt_hits += other.tt_hits;
+  tt_cutoffs += other.tt_cutoffs;
+}
+
+std::string AlphaBetaSearchStats::ToString() const {
+  return absl::StrFormat(
+      "depth: %d, nodes: %d, TT hits: %d/%d (%.1f%%), TT cut-offs: %d, "
+      "effective branching factor: %.2f, %.3f s",
+      depth, nodes, tt_hits, tt_lookups, 100 * TTHitRate(), tt_cutoffs,
+      EffectiveBranchingFactor(), seconds);
+}
+
+AlphaBetaTranspositionTable::AlphaBetaTranspositionTable(int size)
+    : num_buckets_(size > 0 ? (size + kWays - 1) / kWays : 0),
+      slots_(new Slot[num_buckets_ * kWays]) {}
+
+uint64_t AlphaBetaTranspositionTable::Key(uint64_t hash, int move_number) {
+  return absl::Hash<std::pair<uint64_t, int>>{}({hash, move_number});
+}
+
+// The data word holds, from the low bits up: the best action (32 bits), the
+// depth (16), the generation (8), the bound (2), and a bit set in every
+// stored entry.
+uint64_t AlphaBetaTranspositionTable::PackData(const Entry& entry) const {
+  return static_cast<uint32_t>(entry.best_action) |
+         static_cast<uint64_t>(std::min(entry.depth, kSolvedDepth)) << 32 |
+         static_cast<uint64_t>(generation_ & 0xff) << 48 |
+         static_cast<uint64_t>(entry.bound) << 56 | uint64_t{1} << 63;
+}
+
+int AlphaBetaTranspositionTable::UnpackDepth(uint64_t data) {
+  return (data >> 32) & 0xffff;
+}
+
+int AlphaBetaTranspositionTable::UnpackGeneration(uint64_t data) {
+  return (data >> 48) & 0xff;
+}
+
+bool AlphaBetaTranspositionTable::Find(uint64_t hash, int move_number,
+                                       Entry* entry) const {
+  const uint64_t key = Key(hash, move_number);
+  const Slot* bucket = &slots_[key % num_buckets_ * kWays];
+  for (int i = 0; i < kWays; ++i) {
+    const uint64_t data = bucket[i].data.load(std::memory_order_relaxed);
+    const uint64_t value = bucket[i].value.load(std::memory_order_relaxed);
+    const uint64_t check = bucket[i].check.load(std::memory_order_relaxed);
+    if (data == 0 || (check ^ value ^ data) != key) continue;
+    entry->hash = hash;
+    entry->move_number = move_number;
+    entry->depth = UnpackDepth(data);
+    entry->value = absl::bit_cast<double>(value);
+    entry->bound = static_cast<Bound>((data >> 56) & 0x3);
+    entry->best_action = static_cast<int32_t>(data & 0xffffffff);
+    return true;
+  }
+  return false;
+}
+
+void AlphaBetaTranspositionTable::Store(const Entry& entry) {
+  const uint64_t key = Key(entry.hash, entry.move_number);
+  Slot* bucket = &slots_[key % num_buckets_ * kWays];
+  Slot* replaced = nullptr;
+  bool replaced_old = false;
+  int replaced_depth = 0;
+  for (int i = 0; i < kWays; ++i) {
+    Slot& slot = bucket[i];
+    const uint64_t data = slot.data.load(std::memory_order_relaxed);
+    if (data == 0 ||
+        (slot.check.load(std::memory_order_relaxed) ^
+         slot.value.load(std::memory_order_relaxed) ^ data) == key) {
+      replaced = &slot;
+      break;
+    }
+    // Prefer entries of earlier searches, then shallow ones.
+    const bool old = UnpackGeneration(data) != (generation_ & 0xff);
+    const int depth = UnpackDepth(data);
+    if (replaced == nullptr || old > replaced_old ||
+        (old == replaced_old && depth < replaced_depth)) {
+      replaced = &slot;
+      replaced_old = old;
+      replaced_depth = depth;
+    }
+  }
+  const uint64_t value = absl::bit_cast<uint64_t>(entry.value);
+  const uint64_t data = PackData(entry);
+  replaced->value.store(value, std::memory_order_relaxed);
+  replaced->data.store(data, std::memory_order_relaxed);
+  replaced->check.store(key ^ value ^ data, std::memory_order_relaxed);
+}
+
+void AlphaBetaTranspositionTable::Clear() {
+  for (size_t i = 0; i < num_buckets_ * kWays; ++i) {
+    slots_[i].check.store(0, std::memory_order_relaxed);
+    slots_[i].value.store(0, std::memory_order_relaxed);
+    slots_[i].data.store(0, std::memory_order_relaxed);
+  }
+}
+
+AlphaBetaSearcher::AlphaBetaSearcher(
+    const Game& game, std::function<double(const State&)> value_function,
+    int transposition_table_size, int num_threads)
+    : game_(game),
+      value_function_(std::move(value_function)),
+      use_undo_(game.GetType().provides_undo),
+      num_distinct_actions_(game.NumDistinctActions()),
+      transpositions_(transposition_table_size),
+      workers_(std::max(num_threads, 1)) {
+  CheckAlphaBetaGame(game);
+  for (int i = 0; i < workers_.size(); ++i) {
+    workers_[i].helper = i > 0;
+    workers_[i].history.assign(game.NumPlayers() * num_distinct_actions_, 0);
+  }
+  if (workers_.size() > 1) {
+    pool_ = std::make_unique<ThreadPool>(workers_.size() - 1);
+  }
+}
+
+void AlphaBetaSearcher::Clear() {
+  transpositions_.Clear();
+  table_player_ = kInvalidPlayer;
+  for (Worker& worker : workers_) {
+    std::fill(worker.history.begin(), worker.history.end(), 0);
+    worker.pv.clear();
+  }
+}
+
+std::pair<double, Action> AlphaBetaSearcher::Search(const State& state,
+                                                    int depth_limit,
+                                                    Player maximizing_player) {
+  absl::Time start = absl::Now();
+  if (maximizing_player == kInvalidPlayer) {
+    maximizing_player = state.CurrentPlayer();
+  }
+  // The table holds values for one maximizing player.
+  if (maximizing_player != table_player_) {
+    if (table_player_ != kInvalidPlayer) transpositions_.Clear();
+    table_player_ = maximizing_player;
+  }
+  transpositions_.NewGeneration();
+  maximizing_player_ = maximizing_player;
+  depth_limit_ = depth_limit;
+  for (Worker& worker : workers_) {
+    worker.stopped = false;
+    worker.pv.clear();
+    worker.killers.clear();
+    worker.stats = AlphaBetaSearchStats();
+    // Halves the history scores, so that the current position's cut-offs
+    // weigh more than those of earlier searches.
+    for (int64_t& score : worker.history) score /= 2;
+  }
+
+  std::pair<double, Action> result;
+  if (pool_ == nullptr) {
+    result = Iterate(&workers_[0], state, /*skip=*/0);
+  } else {
+    stop_ = false;
+    // The main thread's task is handed out first, so it never waits for the
+    // helpers, which stop once it is done.
+    pool_->ParallelFor(workers_.size(), [&](int i) {
+      if (i == 0) {
+        result = Iterate(&workers_[0], state, /*skip=*/0);
+        stop_ = true;
+      } else {
+        Iterate(&workers_[i], state, /*skip=*/i % 2);
+      }
+    });
   }
 
-  if (depth == 0 && !value_function) {
+  stats_ = workers_[0].stats;
+  for (int i = 1; i < workers_.size(); ++i) {
+    stats_.AddCounts(workers_[i].stats);
+  }
+  stats_.seconds = absl::ToDoubleSeconds(absl::Now() - start);
+  return result;
+}
+
+std::pair<double, Action> AlphaBetaSearcher::Iterate(Worker* worker,
+                                                     const State& state,
+                                                     int skip) {
+  std::unique_ptr<State> root = state.Clone();
+  const int depth_limit = depth_limit_;
+  double infinity = std::numeric_limits<double>::infinity();
+  double value = 0;
+  Action best_action = kInvalidAction;
+  int depth = std::min(depth_limit, 1);
+  if (depth_limit == -1) depth = 1;
+  depth += skip;
+  if (depth_limit != -1) depth = std::min(depth, depth_limit);
+  for (;; ++depth) {
+    worker->iteration_depth = depth;
+    const int64_t nodes_before = worker->stats.nodes;
+    bool horizon = false;
+    value = AlphaBeta(worker, root.get(), depth, -infinity, infinity,
+                      /*ply=*/0, /*on_pv=*/true, &horizon);
+    if (worker->stopped) break;
+    worker->pv = worker->pv_table[0];
+    best_action = worker->pv.empty() ? kInvalidAction : worker->pv[0];
+    worker->stats.depth = depth;
+    worker->stats.iteration_nodes.push_back(worker->stats.nodes -
+                                            nodes_before);
+    // An iteration that reached no horizon has searched the whole game.
+    if (!horizon || depth == depth_limit) break;
+  }
+  return {value, best_action};
+}
+
+double AlphaBetaSearcher::Evaluate(const Worker& worker,
+                                   const State& state) const {
+  if (value_function_) return value_function_(state);
+  if (worker.iteration_depth == depth_limit_) {
     SpielFatalError(
         "We assume we can walk the full depth of the tree. "
         "Try increasing depth or provide a value_function.");
   }
+  // Without a value function the shallower iterations only order the moves
+  // of the deeper ones, so any value will do.
+  return 0;
+}
 
+double AlphaBetaSearcher::AlphaBeta(Worker* worker, State* state, int depth,
+                                    double alpha, double beta, int ply,
+                                    bool on_pv, bool* horizon) {
+  if (worker->helper && stop_.load(std::memory_order_relaxed)) {
+    worker->stopped = true;
+    return 0;
+  }
+  AlphaBetaSearchStats& stats = worker->stats;
+  ++stats.nodes;
+  std::vector<std::vector<Action>>& pv_table = worker->pv_table;
+  if (pv_table.size() <= ply) pv_table.resize(ply + 1);
+  pv_table[ply].clear();
+  if (state->IsTerminal()) {
+    return state->PlayerReturn(maximizing_player_);
+  }
   if (depth == 0) {
-    return value_function(*state);
+    *horizon = true;
+    return Evaluate(*worker, *state);
   }
 
-  Player player = state->CurrentPlayer();
-  if (player == maximizing_player) {
-    double value = -std::numeric_limits<double>::infinity();
-
-    for (auto action : state->LegalActions()) {
-      state->ApplyAction(action);
-      double child_value =
-          _alpha_beta(state, /*depth=*/depth - 1, /*alpha=*/alpha,
-                      /*beta=*/beta, value_function, maximizing_player,
-                      /*best_action=*/nullptr);
-      state->UndoAction(player, action);
-
-      if (child_value > value) {
-        value = child_value;
-        if (best_action != nullptr) {
-          *best_action = action;
+  using Bound = AlphaBetaTranspositionTable::Bound;
+  const uint64_t hash = transpositions_.enabled() ? state->HashValue() : 0;
+  Action table_action = kInvalidAction;
+  if (transpositions_.enabled()) {
+    ++stats.tt_lookups;
+    AlphaBetaTranspositionTable::Entry entry;
+    if (transpositions_.Find(hash, state->MoveNumber(), &entry)) {
+      ++stats.tt_hits;
+      table_action = entry.best_action;
+      // The root's value comes with its action, so it is always searched.
+      if (ply > 0 && entry.depth >= depth &&
+          (entry.bound == Bound::kExact ||
+           (entry.bound == Bound::kLower && entry.value >= beta) ||
+           (entry.bound == Bound::kUpper && entry.value <= alpha))) {
+        ++stats.tt_cutoffs;
+        if (entry.depth != AlphaBetaTranspositionTable::kSolvedDepth) {
+          *horizon = true;
         }
-      }
-
-      alpha = std::max(alpha, value);
-      if (alpha >= beta) {
-        break;  // beta cut-off
+        return entry.value;
       }
     }
+  }
 
-    return value;
-  } else {
-    double value = std::numeric_limits<double>::infinity();
+  const Player player = state->CurrentPlayer();
+  const bool maximizing = player == maximizing_player_;
+  const std::vector<Action>& pv = worker->pv;
+  std::vector<Action> actions = state->LegalActions();
+  const Action first = on_pv && ply < pv.size() ? pv[ply] : table_action;
+  OrderActions(*worker, player, ply, first, &actions);
 
-    for (auto action : state->LegalActions()) {
+  const double original_alpha = alpha;
+  const double original_beta = beta;
+  double value = maximizing ? -std::numeric_limits<double>::infinity()
+                            : std::numeric_limits<double>::infinity();
+  Action best_action = kInvalidAction;
+  bool child_horizon = false;
+  for (Action action : actions) {
+    const bool child_on_pv = on_pv && ply < pv.size() && pv[ply] == action;
+    double child_value;
+    if (use_undo_) {
       state->ApplyAction(action);
-      double child_value =
-          _alpha_beta(state, /*depth=*/depth - 1, /*alpha=*/alpha,
-                      /*beta=*/beta, value_function, maximizing_player,
-                      /*best_action=*/nullptr);
+      child_value = AlphaBeta(worker, state, depth - 1, alpha, beta, ply + 1,
+                              child_on_pv, &child_horizon);
       state->UndoAction(player, action);
+    } else {
+      std::unique_ptr<State> child = state->Child(action);
+      child_value = AlphaBeta(worker, child.get(), depth - 1, alpha, beta,
+                              ply + 1, child_on_pv, &child_horizon);
+    }
+    // A stopped helper's values are meaningless, and must not be stored.
+    if (worker->stopped) return 0;
 
-      if (child_value < value) {
-        value = child_value;
-        if (best_action != nullptr) {
-          *best_action = action;
-        }
-      }
+    if (maximizing ? child_value > value : child_value < value) {
+      value = child_value;
+      best_action = action;
+      std::vector<Action>& line = pv_table[ply];
+      line.clear();
+      line.push_back(action);
+      line.insert(line.end(), pv_table[ply + 1].begin(),
+                  pv_table[ply + 1].end());
+    }
 
+    if (maximizing) {
+      alpha = std::max(alpha, value);
+    } else {
       beta = std::min(beta, value);
-      if (alpha >= beta) {
-        break;  // alpha cut-off
-      }
     }
+    if (alpha >= beta) {
+      RecordCutoff(worker, player, action, ply, depth);
+      break;
+    }
+  }
+  if (child_horizon) *horizon = true;
 
-    return value;
+  if (transpositions_.enabled()) {
+    AlphaBetaTranspositionTable::Entry entry;
+    entry.hash = hash;
+    entry.move_number = state->MoveNumber();
+    entry.depth =
+        child_horizon ? depth : AlphaBetaTranspositionTable::kSolvedDepth;
+    entry.value = value;
+    entry.bound = value <= original_alpha  ? Bound::kUpper
+                  : value >= original_beta ? Bound::kLower
+                                           : Bound::kExact;
+    entry.best_action = best_action;
+    transpositions_.Store(entry);
   }
+  return value;
 }
-}  // namespace
 
-std::pair<double, Action> AlphaBetaSearch(
-    const Game& game, const State* state,
-    std::function<double(const State&)> value_function, int depth_limit,
-    Player maximizing_player) {
-  if (game.NumPlayers() != 2) {
-    SpielFatalError("Game must be a 2-player game");
-  }
-  GameType game_info = game.GetType();
-  if (game_info.chance_mode != GameType::ChanceMode::kDeterministic) {
-    SpielFatalError(absl::StrCat("The game must be a Deterministic one, not ",
-                                 game_info.chance_mode));
+void AlphaBetaSearcher::OrderActions(const Worker& worker, Player player,
+                                     int ply, Action first,
+                                     std::vector<Action>* actions) const {
+  const std::array<Action, 2> killers =
+      ply < worker.killers.size()
+          ? worker.killers[ply]
+          : std::array<Action, 2>{kInvalidAction, kInvalidAction};
+  const int64_t* history = &worker.history[player * num_distinct_actions_];
+  std::vector<std::pair<int64_t, Action>> scored;
+  scored.reserve(actions->size());
+  for (Action action : *actions) {
+    int64_t score = history[action];
+    if (action == first) {
+      score = kFirstMoveScore;
+    } else if (action == killers[0]) {
+      score = kFirstMoveScore - 1;
+    } else if (action == killers[1]) {
+      score = kFirstMoveScore - 2;
+    }
+    scored.push_back({score, action});
   }
-  if (game_info.information != GameType::Information::kPerfectInformation) {
-    SpielFatalError(
-        absl::StrCat("The game must be a perfect information one, not ",
-                     game_info.information));
+  // Keeps LegalActions() order among equal scores.
+  std::stable_sort(scored.begin(), scored.end(),
+                   [](const std::pair<int64_t, Action>& a,
+                      const std::pair<int64_t, Action>& b) {
+                     return a.first > b.first;
+                   });
+  for (int i = 0; i < scored.size(); ++i) (*actions)[i] = scored[i].second;
+}
+
+void AlphaBetaSearcher::RecordCutoff(Worker* worker, Player player,
+                                     Action action, int ply, int depth) const {
+  if (worker->killers.size() <= ply) {
+    worker->killers.resize(ply + 1, {kInvalidAction, kInvalidAction});
   }
-  if (game_info.dynamics != GameType::Dynamics::kSequential) {
-    SpielFatalError(
-        absl::StrCat("The game must be turn-based, not ", game_info.dynamics));
-  }
-  if (game_info.utility != GameType::Utility::kZeroSum) {
-    SpielFatalError(
-        absl::StrCat("The game must be 0-sum, not  ", game_info.utility));
+  std::array<Action, 2>& killers = worker->killers[ply];
+  if (killers[0] != action) {
+    killers[1] = killers[0];
+    killers[0] = action;
   }
+  worker->history[player * num_distinct_actions_ + action] +=
+      static_cast<int64_t>(depth) * depth;
+}
 
+AlphaBetaBot::AlphaBetaBot(const Game& game,
+                           std::function<double(const State&)> value_function,
+                           int depth_limit, int num_threads,
+                           int transposition_table_size)
+    : depth_limit_(depth_limit),
+      searcher_(game, std::move(value_function), transposition_table_size,
+                num_threads) {}
+
+Action AlphaBetaBot::Step(const State& state) {
+  return searcher_.Search(state, depth_limit_).second;
+}
+
+void AlphaBetaBot::Restart() { searcher_.Clear(); }
+
+std::pair<double, Action> AlphaBetaSearch(
+    const Game& game, const State* state,
+    std::function<double(const State&)> value_function, int depth_limit,
+    Player maximizing_player) {
   std::unique_ptr<State> search_root;
   if (state == nullptr) {
     search_root = game.NewInitialState();
@@ -150,17 +469,11 @@ std::pair<double, Action> AlphaBetaSearch(
     search_root = state->Clone();
   }
 
-  if (maximizing_player == kInvalidPlayer) {
-    maximizing_player = search_root->CurrentPlayer();
-  }
-
-  double infinity = std::numeric_limits<double>::infinity();
-  Action best_action = kInvalidAction;
-  double value = _alpha_beta(
-      search_root.get(), /*depth=*/depth_limit, /*alpha=*/-infinity,
-      /*beta=*/infinity, value_function, maximizing_player, &best_action);
-
-  return std::pair<double, Action>(value, best_action);
+  // Without a transposition table, whose hits can carry the value of another
+  // history, the value is exactly that of a plain min-max search.
+  AlphaBetaSearcher searcher(game, std::move(value_function),
+                             /*transposition_table_size=*/0);
+  return searcher.Search(*search_root, depth_limit, maximizing_player);
 }
 
 }  // namespace algorithms
@@ -15,10 +15,19 @@
 #ifndef OPEN_SPIEL_ALGORITHMS_MINMAX_H_
 #define OPEN_SPIEL_ALGORITHMS_MINMAX_H_
 
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <limits>
 #include <memory>
+#include <string>
 #include <utility>
+#include <vector>
 
 #include "open_spiel/spiel.h"
+#include "open_spiel/spiel_bots.h"
+#include "open_spiel/utils/thread.h"
 
 namespace open_spiel {
 namespace algorithms {
@@ -43,12 +52,230 @@ namespace algorithms {
 //   Returns:
 //     A pair of the value of the game for the maximizing player when both
 //     players play optimally, along with the action that achieves this value.
-
+//
+// This is a wrapper around a fresh AlphaBetaSearcher without a transposition
+// table, so it searches with iterative deepening and move ordering. Its value
+// is the same as that of a plain min-max search to depth_limit, whatever the
+// game's State::HashValue() covers; when several actions achieve it, the
+// action returned may differ.
 std::pair<double, Action> AlphaBetaSearch(
     const Game& game, const State* state,
     std::function<double(const State&)> value_function, int depth_limit,
     Player maximizing_player);
 
+// Statistics of one AlphaBetaSearcher::Search(). With several threads, the
+// counts are summed over them, while depth and iteration_nodes are those of
+// the main thread.
+struct AlphaBetaSearchStats {
+  int depth = 0;  // The depth of the last iteration.
+  int64_t nodes = 0;  // The states searched by all iterations, leaves included.
+  std::vector<int64_t> iteration_nodes;  // The states searched per iteration.
+  int64_t tt_lookups = 0;
+  int64_t tt_hits = 0;  // Lookups that found the position.
+  int64_t tt_cutoffs = 0;  // Hits whose stored value settled the state.
+  double seconds = 0;
+
+  // The fraction of transposition table lookups that found the position.
+  double TTHitRate() const;
+
+  // The branching factor b of a uniform tree with as many states at the depth
+  // of the last iteration as that iteration searched, i.e. nodes^(1/depth).
+  // Min-max searches b = the real branching factor, and alpha-beta with
+  // perfect move ordering about its square root.
+  double EffectiveBranchingFactor() const;
+
+  // Adds the counts of a helper thread's search.
+  void AddCounts(const AlphaBetaSearchStats& other);
+
+  std::string ToString() const;
+};
+
+// The positions an AlphaBetaSearcher has searched, with the bound on their
+// value found at some remaining depth and the best action there. The table has
+// a fixed number of entries in buckets of kWays. A full bucket gives up an
+// entry from an earlier search first, then its shallowest one.
+//
+// Several threads may find and store entries at once without locks: each
+// entry is three words, one of which is the XOR of the position's key and the
+// other two, so that an entry torn by concurrent stores fails to match any
+// position and is not found (Hyatt and Mann's lockless hashing).
+class AlphaBetaTranspositionTable {
+ public:
+  static constexpr int kWays = 4;
+
+  // The remaining depth of a value searched to the end of the game.
+  static constexpr int kSolvedDepth = std::numeric_limits<uint16_t>::max();
+
+  enum class Bound : int8_t { kExact, kLower, kUpper };
+
+  struct Entry {
+    uint64_t hash = 0;  // State::HashValue() of the position.
+    int move_number = -1;  // State::MoveNumber() of the position.
+    int depth = 0;  // The remaining depth of the search that found the value.
+    double value = 0;  // For the maximizing player.
+    Bound bound = Bound::kExact;
+    Action best_action = kInvalidAction;
+  };
+
+  explicit AlphaBetaTranspositionTable(int size);
+
+  bool enabled() const { return num_buckets_ > 0; }
+
+  // Copies the position's entry to *entry, or returns false.
+  bool Find(uint64_t hash, int move_number, Entry* entry) const;
+  void Store(const Entry& entry);
+  void Clear();
+
+  // Marks the entries stored so far as older than those stored from now on.
+  // Not to be called during a search.
+  void NewGeneration() { ++generation_; }
+
+ private:
+  struct Slot {
+    std::atomic<uint64_t> check{0};  // key ^ value ^ data.
+    std::atomic<uint64_t> value{0};  // The bits of the double.
+    std::atomic<uint64_t> data{0};   // See PackData(); 0 for an empty slot.
+  };
+
+  static uint64_t Key(uint64_t hash, int move_number);
+  uint64_t PackData(const Entry& entry) const;
+  static int UnpackDepth(uint64_t data);
+  static int UnpackGeneration(uint64_t data);
+
+  size_t num_buckets_;
+  std::unique_ptr<Slot[]> slots_;
+  int generation_ = 0;
+};
+
+// An alpha-beta search for the games AlphaBetaSearch() accepts, which reaches
+// deeper than the plain recursion:
+//  - It deepens iteratively, searching to depth 1, 2, ... in turn, so that
+//    each iteration orders its moves with what the previous ones learned.
+//  - A transposition table keeps the value bound and best action of the
+//    positions searched, so that positions reached by several move orders are
+//    searched once, and keeps them across searches.
+//  - Moves are tried in the order: the previous iteration's principal
+//    variation, or else the table's best action; the two killer moves of the
+//    ply, which were the last to cut off a sibling; then the moves by their
+//    history score, the sum of depth^2 over the cut-offs they caused.
+//  - With several threads it runs a Lazy SMP search: every thread deepens
+//    iteratively from the root on its own, half of them one ply ahead, and
+//    they share only the transposition table, where each finds the others'
+//    results. The main thread's result is returned, and the helpers stop when
+//    it is done.
+// Values stay exact min-max values to the depth searched, except that the
+// table can supply values that an earlier search, or a helper thread, found
+// to a greater depth.
+//
+// The table is keyed by State::HashValue() and MoveNumber(), so it treats the
+// same position reached along different histories as one. In games whose
+// outcome also depends on the history beyond the hash, such as draws by
+// repetition in battle_chess, a table hit can carry the value of another
+// history, and the values may then differ from those of a plain min-max.
+class AlphaBetaSearcher {
+ public:
+  // value_function is as for AlphaBetaSearch(), and with several threads it is
+  // called from all of them at once. The table has transposition_table_size
+  // entries; 0 disables it.
+  AlphaBetaSearcher(const Game& game,
+                    std::function<double(const State&)> value_function,
+                    int transposition_table_size = 1 << 20,
+                    int num_threads = 1);
+
+  // Searches the state to depth_limit, or to the end of the game when it is
+  // -1, and returns its value for maximizing_player along with the action
+  // that achieves it. Passing kInvalidPlayer makes the state's current player
+  // the maximizing player.
+  std::pair<double, Action> Search(const State& state, int depth_limit,
+                                   Player maximizing_player = kInvalidPlayer);
+
+  // The expected line of play from the last searched state, which may end
+  // before the depth searched.
+  const std::vector<Action>& principal_variation() const {
+    return workers_[0].pv;
+  }
+
+  const AlphaBetaSearchStats& stats() const { return stats_; }
+
+  int num_threads() const { return workers_.size(); }
+
+  // Forgets what earlier searches learned.
+  void Clear();
+
+ private:
+  // What each thread of a search keeps to itself.
+  struct Worker {
+    bool helper = false;
+    bool stopped = false;  // A helper's search stopped midway.
+    int iteration_depth = 0;
+    std::vector<std::vector<Action>> pv_table;  // Per ply: the line below it.
+    std::vector<Action> pv;  // The previous iteration's principal variation.
+    std::vector<std::array<Action, 2>> killers;  // Per ply.
+    std::vector<int64_t> history;  // Per player and action.
+    AlphaBetaSearchStats stats;
+  };
+
+  // Deepens iteratively from the state, starting `skip` plies deeper than
+  // depth 1, and returns the last iteration's value and best action.
+  std::pair<double, Action> Iterate(Worker* worker, const State& state,
+                                    int skip);
+
+  // Searches the state with `depth` plies left and returns its value for the
+  // maximizing player, exact when it is strictly between alpha and beta and a
+  // bound on it otherwise (fail-soft). Sets *horizon when the value rests on
+  // a position that was evaluated before the end of the game.
+  double AlphaBeta(Worker* worker, State* state, int depth, double alpha,
+                   double beta, int ply, bool on_pv, bool* horizon);
+
+  // The value of a non-terminal state at the search horizon.
+  double Evaluate(const Worker& worker, const State& state) const;
+
+  // Sorts the actions to try the most promising ones first.
+  void OrderActions(const Worker& worker, Player player, int ply, Action first,
+                    std::vector<Action>* actions) const;
+
+  // Records that the action caused a cut-off.
+  void RecordCutoff(Worker* worker, Player player, Action action, int ply,
+                    int depth) const;
+
+  const Game& game_;
+  std::function<double(const State&)> value_function_;
+  const bool use_undo_;
+  const int num_distinct_actions_;
+  AlphaBetaTranspositionTable transpositions_;
+  Player table_player_ = kInvalidPlayer;  // The maximizing player of the table.
+  std::vector<Worker> workers_;  // The main thread's first.
+  std::unique_ptr<ThreadPool> pool_;  // nullptr for a single thread.
+
+  // The state of the current search.
+  Player maximizing_player_ = kInvalidPlayer;
+  int depth_limit_ = 0;
+  std::atomic<bool> stop_{false};  // Tells the helpers to stop.
+  AlphaBetaSearchStats stats_;
+};
+
+// A bot that plays the best action of an AlphaBetaSearcher search to a fixed
+// depth. It keeps the searcher's transposition table from move to move.
+class AlphaBetaBot : public Bot {
+ public:
+  // The arguments are as for AlphaBetaSearcher; value_function gives values
+  // for the player to move at the root.
+  AlphaBetaBot(const Game& game,
+               std::function<double(const State&)> value_function,
+               int depth_limit, int num_threads = 1,
+               int transposition_table_size = 1 << 20);
+
+  Action Step(const State& state) override;
+  void Restart() override;
+  void RestartAt(const State& state) override {}
+
+  const AlphaBetaSearcher& searcher() const { return searcher_; }
+
+ private:
+  const int depth_limit_;
+  AlphaBetaSearcher searcher_;
+};
+
 }  // namespace algorithms
 }  // namespace open_spiel
 
@@ -14,8 +14,14 @@
 
 #include "open_spiel/algorithms/minimax.h"
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
+#include <memory>
+#include <random>
+#include <vector>
 
+#include "open_spiel/algorithms/evaluate_bots.h"
 #include "open_spiel/games/tic_tac_toe.h"
 #include "open_spiel/spiel.h"
 #include "open_spiel/spiel_utils.h"
@@ -64,6 +70,190 @@ void AlphaBetaSearchTest_TicTacToe_Loss() {
   SPIEL_CHECK_EQ(-1.0, value_and_action.first);
 }
 
+// A deterministic value in [-1, 1] that varies a lot between positions, so
+// that move ordering and the transposition table matter.
+double NoiseValue(const State& state) {
+  return static_cast<double>(state.HashValue() % 2001) / 1000.0 - 1.0;
+}
+
+// Min-max without pruning, as the reference for AlphaBetaSearcher.
+double Minimax(const State& state, int depth, Player maximizing_player) {
+  if (state.IsTerminal()) return state.PlayerReturn(maximizing_player);
+  if (depth == 0) return NoiseValue(state);
+  const bool maximizing = state.CurrentPlayer() == maximizing_player;
+  double value = maximizing ? -std::numeric_limits<double>::infinity()
+                            : std::numeric_limits<double>::infinity();
+  for (Action action : state.LegalActions()) {
+    double child_value =
+        Minimax(*state.Child(action), depth - 1, maximizing_player);
+    value = maximizing ? std::max(value, child_value)
+                       : std::min(value, child_value);
+  }
+  return value;
+}
+
+void AlphaBetaSearcherTest_MatchesMinimax(const std::string& game_name,
+                                          int max_depth) {
+  std::shared_ptr<const Game> game = LoadGame(game_name);
+  AlphaBetaSearcher searcher(*game, NoiseValue,
+                             /*transposition_table_size=*/1 << 12);
+  std::mt19937 rng(7);
+  for (int position = 0; position < 5; ++position) {
+    std::unique_ptr<State> state = game->NewInitialState();
+    for (int i = rng() % 6; i > 0 && !state->IsTerminal(); --i) {
+      std::vector<Action> actions = state->LegalActions();
+      state->ApplyAction(actions[rng() % actions.size()]);
+    }
+    if (state->IsTerminal()) continue;
+    for (int depth = 1; depth <= max_depth; ++depth) {
+      const Player player = state->CurrentPlayer();
+      const double expected = Minimax(*state, depth, player);
+      // A table kept from deeper searches may supply deeper values.
+      searcher.Clear();
+      std::pair<double, Action> value_and_action =
+          searcher.Search(*state, depth, player);
+      SPIEL_CHECK_EQ(value_and_action.first, expected);
+      SPIEL_CHECK_EQ(
+          Minimax(*state->Child(value_and_action.second), depth - 1, player),
+          expected);
+      SPIEL_CHECK_EQ(searcher.principal_variation()[0],
+                     value_and_action.second);
+      SPIEL_CHECK_LE(searcher.stats().depth, depth);
+      SPIEL_CHECK_EQ(
+          AlphaBetaSearch(*game, state.get(), NoiseValue, depth, player).first,
+          expected);
+    }
+  }
+}
+
+// With few pieces, battle_chess positions repeat within a few plies, and the
+// draw then depends on the history, which the hash does not cover.
+void AlphaBetaSearchTest_RepetitionDraws() {
+  for (const char* fen : {"k4/5/5/5/4K w 0 1", "k4/5/2a2/5/4K w 0 1"}) {
+    std::shared_ptr<const Game> game =
+        LoadGame("battle_chess", {{"fen", GameParameter(std::string(fen))}});
+    std::mt19937 rng(1);
+    for (int num_moves = 0; num_moves < 10; ++num_moves) {
+      std::unique_ptr<State> state = game->NewInitialState();
+      for (int i = num_moves; i > 0 && !state->IsTerminal(); --i) {
+        std::vector<Action> actions = state->LegalActions();
+        state->ApplyAction(actions[rng() % actions.size()]);
+      }
+      if (state->IsTerminal()) continue;
+      for (int depth = 1; depth <= 6; ++depth) {
+        for (Player player : {0, 1}) {
+          SPIEL_CHECK_EQ(
+              AlphaBetaSearch(*game, state.get(), NoiseValue, depth, player)
+                  .first,
+              Minimax(*state, depth, player));
+        }
+      }
+    }
+  }
+}
+
+void AlphaBetaSearcherTest_Stats() {
+  std::shared_ptr<const Game> game = LoadGame("tic_tac_toe");
+  std::unique_ptr<State> state = game->NewInitialState();
+  AlphaBetaSearcher with_table(*game, nullptr);
+  AlphaBetaSearcher without_table(*game, nullptr,
+                                  /*transposition_table_size=*/0);
+  SPIEL_CHECK_EQ(with_table.Search(*state, -1).first, 0.0);
+  SPIEL_CHECK_EQ(without_table.Search(*state, -1).first, 0.0);
+
+  const AlphaBetaSearchStats& stats = with_table.stats();
+  SPIEL_CHECK_EQ(stats.depth, stats.iteration_nodes.size());
+  SPIEL_CHECK_LE(stats.depth, 9);
+  int64_t nodes = 0;
+  for (int64_t iteration_nodes : stats.iteration_nodes) {
+    nodes += iteration_nodes;
+  }
+  SPIEL_CHECK_EQ(nodes, stats.nodes);
+  SPIEL_CHECK_GT(stats.tt_hits, 0);
+  SPIEL_CHECK_LE(stats.tt_cutoffs, stats.tt_hits);
+  SPIEL_CHECK_LE(stats.tt_hits, stats.tt_lookups);
+  SPIEL_CHECK_GT(stats.TTHitRate(), 0);
+  SPIEL_CHECK_LE(stats.TTHitRate(), 1);
+  SPIEL_CHECK_GT(stats.EffectiveBranchingFactor(), 1);
+  SPIEL_CHECK_LT(stats.EffectiveBranchingFactor(), 9);
+  SPIEL_CHECK_LT(stats.nodes, without_table.stats().nodes);
+  SPIEL_CHECK_EQ(without_table.stats().tt_lookups, 0);
+
+  // The principal variation of a solved game is a line of legal moves.
+  for (Action action : with_table.principal_variation()) {
+    std::vector<Action> actions = state->LegalActions();
+    SPIEL_CHECK_TRUE(std::find(actions.begin(), actions.end(), action) !=
+                     actions.end());
+    state->ApplyAction(action);
+  }
+}
+
+// Keeps the table across the moves of a game, as a bot would.
+void AlphaBetaSearcherTest_SelfPlay() {
+  std::shared_ptr<const Game> game = LoadGame("tic_tac_toe");
+  std::unique_ptr<State> state = game->NewInitialState();
+  AlphaBetaSearcher searcher(*game, nullptr, /*transposition_table_size=*/256);
+  while (!state->IsTerminal()) {
+    std::pair<double, Action> value_and_action = searcher.Search(*state, -1);
+    SPIEL_CHECK_EQ(value_and_action.first, 0.0);
+    state->ApplyAction(value_and_action.second);
+  }
+  SPIEL_CHECK_EQ(state->PlayerReturn(0), 0.0);
+}
+
+// With several threads the values of full-depth searches stay exact.
+void AlphaBetaSearcherTest_Parallel() {
+  std::shared_ptr<const Game> game = LoadGame("tic_tac_toe");
+  AlphaBetaSearcher searcher(*game, nullptr,
+                             /*transposition_table_size=*/1 << 12,
+                             /*num_threads=*/4);
+  SPIEL_CHECK_EQ(searcher.num_threads(), 4);
+  std::mt19937 rng(11);
+  for (int position = 0; position < 20; ++position) {
+    std::unique_ptr<State> state = game->NewInitialState();
+    for (int i = rng() % 6; i > 0 && !state->IsTerminal(); --i) {
+      std::vector<Action> actions = state->LegalActions();
+      state->ApplyAction(actions[rng() % actions.size()]);
+    }
+    if (state->IsTerminal()) continue;
+    const Player player = state->CurrentPlayer();
+    std::pair<double, Action> value_and_action = searcher.Search(*state, -1);
+    const double expected = Minimax(*state, 9, player);
+    SPIEL_CHECK_EQ(value_and_action.first, expected);
+    SPIEL_CHECK_EQ(Minimax(*state->Child(value_and_action.second), 9, player),
+                   expected);
+    SPIEL_CHECK_GE(searcher.stats().nodes,
+                   searcher.stats().iteration_nodes.back());
+  }
+}
+
+void AlphaBetaBotTest_EvaluateBots() {
+  std::shared_ptr<const Game> game = LoadGame("tic_tac_toe");
+  AlphaBetaBot parallel(*game, nullptr, /*depth_limit=*/-1,
+                        /*num_threads=*/2);
+  AlphaBetaBot serial(*game, nullptr, /*depth_limit=*/-1);
+  std::vector<double> results =
+      EvaluateBots(game->NewInitialState().get(), {&parallel, &serial}, 42);
+  SPIEL_CHECK_EQ(results[0], 0.0);
+  std::unique_ptr<Bot> random = MakeUniformRandomBot(1, 42);
+  for (int seed = 0; seed < 5; ++seed) {
+    results =
+        EvaluateBots(game->NewInitialState().get(), {&parallel, random.get()},
+                     seed);
+    SPIEL_CHECK_GE(results[0], 0.0);
+  }
+
+  // A depth-limited bot on a larger game.
+  std::shared_ptr<const Game> breakthrough =
+      LoadGame("breakthrough(rows=5,columns=5)");
+  AlphaBetaBot player0(*breakthrough, NoiseValue, /*depth_limit=*/2,
+                       /*num_threads=*/2);
+  AlphaBetaBot player1(*breakthrough, NoiseValue, /*depth_limit=*/2);
+  results = EvaluateBots(breakthrough->NewInitialState().get(),
+                         {&player0, &player1}, 42);
+  SPIEL_CHECK_EQ(results[0] + results[1], 0.0);
+}
+
 }  // namespace
 }  // namespace algorithms
 }  // namespace open_spiel
@@ -72,4 +262,15 @@ int main(int argc, char **argv) {
   open_spiel::algorithms::AlphaBetaSearchTest_TicTacToe();
   open_spiel::algorithms::AlphaBetaSearchTest_TicTacToe_Win();
   open_spiel::algorithms::AlphaBetaSearchTest_TicTacToe_Loss();
+  open_spiel::algorithms::AlphaBetaSearcherTest_MatchesMinimax("tic_tac_toe",
+                                                               5);
+  open_spiel::algorithms::AlphaBetaSearcherTest_MatchesMinimax(
+      "breakthrough(rows=5,columns=5)", 4);
+  open_spiel::algorithms::AlphaBetaSearcherTest_MatchesMinimax("battle_chess",
+                                                               3);
+  open_spiel::algorithms::AlphaBetaSearchTest_RepetitionDraws();
+  open_spiel::algorithms::AlphaBetaSearcherTest_Stats();
+  open_spiel::algorithms::AlphaBetaSearcherTest_SelfPlay();
+  open_spiel::algorithms::AlphaBetaSearcherTest_Parallel();
+  open_spiel::algorithms::AlphaBetaBotTest_EvaluateBots();
 }
@@ -0,0 +1,149 @@
+// Copyright 2019 DeepMind Technologies Ltd. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Counts the battle_chess positions reachable in exactly N moves ("perft") from
+// a set of reference positions. The counts are checked against stored numbers,
+// so this doubles as a correctness gate for the move generator, and the node
+// rate is reported for clone-based and apply/undo-based traversal.
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "open_spiel/abseil-cpp/absl/flags/flag.h"
+#include "open_spiel/abseil-cpp/absl/flags/parse.h"
+#include "open_spiel/abseil-cpp/absl/strings/str_format.h"
+#include "open_spiel/abseil-cpp/absl/time/clock.h"
+#include "open_spiel/game_parameters.h"
+#include "open_spiel/spiel.h"
+#include "open_spiel/spiel_utils.h"
+
+ABSL_FLAG(int, depth, 4, "How many moves deep to count.");
+ABSL_FLAG(std::string, fen, "",
+          "Only run this position, with --rows and --columns. No reference "
+          "counts are checked.");
+ABSL_FLAG(int, rows, 5, "Rows of the board for --fen.");
+ABSL_FLAG(int, columns, 5, "Columns of the board for --fen.");
+
+namespace open_spiel {
+namespace {
+
+struct PerftPosition {
+  int rows;
+  int columns;
+  std::string fen;
+  // Reference counts for depths 1, 2, ...
+  std::vector<int64_t> counts;
+};
+
+const std::vector<PerftPosition>& ReferencePositions() {
+  static const auto* positions = new std::vector<PerftPosition>{
+      // The standard starting position.
+      {5, 5, "adkda/5/5/5/ADKDA w 0 1",
+       {5, 25, 200, 1600, 13262, 108809}},
+      // Both sides have pieces in contact, with captures for either side.
+      {5, 5, "a1k1a/1d1d1/2D2/1A1a1/D1K1A w 3 4",
+       {13, 169, 1745, 19150, 186963, 1995850}},
+      // Black to play, kings exposed.
+      {5, 5, "3k1/1A3/2d2/1K1a1/5 b 6 9",
+       {12, 79, 785, 4575, 39568, 218250}},
+      // The default setup on larger boards.
+      {6, 6, "addkda/6/6/6/6/ADDKDA w 0 1",
+       {6, 36, 336, 3136, 31363, 313652}},
+      {8, 8, "adddkdda/8/8/8/8/8/8/ADDDKDDA w 0 1",
+       {8, 64, 752, 8836, 114116, 1473796}},
+  };
+  return *positions;
+}
+
+// Copies the state at every node, as search algorithms built on Clone() do.
+int64_t PerftClone(const State& state, int depth) {
+  if (depth == 0) return 1;
+  if (state.IsTerminal()) return 0;
+  int64_t nodes = 0;
+  for (Action action : state.LegalActions()) {
+    std::unique_ptr<State> child = state.Child(action);
+    nodes += PerftClone(*child, depth - 1);
+  }
+  return nodes;
+}
+
+// Walks the tree in place with ApplyAction() and UndoAction().
+int64_t PerftUndo(State* state, int depth) {
+  if (depth == 0) return 1;
+  if (state->IsTerminal()) return 0;
+  int64_t nodes = 0;
+  for (Action action : state->LegalActions()) {
+    const Player player = state->CurrentPlayer();
+    state->ApplyAction(action);
+    nodes += PerftUndo(state, depth - 1);
+    state->UndoAction(player, action);
+  }
+  return nodes;
+}
+
+// Returns the node count, after checking that both traversals agree.
+int64_t RunPerft(const PerftPosition& position, int depth) {
+  std::shared_ptr<const Game> game =
+      LoadGame("battle_chess", {{"rows", GameParameter(position.rows)},
+                                {"columns", GameParameter(position.columns)},
+                                {"fen", GameParameter(position.fen)}});
+  std::unique_ptr<State> state = game->NewInitialState();
+  std::cout << absl::StrFormat("%dx%d %s, depth %d: ", position.rows,
+                               position.columns, position.fen, depth);
+
+  absl::Time start = absl::Now();
+  const int64_t clone_nodes = PerftClone(*state, depth);
+  const double clone_seconds = absl::ToDoubleSeconds(absl::Now() - start);
+
+  start = absl::Now();
+  const int64_t undo_nodes = PerftUndo(state.get(), depth);
+  const double undo_seconds = absl::ToDoubleSeconds(absl::Now() - start);
+
+  SPIEL_CHECK_EQ(clone_nodes, undo_nodes);
+  std::cout << absl::StrFormat(
+                   "%d nodes, clone: %.2f M nodes/s, undo: %.2f M nodes/s",
+                   clone_nodes, clone_nodes / clone_seconds / 1e6,
+                   undo_nodes / undo_seconds / 1e6)
+            << std::endl;
+  return clone_nodes;
+}
+
+}  // namespace
+}  // namespace open_spiel
+
+int main(int argc, char** argv) {
+  absl::ParseCommandLine(argc, argv);
+  const int depth = absl::GetFlag(FLAGS_depth);
+
+  if (!absl::GetFlag(FLAGS_fen).empty()) {
+    open_spiel::RunPerft({absl::GetFlag(FLAGS_rows),
+                          absl::GetFlag(FLAGS_columns),
+                          absl::GetFlag(FLAGS_fen),
+                          {}},
+                         depth);
+    return 0;
+  }
+
+  for (const auto& position : open_spiel::ReferencePositions()) {
+    for (int d = 1; d <= depth; ++d) {
+      const int64_t nodes = open_spiel::RunPerft(position, d);
+      if (d <= position.counts.size()) {
+        SPIEL_CHECK_EQ(nodes, position.counts[d - 1]);
+      }
+    }
+  }
+}
@@ -0,0 +1,198 @@
+// Copyright 2019 DeepMind Technologies Ltd. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures how many states AlphaBetaSearcher searches, and how long it takes,
+// to reach depths 1, 2, ... from positions reached by random play. The leaf
+// value is either the material balance, read from an observation tensor that
+// has one plane per piece type of the first player, as many for the second
+// player and a last plane of empty squares (as in battle_chess and
+// breakthrough), or a pseudo-random function of the position, which makes
+// move ordering as hard as it gets. Up to --reference_max_depth, the first
+// line per depth is a reference: the plain recursive alpha-beta that
+// AlphaBetaSearch() used to be, which tries the moves in LegalActions() order.
+// The searcher runs a Lazy SMP search with --threads threads.
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "open_spiel/abseil-cpp/absl/flags/flag.h"
+#include "open_spiel/abseil-cpp/absl/flags/parse.h"
+#include "open_spiel/abseil-cpp/absl/strings/str_format.h"
+#include "open_spiel/abseil-cpp/absl/time/clock.h"
+#include "open_spiel/algorithms/minimax.h"
+#include "open_spiel/spiel.h"
+
+ABSL_FLAG(std::string, game, "battle_chess", "The name of the game to search.");
+ABSL_FLAG(std::string, value, "material",
+          "The leaf value: material or noise.");
+ABSL_FLAG(int, positions, 4, "How many positions to search.");
+ABSL_FLAG(int, max_depth, 6, "The deepest search.");
+ABSL_FLAG(int, reference_max_depth, 4, "The deepest reference search.");
+ABSL_FLAG(int, threads, 1, "The number of threads of the searcher.");
+ABSL_FLAG(int, transposition_table_size, 1 << 20,
+          "The number of transposition table entries.");
+
+namespace open_spiel {
+
+using ValueFunction = std::function<double(const State&)>;
+
+// Returns the leaf value for the maximizing player.
+ValueFunction MakeValueFunction(const std::string& name,
+                                Player maximizing_player) {
+  if (name == "noise") {
+    return [](const State& state) {
+      return static_cast<double>(state.HashValue() % 2001) / 1000.0 - 1.0;
+    };
+  }
+  SPIEL_CHECK_EQ(name, "material");
+  return [maximizing_player](const State& state) {
+    std::vector<double> tensor = state.ObservationTensor(0);
+    const std::vector<int> shape = state.GetGame()->ObservationTensorShape();
+    const int plane_size = tensor.size() / shape[0];
+    const int player_planes = (shape[0] - 1) / 2;
+    double balance = 0;
+    for (int i = 0; i < 2 * player_planes * plane_size; ++i) {
+      balance += i < player_planes * plane_size ? tensor[i] : -tensor[i];
+    }
+    // Stays within the terminal values.
+    balance /= plane_size + 1;
+    return maximizing_player == 0 ? balance : -balance;
+  };
+}
+
+// Returns positions reached by a few random moves from the initial state.
+std::vector<std::unique_ptr<State>> RandomPositions(const Game& game,
+                                                    int num_positions) {
+  std::mt19937 rng(42);
+  std::vector<std::unique_ptr<State>> positions;
+  while (positions.size() < num_positions) {
+    std::unique_ptr<State> state = game.NewInitialState();
+    const int num_moves = rng() % 8;
+    for (int i = 0; i < num_moves && !state->IsTerminal(); ++i) {
+      std::vector<Action> actions = state->LegalActions();
+      state->ApplyAction(actions[rng() % actions.size()]);
+    }
+    if (!state->IsTerminal()) positions.push_back(std::move(state));
+  }
+  return positions;
+}
+
+// Alpha-beta as AlphaBetaSearch() searched before AlphaBetaSearcher.
+double ReferenceAlphaBeta(State* state, int depth, double alpha, double beta,
+                          Player maximizing_player,
+                          const ValueFunction& value_function,
+                          int64_t* nodes) {
+  ++*nodes;
+  if (state->IsTerminal()) return state->PlayerReturn(maximizing_player);
+  if (depth == 0) return value_function(*state);
+  const Player player = state->CurrentPlayer();
+  const bool maximizing = player == maximizing_player;
+  double value = maximizing ? -std::numeric_limits<double>::infinity()
+                            : std::numeric_limits<double>::infinity();
+  for (Action action : state->LegalActions()) {
+    state->ApplyAction(action);
+    const double child_value =
+        ReferenceAlphaBeta(state, depth - 1, alpha, beta, maximizing_player,
+                           value_function, nodes);
+    state->UndoAction(player, action);
+    if (maximizing) {
+      value = std::max(value, child_value);
+      alpha = std::max(alpha, value);
+    } else {
+      value = std::min(value, child_value);
+      beta = std::min(beta, value);
+    }
+    if (alpha >= beta) break;
+  }
+  return value;
+}
+
+void AlphaBetaBenchmark(const Game& game, const std::string& value,
+                        int num_positions, int max_depth,
+                        int reference_max_depth, int num_threads,
+                        int table_size) {
+  std::vector<std::unique_ptr<State>> positions =
+      RandomPositions(game, num_positions);
+  const double infinity = std::numeric_limits<double>::infinity();
+  for (int depth = 1; depth <= max_depth; ++depth) {
+    if (depth <= reference_max_depth) {
+      int64_t nodes = 0;
+      absl::Time start = absl::Now();
+      for (const std::unique_ptr<State>& position : positions) {
+        std::unique_ptr<State> state = position->Clone();
+        const Player player = state->CurrentPlayer();
+        ReferenceAlphaBeta(state.get(), depth, -infinity, infinity, player,
+                           MakeValueFunction(value, player), &nodes);
+      }
+      const double seconds = absl::ToDoubleSeconds(absl::Now() - start);
+      std::cout << absl::StrFormat(
+                       "Benchmark: game: %s, depth: %d, reference: "
+                       "%.1f k nodes/search, effective branching factor: "
+                       "%.2f, %.3f s/search",
+                       game.GetType().short_name, depth,
+                       nodes / 1e3 / num_positions,
+                       std::pow(static_cast<double>(nodes) / num_positions,
+                                1.0 / depth),
+                       seconds / num_positions)
+                << std::endl;
+    }
+
+    algorithms::AlphaBetaSearchStats total;
+    double tt_hit_rate = 0;
+    double branching_factor = 0;
+    for (const std::unique_ptr<State>& position : positions) {
+      // A new searcher per position, so that no search reuses another's work.
+      algorithms::AlphaBetaSearcher searcher(
+          game, MakeValueFunction(value, position->CurrentPlayer()),
+          table_size, num_threads);
+      searcher.Search(*position, depth);
+      const algorithms::AlphaBetaSearchStats& stats = searcher.stats();
+      total.nodes += stats.nodes;
+      total.seconds += stats.seconds;
+      tt_hit_rate += stats.TTHitRate();
+      branching_factor += stats.EffectiveBranchingFactor();
+    }
+    std::cout << absl::StrFormat(
+                     "Benchmark: game: %s, depth: %d, searcher (%d threads): "
+                     "%.1f k nodes/search, effective branching factor: "
+                     "%.2f, TT hit rate: %.1f%%, %.3f s/search",
+                     game.GetType().short_name, depth, num_threads,
+                     total.nodes / 1e3 / num_positions,
+                     branching_factor / num_positions,
+                     100 * tt_hit_rate / num_positions,
+                     total.seconds / num_positions)
+              << std::endl;
+  }
+}
+
+}  // namespace open_spiel
+
+int main(int argc, char** argv) {
+  absl::ParseCommandLine(argc, argv);
+
+  auto game = open_spiel::LoadGame(absl::GetFlag(FLAGS_game));
+  open_spiel::AlphaBetaBenchmark(*game, absl::GetFlag(FLAGS_value),
+                                 absl::GetFlag(FLAGS_positions),
+                                 absl::GetFlag(FLAGS_max_depth),
+                                 absl::GetFlag(FLAGS_reference_max_depth),
+                                 absl::GetFlag(FLAGS_threads),
+                                 absl::GetFlag(FLAGS_transposition_table_size));
+}
@@ -0,0 +1,110 @@
+// Copyright 2019 DeepMind Technologies Ltd. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures how many CFR iterations per second CFRSolverBase runs, keyed by
+// information state strings, in precompiled mode and over a compiled tree on
+// 1, 2, 4, ... threads.
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "open_spiel/abseil-cpp/absl/flags/flag.h"
+#include "open_spiel/abseil-cpp/absl/flags/parse.h"
+#include "open_spiel/abseil-cpp/absl/strings/str_format.h"
+#include "open_spiel/abseil-cpp/absl/strings/str_split.h"
+#include "open_spiel/abseil-cpp/absl/time/clock.h"
+#include "open_spiel/algorithms/cfr.h"
+#include "open_spiel/spiel.h"
+
+ABSL_FLAG(std::string, games,
+          "kuhn_poker,leduc_poker,liars_dice,"
+          "turn_based_simultaneous_game(game=goofspiel(imp_info=True,"
+          "num_cards=4,points_order=descending))",
+          "Semicolon- or comma-separated list of games to solve.");
+ABSL_FLAG(int, iterations, 10, "How many CFR iterations per run.");
+ABSL_FLAG(bool, cfr_plus, false, "Runs CFR+ instead of CFR.");
+ABSL_FLAG(int, max_threads, 4,
+          "The largest number of threads to walk the compiled tree with.");
+
+namespace open_spiel {
+
+enum class CFRMode { kStringKeyed, kPrecompiled, kCompiledTree };
+
+void CFRBenchmark(const Game& game, int num_iterations, bool cfr_plus,
+                  CFRMode mode, int num_threads) {
+  absl::Time start = absl::Now();
+  algorithms::CFRSolverBase solver(game, /*alternating_updates=*/true,
+                                   /*linear_averaging=*/cfr_plus,
+                                   /*regret_matching_plus=*/cfr_plus,
+                                   mode != CFRMode::kStringKeyed,
+                                   mode == CFRMode::kCompiledTree,
+                                   num_threads);
+  const double setup_seconds = absl::ToDoubleSeconds(absl::Now() - start);
+  start = absl::Now();
+  for (int i = 0; i < num_iterations; ++i) {
+    solver.EvaluateAndUpdatePolicy();
+  }
+  const double seconds = absl::ToDoubleSeconds(absl::Now() - start);
+  std::cout << absl::StrFormat(
+                   "Benchmark: game: %s, %s, %s, threads: %d: "
+                   "%.2f iterations/s (setup %.2f s)",
+                   game.ToString(), cfr_plus ? "CFR+" : "CFR",
+                   mode == CFRMode::kStringKeyed  ? "string-keyed"
+                   : mode == CFRMode::kPrecompiled ? "precompiled"
+                                                   : "compiled tree",
+                   num_threads, num_iterations / seconds, setup_seconds)
+            << std::endl;
+}
+
+}  // namespace open_spiel
+
+int main(int argc, char** argv) {
+  absl::ParseCommandLine(argc, argv);
+
+  // Splits on commas outside of game parameters.
+  std::vector<std::string> game_names;
+  int depth = 0;
+  std::string name;
+  for (char c : absl::GetFlag(FLAGS_games)) {
+    if (c == '(') ++depth;
+    if (c == ')') --depth;
+    if ((c == ',' || c == ';') && depth == 0) {
+      game_names.push_back(name);
+      name.clear();
+    } else {
+      name += c;
+    }
+  }
+  if (!name.empty()) game_names.push_back(name);
+
+  for (const std::string& game_name : game_names) {
+    std::shared_ptr<const open_spiel::Game> game =
+        open_spiel::LoadGame(game_name);
+    for (open_spiel::CFRMode mode : {open_spiel::CFRMode::kStringKeyed,
+                                     open_spiel::CFRMode::kPrecompiled,
+                                     open_spiel::CFRMode::kCompiledTree}) {
+      open_spiel::CFRBenchmark(*game, absl::GetFlag(FLAGS_iterations),
+                               absl::GetFlag(FLAGS_cfr_plus), mode,
+                               /*num_threads=*/1);
+    }
+    for (int threads = 2; threads <= absl::GetFlag(FLAGS_max_threads);
+         threads *= 2) {
+      open_spiel::CFRBenchmark(*game, absl::GetFlag(FLAGS_iterations),
+                               absl::GetFlag(FLAGS_cfr_plus),
+                               open_spiel::CFRMode::kCompiledTree, threads);
+    }
+  }
+}
@@ -0,0 +1,94 @@
+// Copyright 2019 DeepMind Technologies Ltd. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures State::Clone() throughput, which is paid once per simulation by
+// MCTS and once per rollout by the random rollout evaluator.
+
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "open_spiel/abseil-cpp/absl/flags/flag.h"
+#include "open_spiel/abseil-cpp/absl/flags/parse.h"
+#include "open_spiel/abseil-cpp/absl/strings/str_format.h"
+#include "open_spiel/abseil-cpp/absl/time/clock.h"
+#include "open_spiel/spiel.h"
+
+ABSL_FLAG(std::string, game, "battle_chess", "The name of the game to clone.");
+ABSL_FLAG(int, positions, 1000,
+          "How many positions to sample from random games.");
+ABSL_FLAG(int, clones, 1000000, "How many clones to make per attempt.");
+ABSL_FLAG(int, attempts, 5, "How many sets of clones to run.");
+
+namespace open_spiel {
+
+// Collects non-terminal positions from random games, so that the benchmark
+// covers states with short and long histories.
+std::vector<std::unique_ptr<State>> SamplePositions(std::mt19937* rng,
+                                                    const Game& game,
+                                                    int num_positions) {
+  std::vector<std::unique_ptr<State>> positions;
+  while (positions.size() < num_positions) {
+    std::unique_ptr<State> state = game.NewInitialState();
+    while (!state->IsTerminal() && positions.size() < num_positions) {
+      positions.push_back(state->Clone());
+      if (state->IsChanceNode()) {
+        state->ApplyAction(SampleAction(state->ChanceOutcomes(), *rng).first);
+      } else {
+        std::vector<Action> actions = state->LegalActions();
+        std::uniform_int_distribution<int> dis(0, actions.size() - 1);
+        state->ApplyAction(actions[dis(*rng)]);
+      }
+    }
+  }
+  return positions;
+}
+
+void CloneBenchmark(const Game& game,
+                    const std::vector<std::unique_ptr<State>>& positions,
+                    int num_clones) {
+  std::cout << absl::StrFormat("Benchmark: game: %s, num_clones: %d. ",
+                               game.GetType().short_name, num_clones);
+
+  // Keep the clones alive for a while so that the allocator has to do real
+  // work, as it does when MCTS holds a simulation's state.
+  constexpr int kLiveClones = 64;
+  std::vector<std::unique_ptr<State>> live(kLiveClones);
+
+  absl::Time start = absl::Now();
+  for (int i = 0; i < num_clones; ++i) {
+    live[i % kLiveClones] = positions[i % positions.size()]->Clone();
+  }
+  absl::Time end = absl::Now();
+  double seconds = absl::ToDoubleSeconds(end - start);
+
+  std::cout << absl::StrFormat("Finished in %.1f ms: %.2f M clones/s",
+                               seconds * 1000, num_clones / seconds / 1e6)
+            << std::endl;
+}
+
+}  // namespace open_spiel
+
+int main(int argc, char** argv) {
+  absl::ParseCommandLine(argc, argv);
+
+  std::mt19937 rng;
+  auto game = open_spiel::LoadGame(absl::GetFlag(FLAGS_game));
+  auto positions = open_spiel::SamplePositions(&rng, *game,
+                                               absl::GetFlag(FLAGS_positions));
+  for (int i = 0; i < absl::GetFlag(FLAGS_attempts); ++i) {
+    open_spiel::CloneBenchmark(*game, positions, absl::GetFlag(FLAGS_clones));
+  }
+}
@@ -0,0 +1,125 @@
+// Copyright 2019 DeepMind Technologies Ltd. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures MCTS simulations per second from the initial state with 1, 2, 4, ...
+// search threads, to show how tree-parallel search scales. The evaluator calls
+// are reported too, so that runs with and without --transposition_table_size
+// show how much evaluation the transposition table saves. With --max_time_ms
+// the searches are time-budgeted instead, and each reports why it stopped.
+// With --stats_dir the MCTSSearchStats of every search are written to
+// mcts_stats.jsonl in that directory.
+
+#include <iostream>
+#include <memory>
+
+#include "open_spiel/abseil-cpp/absl/flags/flag.h"
+#include "open_spiel/abseil-cpp/absl/flags/parse.h"
+#include "open_spiel/abseil-cpp/absl/strings/str_format.h"
+#include "open_spiel/abseil-cpp/absl/time/clock.h"
+#include "open_spiel/algorithms/mcts.h"
+#include "open_spiel/spiel.h"
+#include "open_spiel/utils/data_logger.h"
+
+ABSL_FLAG(std::string, game, "battle_chess", "The name of the game to search.");
+ABSL_FLAG(int, simulations, 20000, "How many simulations to run per search.");
+ABSL_FLAG(int, rollouts, 1, "How many random rollouts per evaluation.");
+ABSL_FLAG(int, max_threads, 8, "The largest number of threads to try.");
+ABSL_FLAG(int, batch_size, 1, "How many leaves each thread evaluates at once.");
+ABSL_FLAG(int, attempts, 3, "How many searches to run per thread count.");
+ABSL_FLAG(int, transposition_table_size, 0,
+          "Entries in the transposition table, or 0 to search a tree.");
+ABSL_FLAG(int, max_time_ms, 0,
+          "The time limit of each search, or 0 to only limit simulations.");
+ABSL_FLAG(bool, stop_early, false,
+          "Whether searches stop once the best action can't be overtaken.");
+ABSL_FLAG(std::string, stats_dir, "",
+          "A directory to log the statistics of each search to, if any.");
+
+namespace open_spiel {
+
+void MCTSBenchmark(const Game& game, int num_threads, int batch_size,
+                   int num_simulations, int num_rollouts,
+                   int transposition_table_size, int max_time_ms,
+                   bool stop_early, DataLogger* logger) {
+  std::cout << absl::StrFormat("Benchmark: game: %s, threads: %d, batch: %d. ",
+                               game.GetType().short_name, num_threads,
+                               batch_size);
+
+  auto evaluator =
+      std::make_shared<algorithms::RandomRolloutEvaluator>(num_rollouts, 42);
+  // The solver cannot be combined with a transposition table.
+  algorithms::MCTSBot bot(game, evaluator, /*uct_c=*/2, num_simulations,
+                          /*max_memory_mb=*/1000,
+                          /*solve=*/transposition_table_size == 0, /*seed=*/42,
+                          /*verbose=*/false,
+                          algorithms::ChildSelectionPolicy::UCT,
+                          /*dirichlet_alpha=*/0, /*dirichlet_epsilon=*/0,
+                          num_threads, batch_size, transposition_table_size,
+                          /*use_undo=*/true, max_time_ms, stop_early);
+  std::unique_ptr<State> state = game.NewInitialState();
+
+  absl::Time start = absl::Now();
+  const algorithms::SearchNode* root = bot.MCTSearch(*state);
+  absl::Time end = absl::Now();
+  double seconds = absl::ToDoubleSeconds(end - start);
+
+  std::cout << absl::StrFormat(
+                   "Finished %d simulations in %.1f ms: %.1f k sims/s, "
+                   "stopped by %s",
+                   bot.simulations(), seconds * 1000,
+                   bot.simulations() / seconds / 1e3,
+                   algorithms::SearchStopReasonToString(bot.stop_reason()))
+            << std::endl;
+  std::cout << absl::StrFormat("  %d evaluator calls", bot.evaluator_calls());
+  if (bot.transposition_lookups() > 0) {
+    std::cout << absl::StrFormat(
+        ", transpositions: %d hits in %d lookups (%.1f%%)",
+        bot.transposition_hits(), bot.transposition_lookups(),
+        100.0 * bot.transposition_hits() / bot.transposition_lookups());
+  }
+  std::cout << std::endl;
+
+  DataLogger::Record record = bot.search_stats().ToJson();
+  record.emplace("game", game.GetType().short_name);
+  record.emplace("threads", num_threads);
+  record.emplace("batch_size", batch_size);
+  logger->Write(record);
+}
+
+}  // namespace open_spiel
+
+int main(int argc, char** argv) {
+  absl::ParseCommandLine(argc, argv);
+
+  auto game = open_spiel::LoadGame(absl::GetFlag(FLAGS_game));
+  std::unique_ptr<open_spiel::DataLogger> logger;
+  if (absl::GetFlag(FLAGS_stats_dir).empty()) {
+    logger = std::make_unique<open_spiel::DataLoggerNoop>();
+  } else {
+    logger = std::make_unique<open_spiel::DataLoggerJsonLines>(
+        absl::GetFlag(FLAGS_stats_dir), "mcts_stats");
+  }
+  for (int threads = 1; threads <= absl::GetFlag(FLAGS_max_threads);
+       threads *= 2) {
+    for (int i = 0; i < absl::GetFlag(FLAGS_attempts); ++i) {
+      open_spiel::MCTSBenchmark(*game, threads, absl::GetFlag(FLAGS_batch_size),
+                                absl::GetFlag(FLAGS_simulations),
+                                absl::GetFlag(FLAGS_rollouts),
+                                absl::GetFlag(FLAGS_transposition_table_size),
+                                absl::GetFlag(FLAGS_max_time_ms),
+                                absl::GetFlag(FLAGS_stop_early),
+                                logger.get());
+    }
+  }
+}
@@ -0,0 +1,84 @@
+// Copyright 2019 DeepMind Technologies Ltd. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures MCTS simulations per second from the initial state of each game,
+// once copying the state for every simulation and rollout, and once playing
+// them on one state with UndoAction(). Games without undo support copy in both
+// runs.
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "open_spiel/abseil-cpp/absl/flags/flag.h"
+#include "open_spiel/abseil-cpp/absl/flags/parse.h"
+#include "open_spiel/abseil-cpp/absl/strings/str_format.h"
+#include "open_spiel/abseil-cpp/absl/strings/str_split.h"
+#include "open_spiel/abseil-cpp/absl/time/clock.h"
+#include "open_spiel/algorithms/mcts.h"
+#include "open_spiel/spiel.h"
+
+ABSL_FLAG(std::string, games,
+          "tic_tac_toe,connect_four,breakthrough,battle_chess",
+          "Comma-separated list of games to search.");
+ABSL_FLAG(int, simulations, 20000, "How many simulations to run per search.");
+ABSL_FLAG(int, rollouts, 1, "How many random rollouts per evaluation.");
+ABSL_FLAG(int, attempts, 3, "How many searches to run per game and mode.");
+
+namespace open_spiel {
+
+// Returns the simulations per second of one search.
+double MCTSUndoBenchmark(const Game& game, bool use_undo, int num_simulations,
+                         int num_rollouts) {
+  auto evaluator =
+      std::make_shared<algorithms::RandomRolloutEvaluator>(num_rollouts, 42);
+  algorithms::MCTSBot bot(game, evaluator, /*uct_c=*/2, num_simulations,
+                          /*max_memory_mb=*/1000, /*solve=*/true, /*seed=*/42,
+                          /*verbose=*/false,
+                          algorithms::ChildSelectionPolicy::UCT,
+                          /*dirichlet_alpha=*/0, /*dirichlet_epsilon=*/0,
+                          /*num_threads=*/1, /*batch_size=*/1,
+                          /*transposition_table_size=*/0, use_undo);
+  std::unique_ptr<State> state = game.NewInitialState();
+
+  absl::Time start = absl::Now();
+  const algorithms::SearchNode* root = bot.MCTSearch(*state);
+  double seconds = absl::ToDoubleSeconds(absl::Now() - start);
+  return root->explore_count / seconds;
+}
+
+}  // namespace open_spiel
+
+int main(int argc, char** argv) {
+  absl::ParseCommandLine(argc, argv);
+
+  const std::vector<std::string> names =
+      absl::StrSplit(absl::GetFlag(FLAGS_games), ',');
+  for (const std::string& name : names) {
+    auto game = open_spiel::LoadGame(name);
+    for (bool use_undo : {false, true}) {
+      std::string mode = use_undo ? "undo" : "clone";
+      if (use_undo && !game->GetType().provides_undo) mode += " (unsupported)";
+      for (int i = 0; i < absl::GetFlag(FLAGS_attempts); ++i) {
+        const double sims_per_second = open_spiel::MCTSUndoBenchmark(
+            *game, use_undo, absl::GetFlag(FLAGS_simulations),
+            absl::GetFlag(FLAGS_rollouts));
+        std::cout << absl::StrFormat("Benchmark: game: %s, %s: %.1f k sims/s",
+                                     name, mode, sims_per_second / 1e3)
+                  << std::endl;
+      }
+    }
+  }
+}
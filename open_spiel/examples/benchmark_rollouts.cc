@@ -0,0 +1,136 @@
+// Copyright 2019 DeepMind Technologies Ltd. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures how fast RandomRolloutEvaluator evaluates positions with many
+// rollouts each, with 1, 2, 4, ... threads. The positions are reached by random
+// play from the initial state. The first line per game is a reference
+// evaluator that copies the state for each rollout and picks moves from
+// LegalActions() with std::mt19937.
+
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "open_spiel/abseil-cpp/absl/flags/flag.h"
+#include "open_spiel/abseil-cpp/absl/flags/parse.h"
+#include "open_spiel/abseil-cpp/absl/strings/str_format.h"
+#include "open_spiel/abseil-cpp/absl/strings/str_split.h"
+#include "open_spiel/abseil-cpp/absl/time/clock.h"
+#include "open_spiel/algorithms/mcts.h"
+#include "open_spiel/spiel.h"
+
+ABSL_FLAG(std::string, games, "tic_tac_toe,connect_four,battle_chess",
+          "Comma-separated list of games to evaluate positions of.");
+ABSL_FLAG(int, positions, 200, "How many positions to evaluate per run.");
+ABSL_FLAG(int, rollouts, 64, "How many random rollouts per position.");
+ABSL_FLAG(int, max_threads, 8, "The largest number of threads to try.");
+
+namespace open_spiel {
+
+// Returns positions reached by a few random moves from the initial state.
+std::vector<std::unique_ptr<State>> RandomPositions(const Game& game,
+                                                    int num_positions) {
+  std::mt19937 rng(42);
+  std::vector<std::unique_ptr<State>> positions;
+  while (positions.size() < num_positions) {
+    std::unique_ptr<State> state = game.NewInitialState();
+    const int num_moves = rng() % 8;
+    for (int i = 0; i < num_moves && !state->IsTerminal(); ++i) {
+      if (state->IsChanceNode()) {
+        const double z = std::uniform_real_distribution<double>()(rng);
+        state->ApplyAction(SampleAction(state->ChanceOutcomes(), z).first);
+      } else {
+        std::vector<Action> actions = state->LegalActions();
+        state->ApplyAction(actions[rng() % actions.size()]);
+      }
+    }
+    if (!state->IsTerminal()) positions.push_back(std::move(state));
+  }
+  return positions;
+}
+
+// The rollouts as RandomRolloutEvaluator played them before it had tasks.
+double ReferenceRollouts(const State& state, int num_rollouts,
+                         std::mt19937* rng) {
+  double total = 0;
+  for (int i = 0; i < num_rollouts; ++i) {
+    std::unique_ptr<State> working_state = state.Clone();
+    while (!working_state->IsTerminal()) {
+      if (working_state->IsChanceNode()) {
+        const double z = std::uniform_real_distribution<double>()(*rng);
+        working_state->ApplyAction(
+            SampleAction(working_state->ChanceOutcomes(), z).first);
+      } else {
+        std::vector<Action> actions = working_state->LegalActions();
+        working_state->ApplyAction(actions[(*rng)() % actions.size()]);
+      }
+    }
+    total += working_state->Returns()[0];
+  }
+  return total / num_rollouts;
+}
+
+void Report(const std::string& name, const std::string& mode,
+            int num_positions, int num_rollouts, double seconds) {
+  std::cout << absl::StrFormat(
+                   "Benchmark: game: %s, %s: %.1f positions/s, "
+                   "%.1f k rollouts/s",
+                   name, mode, num_positions / seconds,
+                   num_positions * num_rollouts / seconds / 1e3)
+            << std::endl;
+}
+
+void RolloutBenchmark(const std::string& name, int num_positions,
+                      int num_rollouts, int max_threads) {
+  std::shared_ptr<const Game> game = LoadGame(name);
+  std::vector<std::unique_ptr<State>> positions =
+      RandomPositions(*game, num_positions);
+
+  std::mt19937 rng(42);
+  absl::Time start = absl::Now();
+  double sum = 0;
+  for (const std::unique_ptr<State>& state : positions) {
+    sum += ReferenceRollouts(*state, num_rollouts, &rng);
+  }
+  Report(name, "reference", num_positions, num_rollouts,
+         absl::ToDoubleSeconds(absl::Now() - start));
+
+  for (int threads = 1; threads <= max_threads; threads *= 2) {
+    algorithms::RandomRolloutEvaluator evaluator(num_rollouts, 42, threads);
+    start = absl::Now();
+    for (const std::unique_ptr<State>& state : positions) {
+      sum += evaluator.Evaluate(*state)[0];
+    }
+    Report(name, absl::StrFormat("%d threads", threads), num_positions,
+           num_rollouts, absl::ToDoubleSeconds(absl::Now() - start));
+  }
+  // Keeps the rollouts from being optimized away.
+  if (sum > num_positions * 1e9) std::cout << sum << std::endl;
+}
+
+}  // namespace open_spiel
+
+int main(int argc, char** argv) {
+  absl::ParseCommandLine(argc, argv);
+
+  const std::vector<std::string> names =
+      absl::StrSplit(absl::GetFlag(FLAGS_games), ',');
+  for (const std::string& name : names) {
+    open_spiel::RolloutBenchmark(name, absl::GetFlag(FLAGS_positions),
+                                 absl::GetFlag(FLAGS_rollouts),
+                                 absl::GetFlag(FLAGS_max_threads));
+  }
+}
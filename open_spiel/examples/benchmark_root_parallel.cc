@@ -0,0 +1,134 @@
+// Copyright 2019 DeepMind Technologies Ltd. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures playing strength per wall-clock second of root-parallel MCTS: a
+// RootParallelMCTSBot with 1, 2, 4, ... searches plays games against a serial
+// MCTSBot, both with the same time per move, taking each seat in turn. The
+// score is the root-parallel bot's mean return, so on a machine with enough
+// cores it should grow with the number of searches.
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "open_spiel/abseil-cpp/absl/flags/flag.h"
+#include "open_spiel/abseil-cpp/absl/flags/parse.h"
+#include "open_spiel/abseil-cpp/absl/random/distributions.h"
+#include "open_spiel/abseil-cpp/absl/strings/str_format.h"
+#include "open_spiel/abseil-cpp/absl/time/clock.h"
+#include "open_spiel/algorithms/mcts.h"
+#include "open_spiel/spiel.h"
+
+ABSL_FLAG(std::string, game, "connect_four", "The name of the game to play.");
+ABSL_FLAG(int, max_time_ms, 100, "The time per move of both bots.");
+ABSL_FLAG(int, rollouts, 1, "How many random rollouts per evaluation.");
+ABSL_FLAG(int, max_searches, 8, "The largest number of searches to try.");
+ABSL_FLAG(int, games, 20, "How many games to play per number of searches.");
+
+namespace open_spiel {
+
+void RootParallelBenchmark(const Game& game, int num_searches, int max_time_ms,
+                           int num_rollouts, int num_games) {
+  auto evaluator =
+      std::make_shared<algorithms::RandomRolloutEvaluator>(num_rollouts, 42);
+  auto serial_evaluator =
+      std::make_shared<algorithms::RandomRolloutEvaluator>(num_rollouts, 43);
+  double score = 0;
+  int wins = 0;
+  int losses = 0;
+  int64_t parallel_simulations = 0;
+  int64_t serial_simulations = 0;
+  int parallel_moves = 0;
+  int serial_moves = 0;
+  absl::Duration elapsed;
+  for (int i = 0; i < num_games; ++i) {
+    algorithms::RootParallelMCTSBot parallel(
+        game, evaluator, /*uct_c=*/2, /*max_simulations=*/0,
+        /*max_memory_mb=*/1000, /*solve=*/true, /*seed=*/42 + 100 * i,
+        /*verbose=*/false, num_searches, algorithms::ChildSelectionPolicy::UCT,
+        /*dirichlet_alpha=*/0, /*dirichlet_epsilon=*/0, max_time_ms);
+    algorithms::MCTSBot serial(
+        game, serial_evaluator, /*uct_c=*/2, /*max_simulations=*/0,
+        /*max_memory_mb=*/1000, /*solve=*/true, /*seed=*/43 + 100 * i,
+        /*verbose=*/false, algorithms::ChildSelectionPolicy::UCT,
+        /*dirichlet_alpha=*/0, /*dirichlet_epsilon=*/0, /*num_threads=*/1,
+        /*batch_size=*/1, /*transposition_table_size=*/0, /*use_undo=*/true,
+        max_time_ms);
+    const Player seat = i % 2;
+
+    // Plays the game here rather than with EvaluateBots() to count the
+    // simulations of each bot.
+    std::unique_ptr<State> state = game.NewInitialState();
+    std::mt19937 rng(i);
+    absl::Time start = absl::Now();
+    while (!state->IsTerminal()) {
+      Action action;
+      Bot* mover = nullptr;
+      if (state->IsChanceNode()) {
+        action = SampleAction(state->ChanceOutcomes(),
+                              absl::Uniform(rng, 0.0, 1.0)).first;
+      } else if (state->CurrentPlayer() == seat) {
+        action = parallel.Step(*state);
+        mover = &parallel;
+        parallel_simulations += parallel.simulations();
+        ++parallel_moves;
+      } else {
+        action = serial.Step(*state);
+        mover = &serial;
+        serial_simulations += serial.simulations();
+        ++serial_moves;
+      }
+      // Step() has already moved the mover's tree along its action.
+      for (Bot* bot : std::vector<Bot*>{&parallel, &serial}) {
+        if (bot != mover) {
+          bot->InformAction(*state, state->CurrentPlayer(), action);
+        }
+      }
+      state->ApplyAction(action);
+    }
+    elapsed += absl::Now() - start;
+    const double value = state->Returns()[seat];
+    score += value;
+    if (value > 0) ++wins;
+    if (value < 0) ++losses;
+  }
+  std::cout << absl::StrFormat(
+                   "Benchmark: game: %s, searches: %d, %d ms per move: "
+                   "score %+.3f (%d wins, %d draws, %d losses), "
+                   "%.1f k vs %.1f k sims/move, %.1f s",
+                   game.GetType().short_name, num_searches, max_time_ms,
+                   score / num_games, wins, num_games - wins - losses, losses,
+                   parallel_simulations / 1e3 / std::max(parallel_moves, 1),
+                   serial_simulations / 1e3 / std::max(serial_moves, 1),
+                   absl::ToDoubleSeconds(elapsed))
+            << std::endl;
+}
+
+}  // namespace open_spiel
+
+int main(int argc, char** argv) {
+  absl::ParseCommandLine(argc, argv);
+
+  auto game = open_spiel::LoadGame(absl::GetFlag(FLAGS_game));
+  SPIEL_CHECK_EQ(game->NumPlayers(), 2);
+  for (int searches = 1; searches <= absl::GetFlag(FLAGS_max_searches);
+       searches *= 2) {
+    open_spiel::RootParallelBenchmark(*game, searches,
+                                      absl::GetFlag(FLAGS_max_time_ms),
+                                      absl::GetFlag(FLAGS_rollouts),
+                                      absl::GetFlag(FLAGS_games));
+  }
+}
@@ -81,7 +81,9 @@ const GameType kGameType{
     /*provides_observation_tensor=*/true,
     /*parameter_specification=*/
     {{"scoring_type",
-      GameParameter(static_cast<std::string>(kDefaultScoringType))}}};
+      GameParameter(static_cast<std::string>(kDefaultScoringType))}},
+    /*default_loadable=*/true,
+    /*provides_undo=*/true};
 
 static std::shared_ptr<const Game> Factory(const GameParameters& params) {
   return std::shared_ptr<const Game>(new BackgammonGame(params));
@@ -15,29 +15,55 @@
 #include "open_spiel/games/battle_chess.h"
 
 #include <algorithm>
+#include <cctype>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "open_spiel/game_parameters.h"
-#include "open_spiel/tensor_view.h"
+#include "open_spiel/utils/random.h"
 
 namespace open_spiel {
 namespace battle_chess {
 namespace {
 
-// Number of unique directions each piece can take.
-constexpr int kNumDirections = 6;
-
-// Numbers of rows needed to have 2 full rows of pieces.
-constexpr int kNumRowsForFullPieces = 6;
-
-// Direction offsets for black, then white.
-constexpr std::array<int, kNumDirections> kDirRowOffsets = {
-    {1, 1, 1, -1, -1, -1}};
+// Last digit of the mixed-base action encoding (from row, from col, to row,
+// to col, capture). Only the values 0-6 are used, see getCaptureValue().
+constexpr int kNumCaptureValues = 9;
+
+// First byte of SerializeBinary() output, never used by the text format.
+constexpr char kBinaryFormatTag = '\xB1';
+// Second byte: whether the actions taken follow the board.
+constexpr char kBinaryBoardOnly = 0;
+constexpr char kBinaryWithHistory = 1;
+
+// Cell state shown in each plane of the observation tensor.
+constexpr std::array<CellState, kCellStates> kObservationPlanes = {
+    CellState::kBlackKing,     CellState::kBlackDefender,
+    CellState::kBlackAttacker, CellState::kWhiteKing,
+    CellState::kWhiteDefender, CellState::kWhiteAttacker,
+    CellState::kEmpty};
+
+// Writes one plane per entry of kObservationPlanes, each one value per
+// square. Exactly one plane is set for every square, so after a bulk clear
+// there are only NumSquares() stores left.
+template <typename T>
+void ExpandObservation(const BattleChessBoard& board, T* values) {
+  const int num_squares = board.NumSquares();
+  std::fill(values, values + kCellStates * num_squares, T{0});
+  for (int plane = 0; plane < kCellStates; ++plane) {
+    T* out = values + plane * num_squares;
+    for (Bitboard bits = board.bitboard(kObservationPlanes[plane]); bits;
+         bits &= bits - 1) {
+      out[__builtin_ctzll(bits)] = T{1};
+    }
+  }
+}
 
-constexpr std::array<int, kNumDirections> kDirColOffsets = {
-    {-1, 0, 1, -1, 0, 1}};
+// Upper bound on the destinations of a single piece (4 orthogonal + 4
+// diagonal), used to size the move list.
+constexpr int kMaxMovesPerPiece = 8;
 
 // Facts about the game
 const GameType kGameType{/*short_name=*/"battle_chess",
@@ -53,8 +79,14 @@ const GameType kGameType{/*short_name=*/"battle_chess",
                          /*provides_information_state_tensor=*/false,
                          /*provides_observation_string=*/true,
                          /*provides_observation_tensor=*/true,
-                         /*parameter_specification=*/{}
-};
+                         /*parameter_specification=*/
+                         {{"rows", GameParameter(kDefaultRows)},
+                          {"columns", GameParameter(kDefaultColumns)},
+                          {"fen", GameParameter(std::string(""))},
+                          {"no_capture_limit",
+                           GameParameter(kDefaultNoCaptureLimit)}},
+                         /*default_loadable=*/true,
+                         /*provides_undo=*/true};
 
 std::shared_ptr<const Game> Factory(const GameParameters& params) {
   return std::shared_ptr<const Game>(new BattleChessGame(params));
@@ -62,47 +94,6 @@ std::shared_ptr<const Game> Factory(const GameParameters& params) {
 
 REGISTER_SPIEL_GAME(kGameType, Factory);
 
-int StateToColor(CellState state){
-  switch (state) {
-    case CellState::kBlackKing:
-      return 1;
-    case CellState::kBlackDefender:
-      return 1;
-    case CellState::kBlackAttacker:
-      return 1;
-    case CellState::kWhiteKing:
-      return 0;
-    case CellState::kWhiteDefender:
-      return 0;
-    case CellState::kWhiteAttacker:
-      return 0;
-    case CellState::kEmpty:
-      return -1;
-  }
-}
-
-std::string CellToString(CellState state) {
-  switch (state) {
-    case CellState::kBlackKing:
-      return "k";
-    case CellState::kBlackDefender:
-      return "d";
-    case CellState::kBlackAttacker:
-      return "a";
-    case CellState::kWhiteKing:
-      return "K";
-    case CellState::kWhiteDefender:
-      return "D";
-    case CellState::kWhiteAttacker:
-      return "A";
-    case CellState::kEmpty:
-      return ".";
-    default:
-      SpielFatalError("Unrecognized cell state");
-  }
-}
-
-
 std::string RowLabel(int rows, int row) {
   std::string label = "";
   label += static_cast<char>('1' + (rows - 1 - row));
@@ -137,27 +128,6 @@ std::string PieceName(int capture) {
   return name;
 }
 
-// 根据capture 的值判断被吃掉的棋子类型
-CellState StateType(int capture) {
-  if(capture == 0){
-    return CellState::kEmpty;
-  } else if(capture == 1) {
-    return CellState::kWhiteAttacker;
-  } else if(capture == 2) {
-    return CellState::kWhiteDefender;
-  } else if(capture == 3) {
-    return CellState::kWhiteKing;
-  } else if(capture == 4) {
-    return CellState::kBlackAttacker;
-  } else if(capture == 5) {
-    return CellState::kBlackDefender;
-  } else if(capture == 6) {
-    return CellState::kBlackKing;
-  }
-  
-  SpielFatalError("wrong value");
-}
-
 // 根据被吃掉的棋子来获得 capture 的值
 int getCaptureValue(CellState state){
   if(state == CellState::kWhiteAttacker) {
@@ -177,307 +147,93 @@ int getCaptureValue(CellState state){
   }
 }
 
+// Square indices and capture value of an action id, see kNumCaptureValues.
+struct DecodedAction {
+  int from;
+  int to;
+  int capture;
+};
 
-
-}  // namespace
-
-BattleChessState::BattleChessState(std::shared_ptr<const Game> game)
-    : State(game){
-  SPIEL_CHECK_GT(rows_, 1);
-  SPIEL_CHECK_GT(cols_, 1);
-
-  board_ = std::vector<CellState>(rows_ * cols_, CellState::kEmpty);
-  // 放置黑棋
-  SetBoard(0, 0, CellState::kBlackAttacker);
-  AddPiece(0, 0, CellState::kBlackAttacker);
-
-  SetBoard(0, 1, CellState::kBlackDefender);
-  AddPiece(0, 1, CellState::kBlackDefender);
-
-  SetBoard(0, 2, CellState::kBlackKing);
-  AddPiece(0, 2, CellState::kBlackKing);
-
-  SetBoard(0, 3, CellState::kBlackDefender);
-  AddPiece(0, 3, CellState::kBlackDefender);
-
-  SetBoard(0, 4, CellState::kBlackAttacker);
-  AddPiece(0, 4, CellState::kBlackAttacker);
-
-  // 放置白棋
-  SetBoard(4, 0, CellState::kWhiteAttacker);
-  AddPiece(4, 0, CellState::kWhiteAttacker);
-
-  SetBoard(4, 1, CellState::kWhiteDefender);
-  AddPiece(4, 1, CellState::kWhiteDefender);
-
-  SetBoard(4, 2, CellState::kWhiteKing);
-  AddPiece(4, 2, CellState::kWhiteKing);
-
-  SetBoard(4, 3, CellState::kWhiteDefender);
-  AddPiece(4, 3, CellState::kWhiteDefender);
-
-  SetBoard(4, 4, CellState::kWhiteAttacker);
-  AddPiece(4, 4, CellState::kWhiteAttacker);
-
-  winner_ = kInvalidPlayer;
-  cur_player_ = 0;
-  total_moves_ = 0;
-}
-
-int BattleChessState::CurrentPlayer() const {
-  if (IsTerminal()) {
-    return kTerminalPlayerId;
-  } else {
-    return cur_player_;
-  }
-}
-
-void BattleChessState::AddPiece(int r, int c, CellState state){
-  Piece piece;
-  piece.row = r;
-  piece.col = c;
-  piece.pieceType = state;
-//   std::cout << "in AddPiece() func" << std::endl;
-//   std::cout << r << "-" << c << std::endl;
-//   std::cout << CellToString(piece.pieceType) << " :" << piece.row << "-" << piece.col << std::endl;
-  if (StateToColor(state) == 0) {
-    whitePieces.push_back(piece);
-  } else {
-    blackPieces.push_back(piece);
-  }
+DecodedAction DecodeAction(Action action, int num_squares) {
+  const int capture = action % kNumCaptureValues;
+  const int squares = action / kNumCaptureValues;
+  return {squares / num_squares, squares % num_squares, capture};
 }
 
-// 先根据 state 来判断颜色
-// 再走上同的Pieces 数组里面匹配位置相同的， 若相同， 则删除该棋子
-void BattleChessState::DeletePiece(int r, int c, CellState state){
-  // 检查是否有匹配的棋子的flag
-  bool flag = false;
-  if (StateToColor(state) == 0) {
-    for(auto piece = whitePieces.begin(); piece != whitePieces.end(); piece ++) {
-      if(piece->row == r && piece->col == c){
-        whitePieces.erase(piece);
-        flag = true;
-        break;
-      }
-    }
-  } else {
-    for(auto piece = blackPieces.begin(); piece != blackPieces.end(); piece ++) {
-      if(piece->row == r && piece->col == c){
-        blackPieces.erase(piece);
-        flag = true;
-        break;
-      }
-    }
-  }
-  if(!flag){
-    SpielFatalError("can not find piece in" + std::to_string(r) + " : " + std::to_string(c));
-  }
+Action EncodeAction(int from, int to, int capture, int num_squares) {
+  return (from * num_squares + to) * kNumCaptureValues + capture;
 }
 
-// 将所有棋子都清空
-void BattleChessState::InitPieces(int color){
-  if (color == 0) {
-    whitePieces.clear();
-  } else if(color == 1){
-    blackPieces.clear();
+BattleChessBoard BoardFromParameters(const MoveTables* tables,
+                                    const std::string& fen) {
+  if (fen.empty()) return MakeDefaultBoard(tables);
+  auto maybe_board = BattleChessBoard::BoardFromFEN(fen, tables);
+  if (!maybe_board) {
+    SpielFatalError(absl::StrCat("Invalid battle_chess fen: ", fen));
   }
+  return *maybe_board;
 }
 
-// 输出保存棋子的状态
-void BattleChessState::getPiecesStatus() {
-    std::cout<< "white piece: " << std::endl;
-    for(int i = 0; i < whitePieces.size(); i ++) {
-      std::cout<< CellToString(whitePieces[i].pieceType) << " :" << whitePieces[i].row << "-" << whitePieces[i].col << std::endl;
-    }
-
-    std::cout<< "black piece: " << std::endl;
-    for(int i = 0; i < blackPieces.size(); i ++) {
-      std::cout<< CellToString(blackPieces[i].pieceType) << " :" << blackPieces[i].row << "-" << blackPieces[i].col << std::endl;
-    }
-  }
+}  // namespace
 
-// 根据 king 的位置推断出 king 的落子
-// 返回位置是起始位置以及落子位置
-// 只判断是不是超出了边界而不判断是不是有同种颜色的棋子
-void KingAction(int r1, int c1, std::vector<std::vector<int>> &kingActions){
-  std::vector<int> target(5, 0);
-  int r2 = 0;
-  int c2 = 0;
-  // 方向数组
-  // 前后左右四个方向
-  int dir[4][2] = {
-    {0, 1},
-    {0, -1},
-    {1, 0},
-    {-1, 0},
-  };
-  for(int i = 0; i < 4; i++) {
-    target[0] = r1;
-    target[1] = c1;
-    target[2] = r1 + dir[i][0];
-    target[3] = c1 + dir[i][1];
-    // 这里检查 落子位置是不是在界内
-    kingActions.push_back(target);
-  }
+BattleChessState::BattleChessState(std::shared_ptr<const Game> game)
+    : BattleChessState(
+          game,
+          static_cast<const BattleChessGame*>(game.get())->InitialBoard()) {}
+
+BattleChessState::BattleChessState(std::shared_ptr<const Game> game,
+                                   const BattleChessBoard& board)
+    : State(game),
+      board_(board),
+      no_capture_limit_(
+          static_cast<const BattleChessGame*>(game.get())->NoCaptureLimit()) {
+  SPIEL_CHECK_EQ(&board_.Tables(),
+                 static_cast<const BattleChessGame*>(game_.get())->Tables());
+  no_legal_moves_ = !board_.HasLegalMoves();
 }
 
-// 根据 Defender 的位置推断出 Defender 的落子
-// 返回位置是起始位置以及落子位置
-// 只判断是不是超出了边界而不判断是不是有同种颜色的棋子
-void DefenderAction(int r1, int c1, std::vector<std::vector<int>> &defenderActions){
-  std::vector<int> target(5, 0);
-  int r2 = 0;
-  int c2 = 0;
-
-  // 方向数组1
-  // 前后左右四个方向
-  int dir1[4][2] = {
-    {0, 1},
-    {0, -1},
-    {1, 0},
-    {-1, 0},
-  };
-
-  // 方向数组2
-  // 4个斜角方向
-  int dir2[4][2] = {
-    {1, 1},
-    {1 -1},
-    {-1, -1},
-    {-1, 1},
-  };
-
-  // 前后左右四个方向，只能移动不能吃
-  for(int i = 0; i < 4; i++) {
-    target[0] = r1;
-    target[1] = c1;
-    target[2] = r1 + dir1[i][0];
-    target[3] = c1 + dir1[i][1];
-    defenderActions.push_back(target);
-  }
-
-  // 四个斜角方向只能吃，不能干移动
-  // capture 值设为 -1 是为了后面的检查
-  target[4] = -1;
-  for(int i = 0; i < 4; i++) {
-    target[0] = r1;
-    target[1] = c1;
-    target[2] = r1 + dir2[i][0];
-    target[3] = c1 + dir2[i][1];
-    defenderActions.push_back(target);
+int BattleChessState::CurrentPlayer() const {
+  if (IsTerminal()) {
+    return kTerminalPlayerId;
+  } else {
+    return ToInt(board_.ToPlay());
   }
 }
 
-// 根据 Attacker 的位置推断出 Attacker 的落子
-// 返回位置是起始位置以及落子位置
-// 只判断是不是超出了边界而不判断是不是有同种颜色的棋子
-void AttackerAction(int r1, int c1, std::vector<std::vector<int>> &attackerActions){
-  std::vector<int> target(5, 0);
-  int r2 = 0;
-  int c2 = 0;
-
-  // 方向数组1
-  // 前后左右四个方向
-  int dir1[4][2] = {
-    {0, 1},
-    {0, -1},
-    {1, 0},
-    {-1, 0},
-  };
-
-  // 方向数组2
-  // 4个斜角方向
-  int dir2[4][2] = {
-    {1, 1},
-    {1 -1},
-    {-1, -1},
-    {-1, 1},
-  };
-
-  // 四个斜角方向只能移动不能吃
-  for(int i = 0; i < 4; i++) {
-    target[0] = r1;
-    target[1] = c1;
-    target[2] = r1 + dir2[i][0];
-    target[3] = c1 + dir2[i][1];
-    // 这里检查 落子位置是不是在界内
-    attackerActions.push_back(target);
-  }
-
-  // 前后左右四个方向，只能吃不能移动
-  // capture 值设为 -1 是为了后面的检查
-  target[4] = -1;
-  for(int i = 0; i < 4; i++) {
-    target[0] = r1;
-    target[1] = c1;
-    target[2] = r1 + dir1[i][0];
-    target[3] = c1 + dir1[i][1];
-    // 这里检查 落子位置是不是在界内
-    attackerActions.push_back(target);
-  }
+void BattleChessState::DoApplyAction(Action action) {
+  const DecodedAction move = DecodeAction(action, board_.NumSquares());
+  SPIEL_CHECK_EQ(move.capture, getCaptureValue(board_.at(move.to)));
+  undo_stack_.push_back(board_.ApplyMove(
+      Move{static_cast<int8_t>(move.from), static_cast<int8_t>(move.to)}));
+  repetition_draw_ = NumRepetitions() >= kNumRepetitionsToDraw;
+  no_legal_moves_ = !board_.HasLegalMoves();
 }
 
-void BattleChessState::DoApplyAction(Action action) {
-  std::vector<int> values(5, -1);
-  UnrankActionMixedBase(action, {rows_, cols_, rows_, cols_, 9}, &values);
-  int r1 = values[0];
-  int c1 = values[1];
-  int r2 = values[2];
-  int c2 = values[3];
-  int capture = values[4];
-
-  SPIEL_CHECK_TRUE(InBounds(r1, c1));
-  SPIEL_CHECK_TRUE(InBounds(r2, c2));
-  //   std::cout<<r1<< "-"<< c1<< "/" << r2 << "-" << c2 <<std::endl;
-  // capture == 0 只是移动棋子，不吃对方棋子
-  // capture > 0 吃棋行为
-  // 1,2,3 白方 A,D,K
-  // 4,5,6 黑方 a,d,k
-  if (capture > 0) {
-    // 不能吃掉同种棋
-    SPIEL_CHECK_EQ(1 - StateToColor(board(r2, c2)), StateToColor(board(r1, c1)));
-
-    //删除被吃掉的棋
-    DeletePiece(r2, c2, board(r2, c2));
-
-    // 判断胜负
-    if(board(r2, c2) == CellState::kBlackKing) {
-      winner_ = 0;
-    }
-    if(board(r2, c2) == CellState::kWhiteKing) {
-      winner_ = 1;
-    }
+int BattleChessState::NumRepetitions() const {
+  // A capture cannot be undone, so only the positions since the last one can
+  // repeat, and of those only every second one has the same side to play.
+  const int num_records = undo_stack_.size();
+  const int lookback =
+      std::min<int>(board_.IrreversibleMoveCounter(), num_records);
+  int repetitions = 1;
+  for (int i = 2; i <= lookback; i += 2) {
+    if (undo_stack_[num_records - i].hash == board_.HashValue()) ++repetitions;
   }
-
-  // 下面的两个判断是为了变更棋子的位置
-  DeletePiece(r1, c1, board(r1, c1));
-  AddPiece(r2, c2, board(r1, c1));
-
-  SetBoard(r2, c2, board(r1, c1));
-  SetBoard(r1, c1, CellState::kEmpty);
-
-  // getPiecesStatus();
-  // 切换 player
-  cur_player_ = NextPlayerRoundRobin(cur_player_, kNumPlayers);
-  total_moves_++;
+  return repetitions;
 }
 
 std::string BattleChessState::ActionToString(Player player,
                                               Action action) const {
-  std::vector<int> values(5, -1);
-  UnrankActionMixedBase(action, {rows_, cols_, rows_, cols_, 9}, &values);
-  int r1 = values[0];
-  int c1 = values[1];
-  int r2 = values[2];
-  int c2 = values[3];
-  int capture = values[4];
+  const DecodedAction move = DecodeAction(action, board_.NumSquares());
+  const Square from = board_.IndexToSquare(move.from);
+  const Square to = board_.IndexToSquare(move.to);
 
   std::string action_string = "";
-  absl::StrAppend(&action_string, ColLabel(c1));
-  absl::StrAppend(&action_string, RowLabel(rows_, r1));
-  absl::StrAppend(&action_string, ColLabel(c2));
-  absl::StrAppend(&action_string, RowLabel(rows_, r2));
-  absl::StrAppend(&action_string, PieceName(capture));
+  absl::StrAppend(&action_string, ColLabel(from.x));
+  absl::StrAppend(&action_string, RowLabel(rows(), from.y));
+  absl::StrAppend(&action_string, ColLabel(to.x));
+  absl::StrAppend(&action_string, RowLabel(rows(), to.y));
+  absl::StrAppend(&action_string, PieceName(move.capture));
 
   return action_string;
 }
@@ -485,310 +241,43 @@ std::string BattleChessState::ActionToString(Player player,
 std::vector<Action> BattleChessState::LegalActions() const {
   std::vector<Action> movelist;
   if (IsTerminal()) return movelist;
-  const Player player = CurrentPlayer();
-  std::vector<int> action_bases = {rows_, cols_, rows_, cols_, 9};
-  std::vector<int> action_values = {0, 0, 0, 0, 0};
-
-  if (player == 0 ) {
-    for(int i = 0; i < whitePieces.size(); i ++) {
-
-      // King 的合法动作
-      if(whitePieces[i].pieceType == CellState::kWhiteKing) {
-        std::vector<std::vector<int>> kingActions;
-
-        // 检查棋子位置是否合法
-        SPIEL_CHECK_TRUE(InBounds(whitePieces[i].row, whitePieces[i].col));
-
-        // 根据king的位置来推断落子位置
-        // 只进行了是否在边界内的检查
-        KingAction(whitePieces[i].row, whitePieces[i].col, kingActions);
-
-        // 对每个待定动作做进一步检查
-        // 如果合法， 则加入 movelist
-        for(int i = 0; i < kingActions.size(); i ++) {
-
-          // 落子位置是不是在界内
-          if(!InBounds(kingActions[i][2], kingActions[i][3])) continue;
-
-          // 白色为0， 黑色为1， 空白为 -1
-          // 颜色的值必须不同
-          if(StateToColor(board(kingActions[i][0], kingActions[i][1])) != StateToColor(board(kingActions[i][2], kingActions[i][3]))) {
-            // 如果落子位置不为空， 则需要根据棋子类型得到capture的值
-            if (StateToColor(board(kingActions[i][2], kingActions[i][3])) != -1) {
-              kingActions[i][4] = getCaptureValue(board(kingActions[i][2], kingActions[i][3]));
-            }
-            movelist.push_back(
-                  RankActionMixedBase(action_bases, kingActions[i]));
-          }
-        }
-      }  // if King
-
-      // Defender 的合法动作
-      if(whitePieces[i].pieceType == CellState::kWhiteDefender) {
-        std::vector<std::vector<int>> defenderActions;
-
-        // 检查棋子位置是否合法
-        SPIEL_CHECK_TRUE(InBounds(whitePieces[i].row, whitePieces[i].col));
-
-        // 根据king的位置来推断落子位置
-        // 只进行了是否在边界内的检查
-        DefenderAction(whitePieces[i].row, whitePieces[i].col, defenderActions);
-
-        // 对每个待定动作做进一步检查
-        // 如果合法， 则加入 movelist
-        for(int i = 0; i < defenderActions.size(); i ++) {
-
-          // 落子位置是不是在界内
-          if(!InBounds(defenderActions[i][2], defenderActions[i][3])) continue;
-
-          // capture 的值为0的时候，则需要落子位置为空
-          // capture 的值为-1的时候，则需要落子位置为另一种颜色的棋
-          if(defenderActions[i][4] == 0) {
-            if(StateToColor(board(defenderActions[i][2], defenderActions[i][3])) == -1) {
-              movelist.push_back(
-                  RankActionMixedBase(action_bases, defenderActions[i]));
-            }
-          }
-
-          // 需要吃子
-          if(defenderActions[i][4] == -1) {
-            if(StateToColor(board(defenderActions[i][2], defenderActions[i][3])) == 1) {
-              // 需要变更capture的值
-              defenderActions[i][4] = getCaptureValue(board(defenderActions[i][2], defenderActions[i][3]));
-              movelist.push_back(
-                  RankActionMixedBase(action_bases, defenderActions[i]));
-            }
-          }
-        }
-      }  // if Defender
-
-      // Attacker 的合法动作
-      if(whitePieces[i].pieceType == CellState::kWhiteAttacker) {
-        std::vector<std::vector<int>> attackerActions;
-
-        // 检查棋子位置是否合法
-        SPIEL_CHECK_TRUE(InBounds(whitePieces[i].row, whitePieces[i].col));
-
-        // 根据king的位置来推断落子位置
-        // 只进行了是否在边界内的检查
-        AttackerAction(whitePieces[i].row, whitePieces[i].col, attackerActions);
-
-        // 对每个待定动作做进一步检查
-        // 如果合法， 则加入 movelist
-        for(int i = 0; i < attackerActions.size(); i ++) {
-
-          // 落子位置是不是在界内
-          if(!InBounds(attackerActions[i][2], attackerActions[i][3])) continue;
-
-          // capture 的值为0的时候，则需要落子位置为空
-          // capture 的值为-1的时候，则需要落子位置为另一种颜色的棋
-          if(attackerActions[i][4] == 0) {
-            if(StateToColor(board(attackerActions[i][2], attackerActions[i][3])) == -1) {
-              movelist.push_back(
-                  RankActionMixedBase(action_bases, attackerActions[i]));
-            }
-          }
-
-          // 需要吃子
-          if(attackerActions[i][4] == -1) {
-            if(StateToColor(board(attackerActions[i][2], attackerActions[i][3])) == 1) {
-              // 需要变更capture的值
-              attackerActions[i][4] = getCaptureValue(board(attackerActions[i][2], attackerActions[i][3]));
-              movelist.push_back(
-                  RankActionMixedBase(action_bases, attackerActions[i]));
-            }
-          }
-        }
-      }  // if Attacker
-    } // for
-  } // player == 0
-
-  if (player == 1 ) {
-    for(int i = 0; i < blackPieces.size(); i ++) {
-
-      // King 的合法动作
-      if(blackPieces[i].pieceType == CellState::kBlackKing) {
-        std::vector<std::vector<int>> kingActions;
-
-        // 检查棋子位置是否合法
-        SPIEL_CHECK_TRUE(InBounds(blackPieces[i].row, blackPieces[i].col));
-
-        // 根据king的位置来推断落子位置
-        // 只进行了是否在边界内的检查
-        KingAction(blackPieces[i].row, blackPieces[i].col, kingActions);
-
-        // 对每个待定动作做进一步检查
-        // 如果合法， 则加入 movelist
-        for(int i = 0; i < kingActions.size(); i ++) {
-
-          // 落子位置是不是在界内
-          if(!InBounds(kingActions[i][2], kingActions[i][3])) continue;
-
-          // 白色为0， 黑色为1， 空白为 -1
-          // 颜色的值必须不同
-          if(StateToColor(board(kingActions[i][0], kingActions[i][1])) != StateToColor(board(kingActions[i][2], kingActions[i][3]))) {
-            // 如果落子位置不为空， 则需要根据棋子类型得到capture的值
-            if (StateToColor(board(kingActions[i][2], kingActions[i][3])) != -1) {
-              kingActions[i][4] = getCaptureValue(board(kingActions[i][2], kingActions[i][3]));
-            }
-            movelist.push_back(
-                  RankActionMixedBase(action_bases, kingActions[i]));
-          }
-        }
-      }  // if King
-
-      // Defender 的合法动作
-      if(blackPieces[i].pieceType == CellState::kBlackDefender) {
-        std::vector<std::vector<int>> defenderActions;
-
-        // 检查棋子位置是否合法
-        SPIEL_CHECK_TRUE(InBounds(blackPieces[i].row, blackPieces[i].col));
-
-        // 根据king的位置来推断落子位置
-        // 只进行了是否在边界内的检查
-        DefenderAction(blackPieces[i].row, blackPieces[i].col, defenderActions);
-
-        // 对每个待定动作做进一步检查
-        // 如果合法， 则加入 movelist
-        for(int i = 0; i < defenderActions.size(); i ++) {
-
-          // 落子位置是不是在界内
-          if(!InBounds(defenderActions[i][2], defenderActions[i][3])) continue;
-
-          // capture 的值为0的时候，则需要落子位置为空
-          // capture 的值为-1的时候，则需要落子位置为另一种颜色的棋
-          if(defenderActions[i][4] == 0) {
-            if(StateToColor(board(defenderActions[i][2], defenderActions[i][3])) == -1) {
-              movelist.push_back(
-                  RankActionMixedBase(action_bases, defenderActions[i]));
-            }
-          }
-
-          // 需要吃子
-          if(defenderActions[i][4] == -1) {
-            if(StateToColor(board(defenderActions[i][2], defenderActions[i][3])) == 0) {
-              // 需要变更capture的值
-              defenderActions[i][4] = getCaptureValue(board(defenderActions[i][2], defenderActions[i][3]));
-              movelist.push_back(
-                  RankActionMixedBase(action_bases, defenderActions[i]));
-            }
-          }
-        }
-      }  // if Defender
-
-      // Attacker 的合法动作
-      if(blackPieces[i].pieceType == CellState::kBlackAttacker) {
-        std::vector<std::vector<int>> attackerActions;
-
-        // 检查棋子位置是否合法
-        SPIEL_CHECK_TRUE(InBounds(blackPieces[i].row, blackPieces[i].col));
-
-        // 根据king的位置来推断落子位置
-        // 只进行了是否在边界内的检查
-        AttackerAction(blackPieces[i].row, blackPieces[i].col, attackerActions);
-
-        // 对每个待定动作做进一步检查
-        // 如果合法， 则加入 movelist
-        for(int i = 0; i < attackerActions.size(); i ++) {
-
-          // 落子位置是不是在界内
-          if(!InBounds(attackerActions[i][2], attackerActions[i][3])) continue;
-
-          // capture 的值为0的时候，则需要落子位置为空
-          // capture 的值为-1的时候，则需要落子位置为另一种颜色的棋
-          if(attackerActions[i][4] == 0) {
-            if(StateToColor(board(attackerActions[i][2], attackerActions[i][3])) == -1) {
-              movelist.push_back(
-                  RankActionMixedBase(action_bases, attackerActions[i]));
-            }
-          }
-
-          // 需要吃子
-          if(attackerActions[i][4] == -1) {
-            if(StateToColor(board(attackerActions[i][2], attackerActions[i][3])) == 0) {
-              // 需要变更capture的值
-              attackerActions[i][4] = getCaptureValue(board(attackerActions[i][2], attackerActions[i][3]));
-              movelist.push_back(
-                  RankActionMixedBase(action_bases, attackerActions[i]));
-            }
-          }
-        }
-      }  // if Attacker
-    } // for
-  } // player == 1
-
-//   std::vector<int> val(5, -1);
-//   for (auto ac : movelist) {
-//     UnrankActionMixedBase(ac, {rows_, cols_, rows_, cols_, 9}, &val);
-//     std::cout << val[0] << " " <<val[1] << " " << val[2] << " " << val[3] << " " << val[4] << " " << "\n";
-//   }
-  std::sort(movelist.begin(), movelist.end());
+  movelist.reserve(board_.pieces(board_.ToPlay()).size() * kMaxMovesPerPiece);
+  // The board generates moves in increasing (from, to) order, so the action
+  // ids come out sorted.
+  board_.GenerateLegalMoves([this, &movelist](const Move& move) {
+    movelist.push_back(EncodeAction(move.from, move.to,
+                                    getCaptureValue(board_.at(move.to)),
+                                    board_.NumSquares()));
+  });
   return movelist;
 }
 
+Action BattleChessState::UniformRandomLegalAction(double z) const {
+  SPIEL_CHECK_FALSE(IsTerminal());
+  const Move move = board_.LegalMoveAt(z);
+  return EncodeAction(move.from, move.to, getCaptureValue(board_.at(move.to)),
+                      board_.NumSquares());
+}
+
 bool BattleChessState::InBounds(int r, int c) const {
-  return (r >= 0 && r < rows_ && c >= 0 && c < cols_);
+  return board_.InBoardArea(Square{static_cast<int8_t>(c),
+                                   static_cast<int8_t>(r)});
 }
 
 std::string BattleChessState::ToString() const {
-  std::string result = "";
-
-  for (int r = 0; r < rows_; r++) {
-    absl::StrAppend(&result, RowLabel(rows_, r));
-
-    for (int c = 0; c < cols_; c++) {
-      absl::StrAppend(&result, CellToString(board(r, c)));
-    }
-
-    result.append("\n");
-  }
-
-  absl::StrAppend(&result, " ");
-  for (int c = 0; c < cols_; c++) {
-    absl::StrAppend(&result, ColLabel(c));
-  }
-  absl::StrAppend(&result, "\n");
-
-  return result;
-}
-
-int BattleChessState::observation_plane(int r, int c) const {
-  int plane = -1;
-  switch (board(r, c)) {
-    case CellState::kBlackKing:
-      plane = 0;
-      break;
-    case CellState::kBlackDefender:
-      plane = 1;
-      break;
-    case CellState::kBlackAttacker:
-      plane = 2;
-      break;
-    case CellState::kWhiteKing:
-      plane = 3;
-      break;
-    case CellState::kWhiteDefender:
-      plane = 4;
-      break;
-    case CellState::kWhiteAttacker:
-      plane = 5;
-      break;
-    case CellState::kEmpty:
-      plane = 6;
-      break;
-  }
-
-  return plane;
+  return board_.DebugString();
 }
 
 bool BattleChessState::IsTerminal() const {
-  return (winner_ >= 0);
+  return !board_.HasKing(Color::kWhite) || !board_.HasKing(Color::kBlack) ||
+         board_.IrreversibleMoveCounter() >= no_capture_limit_ ||
+         repetition_draw_ || no_legal_moves_;
 }
 
 std::vector<double> BattleChessState::Returns() const {
-  if (winner_ == 0) {
+  if (!board_.HasKing(Color::kBlack)) {
     return {1.0, -1.0};
-  } else if (winner_ == 1) {
+  } else if (!board_.HasKing(Color::kWhite)) {
     return {-1.0, 1.0};
   } else {
     return {0.0, 0.0};
@@ -801,52 +290,33 @@ std::string BattleChessState::ObservationString(Player player) const {
   return ToString();
 }
 
-// ??
 void BattleChessState::ObservationTensor(Player player,
                                           std::vector<double>* values) const {
   SPIEL_CHECK_GE(player, 0);
   SPIEL_CHECK_LT(player, num_players_);
+  values->resize(kCellStates * board_.NumSquares());
+  ExpandObservation(board_, values->data());
+}
 
-  TensorView<3> view(values, {kCellStates, rows_, cols_}, true);
-
-  for (int r = 0; r < rows_; r++) {
-    for (int c = 0; c < cols_; c++) {
-      int plane = observation_plane(r, c);
-      SPIEL_CHECK_TRUE(plane >= 0 && plane < kCellStates);
-      view[{plane, r, c}] = 1.0;
-    }
-  }
+void BattleChessState::ObservationTensor(Player player,
+                                          absl::Span<float> values) const {
+  SPIEL_CHECK_GE(player, 0);
+  SPIEL_CHECK_LT(player, num_players_);
+  SPIEL_CHECK_EQ(values.size(), kCellStates * board_.NumSquares());
+  ExpandObservation(board_, values.data());
 }
 
 void BattleChessState::UndoAction(Player player, Action action) {
-  std::vector<int> values(5, -1);
-  UnrankActionMixedBase(action, {rows_, cols_, rows_, cols_, 9}, &values);
-  int r1 = values[0];
-  int c1 = values[1];
-  int r2 = values[2];
-  int c2 = values[3];
-  int capture = values[4];
-
-  SPIEL_CHECK_TRUE(InBounds(r1, c1));
-  SPIEL_CHECK_TRUE(InBounds(r2, c2));
-
-  cur_player_ = PreviousPlayerRoundRobin(cur_player_, 2);
-  total_moves_--;
-
-  // Undo win status.
-  winner_ = kInvalidPlayer;
-
-  // Move back the piece, and put back the opponent's piece if necessary.
-  // The move is (r1, c1) -> (r2, c2) where r is row and c is column.
-  SetBoard(r1, c1, board(r2, c2));
-  SetBoard(r2, c2, CellState::kEmpty);
-  
-  // 如果吃子了， 则需要在r2, c2 上放置一个棋子
-  if (capture > 0) {
-    CellState state = StateType(capture);
-    SetBoard(r2, c2, state);
-    AddPiece(r2, c2, state);
-  }
+  SPIEL_CHECK_FALSE(undo_stack_.empty());
+  const MoveRecord record = undo_stack_.back();
+  undo_stack_.pop_back();
+  SPIEL_CHECK_EQ(action, EncodeAction(record.move.from, record.move.to,
+                                      getCaptureValue(record.captured),
+                                      board_.NumSquares()));
+  board_.UndoMove(record);
+  // Moves are only made from non-terminal positions.
+  repetition_draw_ = false;
+  no_legal_moves_ = false;
   history_.pop_back();
 }
 
@@ -855,74 +325,134 @@ std::unique_ptr<State> BattleChessState::Clone() const {
 }
 
 BattleChessGame::BattleChessGame(const GameParameters& params)
-    : Game(kGameType, params){}
+    : Game(kGameType, params),
+      rows_(ParameterValue<int>("rows")),
+      cols_(ParameterValue<int>("columns")),
+      tables_(MakeMoveTables(rows_, cols_)),
+      initial_board_(
+          BoardFromParameters(tables_.get(),
+                              ParameterValue<std::string>("fen"))),
+      no_capture_limit_(ParameterValue<int>("no_capture_limit")) {
+  SPIEL_CHECK_GT(no_capture_limit_, 0);
+  const int num_pieces = initial_board_.pieces(Color::kWhite).size() +
+                         initial_board_.pieces(Color::kBlack).size();
+  max_game_length_ = std::max(num_pieces - 1, 1) * no_capture_limit_;
+}
 
 int BattleChessGame::NumDistinctActions() const {
-  return rows_ * cols_ * rows_ * cols_ * 9;
+  return rows_ * cols_ * rows_ * cols_ * kNumCaptureValues;
 }
 
 std::string BattleChessState::Serialize() const {
   std::string str = "";
-  for (int r = 0; r < rows_; r++) {
-    for (int c = 0; c < cols_; c++) {
-      absl::StrAppend(&str, CellToString(board(r, c)));
+  for (int r = 0; r < rows(); r++) {
+    for (int c = 0; c < cols(); c++) {
+      absl::StrAppend(&str, CellStateToString(board(r, c)));
     }
   }
   return str;
 }
 
+uint64_t BattleChessState::HashValue() const {
+  return board_.HashValue() ^
+         SplitMix64(board_.IrreversibleMoveCounter())();
+}
+
+std::string BattleChessState::SerializeBinary(bool include_history) const {
+  std::string str;
+  str.push_back(kBinaryFormatTag);
+  if (!include_history) {
+    str.push_back(kBinaryBoardOnly);
+    board_.AppendBinary(&str);
+    return str;
+  }
+
+  // The history is replayed from the position it started at, which need not
+  // be the game's initial board (e.g. after DeserializeState()).
+  BattleChessBoard start = board_;
+  for (auto it = undo_stack_.rbegin(); it != undo_stack_.rend(); ++it) {
+    start.UndoMove(*it);
+  }
+  str.push_back(kBinaryWithHistory);
+  start.AppendBinary(&str);
+  AppendUint32(undo_stack_.size(), &str);
+  for (const MoveRecord& record : undo_stack_) {
+    AppendUint16(record.move.from | record.move.to << 6, &str);
+  }
+  return str;
+}
+
+std::unique_ptr<State> BattleChessGame::DeserializeBinary(
+    absl::string_view data) const {
+  if (data.size() < 2 || data[0] != kBinaryFormatTag ||
+      (data[1] != kBinaryBoardOnly && data[1] != kBinaryWithHistory)) {
+    SpielFatalError("Not a binary battle_chess state.");
+  }
+  const bool with_history = data[1] == kBinaryWithHistory;
+  data.remove_prefix(2);
+
+  std::optional<BattleChessBoard> board =
+      BattleChessBoard::BoardFromBinary(&data, tables_.get());
+  if (!board) SpielFatalError("Invalid binary battle_chess board.");
+  std::unique_ptr<BattleChessState> state(
+      new BattleChessState(shared_from_this(), *board));
+  if (!with_history) {
+    SPIEL_CHECK_TRUE(data.empty());
+    return state;
+  }
+
+  uint32_t num_moves;
+  if (!ConsumeUint32(&data, &num_moves) ||
+      data.size() != static_cast<uint64_t>(num_moves) * 2) {
+    SpielFatalError("Invalid binary battle_chess history.");
+  }
+  const int num_squares = tables_->num_squares;
+  for (uint32_t i = 0; i < num_moves; ++i) {
+    uint16_t move;
+    if (!ConsumeUint16(&data, &move)) {
+      SpielFatalError("Invalid binary battle_chess history.");
+    }
+    const int from = move & 0x3F;
+    const int to = move >> 6;
+    if (from >= num_squares || to >= num_squares) {
+      SpielFatalError("Invalid move in binary battle_chess history.");
+    }
+    const Action action = EncodeAction(
+        from, to, getCaptureValue(state->Board().at(to)), num_squares);
+    const std::vector<Action> legal_actions = state->LegalActions();
+    if (std::find(legal_actions.begin(), legal_actions.end(), action) ==
+        legal_actions.end()) {
+      SpielFatalError("Illegal move in binary battle_chess history.");
+    }
+    state->ApplyAction(action);
+  }
+  return state;
+}
+
 std::unique_ptr<State> BattleChessGame::DeserializeState(
     const std::string& str) const {
-  std::unique_ptr<State> state = NewInitialState();
-
+  if (!str.empty() && str[0] == kBinaryFormatTag) {
+    return DeserializeBinary(str);
+  }
   if (str.length() != rows_ * cols_) {
     SpielFatalError("Incorrect number of characters in string.");
     return std::unique_ptr<State>();
   }
 
-  BattleChessState* bstate = dynamic_cast<BattleChessState*>(state.get());
-
-//   bstate->SetPieces(0, 0);
-//   bstate->SetPieces(1, 0);
-  // 分别对白棋和黑棋进行清空
-  bstate->InitPieces(0);
-  bstate->InitPieces(1);
-
-  int i = 0;
-  for (int r = 0; r < rows_; r++) {
-    for (int c = 0; c < cols_; c++) {
-      if (str.at(i) == 'k') {
-        bstate->AddPiece(r, c, CellState::kBlackKing);
-        bstate->SetBoard(r, c, CellState::kBlackKing);
-      } else if (str.at(i) == 'd') {
-        bstate->AddPiece(r, c, CellState::kBlackDefender);
-        bstate->SetBoard(r, c, CellState::kBlackDefender);
-      } else if (str.at(i) == 'a') {
-        bstate->AddPiece(r, c, CellState::kBlackAttacker);
-        bstate->SetBoard(r, c, CellState::kBlackAttacker);
-      } else if (str.at(i) == 'K') {
-        bstate->AddPiece(r, c, CellState::kWhiteKing);
-        bstate->SetBoard(r, c, CellState::kWhiteKing);
-      } else if (str.at(i) == 'D') {
-        bstate->AddPiece(r, c, CellState::kWhiteDefender);
-        bstate->SetBoard(r, c, CellState::kWhiteDefender);
-      } else if (str.at(i) == 'A') {
-        bstate->AddPiece(r, c, CellState::kWhiteAttacker);
-        bstate->SetBoard(r, c, CellState::kWhiteAttacker);
-      } else if (str.at(i) == '.') {
-        bstate->SetBoard(r, c, CellState::kEmpty);
-      } else {
-        std::string error = "Invalid character in std::string: ";
-        error += str.at(i);
-        SpielFatalError(error);
-        return std::unique_ptr<State>();
-      }
-
-      i++;
+  BattleChessBoard board(tables_.get());
+  for (int i = 0; i < str.length(); ++i) {
+    if (str[i] == '.') continue;
+    std::optional<PieceType> type = PieceTypeFromChar(str[i]);
+    if (!type) {
+      SpielFatalError(absl::StrCat("Invalid character in std::string: ",
+                                   std::string(1, str[i])));
     }
+    board.set_square(
+        board.IndexToSquare(i),
+        Piece{isupper(str[i]) ? Color::kWhite : Color::kBlack, *type});
   }
-
-  return state;
+  return std::unique_ptr<State>(
+      new BattleChessState(shared_from_this(), board));
 }
 
 }  // namespace battle_chess
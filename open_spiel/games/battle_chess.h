@@ -12,24 +12,42 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-#ifndef THIRD_PARTY_OPEN_SPIEL_GAMES_BREAKTHROUGH_H_
-#define THIRD_PARTY_OPEN_SPIEL_GAMES_BREAKTHROUGH_H_
+#ifndef OPEN_SPIEL_GAMES_BATTLE_CHESS_H_
+#define OPEN_SPIEL_GAMES_BATTLE_CHESS_H_
 
 #include <array>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
 #include <iostream>
 
+#include "open_spiel/abseil-cpp/absl/strings/string_view.h"
+#include "open_spiel/abseil-cpp/absl/types/span.h"
+#include "open_spiel/games/battle_chess/battle_board.h"
 #include "open_spiel/spiel.h"
 #include "open_spiel/spiel_utils.h"
 
-// Breakthrough, a game used in the general game-play competition
-// http://en.wikipedia.org/wiki/Breakthrough_%28board_game%29
+// Battle chess: each side has a king, defenders and attackers, all of which
+// step one square at a time. The king moves and captures orthogonally,
+// defenders move orthogonally and capture diagonally, and attackers move
+// diagonally and capture orthogonally. The game is won by capturing the
+// opponent's king.
 //
 // Parameters:
-//       "columns"    int     number of columns on the board   (default = 8)
-//       "rows"       int     number of rows on the board      (default = 8)
+//       "columns"    int     number of columns on the board   (default = 5)
+//       "rows"       int     number of rows on the board      (default = 5)
+//       "fen"        string  starting position in the format read by
+//                            BattleChessBoard::BoardFromFEN
+//                            (default = "": DefaultFEN(rows, columns))
+//       "no_capture_limit"
+//                    int     plies without a capture after which the game
+//                            is drawn                         (default = 50)
+//
+// The game is also drawn when a position repeats for the third time, or when
+// the side to move has no legal move (possible on the smaller boards).
+//
+// Boards from 3x3 up to 8x8 are supported.
 
 namespace open_spiel {
 namespace battle_chess {
@@ -37,75 +55,85 @@ namespace battle_chess {
 inline constexpr int kNumPlayers = 2;
 inline constexpr int kBlackPlayerId = 1;
 inline constexpr int kWhitePlayerId = 0;
-inline constexpr int kCellStates =
-    1 + 3 /* 有三种类型的棋子 */ * kNumPlayers;  // player 0, player 1, empty.
-inline constexpr int kDefaultRows = 5;
-inline constexpr int kDefaultColumns = 5;
-
-// State of a cell.
-enum class CellState {
-  kEmpty,
-  kBlackKing,
-  kBlackDefender,
-  kBlackAttacker,
-  kWhiteKing,
-  kWhiteDefender,
-  kWhiteAttacker
-};
-
-//enum class Color {
-//  kBlack,
-//  kWhite
-//}
-struct Piece {
-  int row;
-  int col;
-  CellState pieceType;
-};
+inline constexpr int kDefaultRows = kDefaultBoardSize;
+inline constexpr int kDefaultColumns = kDefaultBoardSize;
+inline constexpr int kDefaultNoCaptureLimit = 50;
+inline constexpr int kNumRepetitionsToDraw = 3;
 
+// The position lives in a BattleChessBoard; the state adds the action
+// encoding, the observations and the undo records.
 class BattleChessState : public State {
  public:
   explicit BattleChessState(std::shared_ptr<const Game> game);
+  BattleChessState(std::shared_ptr<const Game> game,
+                   const BattleChessBoard& board);
   Player CurrentPlayer() const override;
   std::string ActionToString(Player player, Action action) const override;
   std::string ToString() const override;
   bool IsTerminal() const override;
   std::vector<double> Returns() const override;
   std::string ObservationString(Player player) const override;
+  // The observation has one plane per cell state, in the order black king,
+  // defender, attacker, white king, defender, attacker and empty. It is
+  // expanded from the board's bitboards, which apply/undo keep up to date.
   void ObservationTensor(Player player,
                          std::vector<double>* values) const override;
+  // Same as above, written straight into a float buffer (e.g. a network's
+  // input batch) of size ObservationTensorSize().
+  void ObservationTensor(Player player, absl::Span<float> values) const;
+  using State::ObservationTensor;
   std::unique_ptr<State> Clone() const override;
   void UndoAction(Player player, Action action) override;
 
   bool InBounds(int r, int c) const;
-  void SetBoard(int r, int c, CellState cs) { board_[r * cols_ + c] = cs; }
-  void AddPiece(int r, int c, CellState state);
-  void DeletePiece(int r, int c, CellState state);
-  // 用于清空棋子
-  void InitPieces(int color);
-  CellState board(int row, int col) const { return board_[row * cols_ + col]; }
-
-  int rows() const { return rows_; }
-  int cols() const { return cols_; }
+  CellState board(int row, int col) const {
+    return board_.at(row * cols() + col);
+  }
+  // Squares holding the given cell state; kEmpty gives the empty squares.
+  Bitboard bitboard(CellState cs) const { return board_.bitboard(cs); }
+
+  BattleChessBoard& Board() { return board_; }
+  const BattleChessBoard& Board() const { return board_; }
+
+  int rows() const { return board_.rows(); }
+  int cols() const { return board_.cols(); }
   std::vector<Action> LegalActions() const override;
+  // Counts the moves on the board's bitboards instead of listing them.
+  Action UniformRandomLegalAction(double z) const override;
+  // The text format: one character per square, as in ToString().
   std::string Serialize() const override;
+  // A compact binary format for replay buffers, see
+  // BattleChessGame::DeserializeBinary(). It keeps the side to play and the
+  // move counters, and with include_history also the actions taken, so that
+  // the copy has the same History() and can be undone.
+  std::string SerializeBinary(bool include_history = false) const;
+  // The board's Zobrist hash, mixed with the no-capture counter, which decides
+  // when the game is drawn. The repetitions of the history are not included.
+  uint64_t HashValue() const override;
+
+  // Pieces of the given colour (0 for white, 1 for black), in no particular
+  // order.
+  absl::Span<const PiecePlacement> pieces(int color) const {
+    return board_.pieces(static_cast<Color>(color));
+  }
+
+  // How many times the current position occurred since the last capture,
+  // including now. Only positions reached in this state's history count.
+  int NumRepetitions() const;
 
-  void getPiecesStatus();
  protected:
   void DoApplyAction(Action action) override;
 
  private:
-  int observation_plane(int r, int c) const;
-
-  // Fields sets to bad/invalid values. Use Game::NewInitialState().
-  Player cur_player_ = kInvalidPlayer;
-  int winner_ = kInvalidPlayer;
-  int total_moves_ = -1;
-  std::vector<Piece> whitePieces;
-  std::vector<Piece> blackPieces;
-  int rows_ = kDefaultRows;
-  int cols_ = kDefaultColumns;
-  std::vector<CellState> board_;  // for (row,col) we use row*cols_ + col.
+  // Its move tables belong to the game, which the state keeps alive.
+  BattleChessBoard board_;
+  // One record per applied move, popped by UndoAction().
+  std::vector<MoveRecord> undo_stack_;
+  int no_capture_limit_;
+  // Set when the last move repeated a position kNumRepetitionsToDraw times.
+  bool repetition_draw_ = false;
+  // Set when the side to move has no legal move, which is scored as a draw.
+  bool no_legal_moves_ = false;
 };
 
 class BattleChessGame : public Game {
@@ -123,50 +151,36 @@ class BattleChessGame : public Game {
   std::shared_ptr<const Game> Clone() const override {
     return std::shared_ptr<const Game>(new BattleChessGame(*this));
   }
+  // Shared by the boards of all the states of this game.
+  const MoveTables* Tables() const { return tables_.get(); }
+  const BattleChessBoard& InitialBoard() const { return initial_board_; }
+
   std::vector<int> ObservationTensorShape() const override {
     return {kCellStates, rows_, cols_};
   }
 
-  // Each piece must move forward from its current position, so the second last
-  // row on the opponent's side is a distance of rows_ - 2 for the front row,
-  // and rows_ - 1 for the back row (= 2*rows_ - 3). This can be done for each
-  // column, and for both players, and there is one final move to step onto the
-  // last winning row. As such, the formula for maximum game length is:
+  int NoCaptureLimit() const { return no_capture_limit_; }
 
-  // gameLength 并没有经过计算现在采用的是国际象棋的数据
-  int MaxGameLength() const override {
-    return 17695;
-  }
+  // Every capture but the last one removes one of the non-king pieces, and at
+  // most no_capture_limit plies pass before each capture and after the last
+  // one, so a game lasts at most (pieces - 1) * no_capture_limit plies.
+  int MaxGameLength() const override { return max_game_length_; }
+  // Accepts both the Serialize() text and the SerializeBinary() output.
   std::unique_ptr<State> DeserializeState(
       const std::string& str) const override;
+  // Reads SerializeBinary() output in place.
+  std::unique_ptr<State> DeserializeBinary(absl::string_view data) const;
 
  private:
   int rows_ = kDefaultRows;
   int cols_ = kDefaultColumns;
+  std::shared_ptr<const MoveTables> tables_;
+  BattleChessBoard initial_board_;
+  int no_capture_limit_;
+  int max_game_length_;
 };
 
-inline std::ostream& operator<<(std::ostream& stream, const CellState& state) {
-  switch (state) {
-    case CellState::kBlackKing:
-      return stream << "BlackKing";
-    case CellState::kBlackDefender:
-      return stream << "BlackDefender";
-    case CellState::kBlackAttacker:
-      return stream << "BlackAttacker";
-    case CellState::kWhiteKing:
-      return stream << "WhiteKing";
-    case CellState::kWhiteDefender:
-      return stream << "WhiteDefender";
-    case CellState::kWhiteAttacker:
-      return stream << "WhiteAttacker";
-    case CellState::kEmpty:
-      return stream << "Empty";
-    default:
-      SpielFatalError("Unknown cell state");
-  }
-}
-
 }  // namespace battle_chess
 }  // namespace open_spiel
 
-#endif  // THIRD_PARTY_OPEN_SPIEL_GAMES_BREAKTHROUGH_H_
+#endif  // OPEN_SPIEL_GAMES_BATTLE_CHESS_H_
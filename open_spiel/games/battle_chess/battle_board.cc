@@ -1,3 +1,17 @@
+// Copyright 2019 DeepMind Technologies Ltd. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
 #include "open_spiel/games/battle_chess/battle_board.h"
 
 #include <cctype>
@@ -6,8 +20,73 @@
 #include <utility>
 #include <vector>
 
+#include "open_spiel/abseil-cpp/absl/strings/ascii.h"
+#include "open_spiel/abseil-cpp/absl/strings/numbers.h"
+#include "open_spiel/abseil-cpp/absl/strings/str_cat.h"
+#include "open_spiel/abseil-cpp/absl/strings/str_split.h"
+
 namespace open_spiel {
 namespace battle_chess {
+namespace {
+
+template <std::size_t... Dims>
+using ZobristTableU64 = chess_common::ZobristTable<uint64_t, Dims...>;
+
+uint64_t SquareZobristValue(int index, CellState cs) {
+  static const ZobristTableU64<kMaxSquares, kCellStates> kZobristValues(
+      /*seed=*/2765481);
+  return kZobristValues[index][static_cast<int>(cs)];
+}
+
+// Xor-ed into the hash whenever the side to play changes.
+uint64_t ToPlayZobristValue() {
+  static const uint64_t kZobristValue = ZobristTableU64<1>(/*seed=*/7385312)[0];
+  return kZobristValue;
+}
+
+std::string RowLabel(int rows, int row) {
+  return std::string(1, '1' + (rows - 1 - row));
+}
+
+std::string ColLabel(int col) { return std::string(1, 'a' + col); }
+
+// For every square, the set of on-board squares one step away along the given
+// offsets.
+void FillStepMasks(int rows, int cols, const std::array<Offset, 4>& offsets,
+                   std::array<Bitboard, kMaxSquares>* masks) {
+  masks->fill(0);
+  for (int y = 0; y < rows; ++y) {
+    for (int x = 0; x < cols; ++x) {
+      Bitboard mask = 0;
+      for (const Offset& offset : offsets) {
+        const int x2 = x + offset.x_offset;
+        const int y2 = y + offset.y_offset;
+        if (x2 >= 0 && x2 < cols && y2 >= 0 && y2 < rows) {
+          mask |= Bitboard{1} << (y2 * cols + x2);
+        }
+      }
+      (*masks)[y * cols + x] = mask;
+    }
+  }
+}
+
+}  // namespace
+
+MoveTables::MoveTables(int rows, int cols)
+    : rows(rows), cols(cols), num_squares(rows * cols) {
+  SPIEL_CHECK_GE(rows, kMinBoardSize);
+  SPIEL_CHECK_LE(rows, kMaxBoardSize);
+  SPIEL_CHECK_GE(cols, kMinBoardSize);
+  SPIEL_CHECK_LE(cols, kMaxBoardSize);
+  all_squares = num_squares == kMaxSquares ? ~Bitboard{0}
+                                           : (Bitboard{1} << num_squares) - 1;
+  FillStepMasks(rows, cols, kOrthogonalOffsets, &orthogonal);
+  FillStepMasks(rows, cols, kDiagonalOffsets, &diagonal);
+}
+
+std::shared_ptr<const MoveTables> MakeMoveTables(int rows, int cols) {
+  return std::make_shared<const MoveTables>(rows, cols);
+}
 
 std::string ColorToString(Color c) {
   switch (c) {
@@ -58,5 +137,367 @@ std::string Piece::ToString() const {
   return color == Color::kWhite ? absl::AsciiStrToUpper(base)
                                 : absl::AsciiStrToLower(base);
 }
-}  // namespace open_spiel
+
+CellState PieceToCellState(Piece piece) {
+  if (piece.type == PieceType::kEmpty) return CellState::kEmpty;
+  const int base = piece.color == Color::kWhite
+                       ? static_cast<int>(CellState::kWhiteKing)
+                       : static_cast<int>(CellState::kBlackKing);
+  return static_cast<CellState>(base + static_cast<int>(piece.type) - 1);
+}
+
+Piece CellStateToPiece(CellState state) {
+  switch (state) {
+    case CellState::kEmpty:
+      return kEmptyPiece;
+    case CellState::kBlackKing:
+      return Piece{Color::kBlack, PieceType::kKing};
+    case CellState::kBlackDefender:
+      return Piece{Color::kBlack, PieceType::kDefender};
+    case CellState::kBlackAttacker:
+      return Piece{Color::kBlack, PieceType::kAttacker};
+    case CellState::kWhiteKing:
+      return Piece{Color::kWhite, PieceType::kKing};
+    case CellState::kWhiteDefender:
+      return Piece{Color::kWhite, PieceType::kDefender};
+    case CellState::kWhiteAttacker:
+      return Piece{Color::kWhite, PieceType::kAttacker};
+    default:
+      SpielFatalError("Unknown cell state");
+  }
+}
+
+std::string CellStateToString(CellState state) {
+  return CellStateToPiece(state).ToString();
+}
+
+std::ostream& operator<<(std::ostream& stream, const CellState& state) {
+  switch (state) {
+    case CellState::kBlackKing:
+      return stream << "BlackKing";
+    case CellState::kBlackDefender:
+      return stream << "BlackDefender";
+    case CellState::kBlackAttacker:
+      return stream << "BlackAttacker";
+    case CellState::kWhiteKing:
+      return stream << "WhiteKing";
+    case CellState::kWhiteDefender:
+      return stream << "WhiteDefender";
+    case CellState::kWhiteAttacker:
+      return stream << "WhiteAttacker";
+    case CellState::kEmpty:
+      return stream << "Empty";
+    default:
+      SpielFatalError("Unknown cell state");
+  }
+}
+
+BattleChessBoard::BattleChessBoard(const MoveTables* tables)
+    : tables_(tables),
+      bitboards_{},
+      num_pieces_{},
+      to_play_(Color::kWhite),
+      irreversible_move_counter_(0),
+      move_number_(1),
+      zobrist_hash_(0) {
+  board_.fill(CellState::kEmpty);
+  bitboards_[static_cast<int>(CellState::kEmpty)] = tables_->all_squares;
+  piece_slot_.fill(-1);
+}
+
+std::optional<BattleChessBoard> BattleChessBoard::BoardFromFEN(
+    const std::string& fen, const MoveTables* tables) {
+  BattleChessBoard board(tables);
+
+  std::vector<std::string> fen_parts = absl::StrSplit(fen, ' ');
+  if (fen_parts.size() != 4 && fen_parts.size() != 2) {
+    std::cerr << "Invalid FEN: " << fen << std::endl;
+    return std::nullopt;
+  }
+
+  std::vector<std::string> rows = absl::StrSplit(fen_parts[0], '/');
+  if (rows.size() != board.rows()) {
+    std::cerr << "Wrong number of rows in FEN: " << fen << std::endl;
+    return std::nullopt;
+  }
+  for (int8_t y = 0; y < board.rows(); ++y) {
+    int8_t x = 0;
+    for (char c : rows[y]) {
+      if (x >= board.cols()) {
+        std::cerr << "Too many things on FEN row: " << rows[y] << std::endl;
+        return std::nullopt;
+      }
+      if (c >= '1' && c <= '9') {
+        x += c - '0';
+      } else {
+        auto piece_type = PieceTypeFromChar(c);
+        if (!piece_type) return std::nullopt;
+        Color color = isupper(c) ? Color::kWhite : Color::kBlack;
+        board.set_square(Square{x, y}, Piece{color, *piece_type});
+        ++x;
+      }
+    }
+    if (x != board.cols()) {
+      std::cerr << "Wrong number of squares on FEN row: " << rows[y]
+                << std::endl;
+      return std::nullopt;
+    }
+  }
+
+  if (fen_parts[1] == "b") {
+    board.SetToPlay(Color::kBlack);
+  } else if (fen_parts[1] != "w") {
+    std::cerr << "Invalid side to move in FEN: " << fen_parts[1] << std::endl;
+    return std::nullopt;
+  }
+
+  if (fen_parts.size() == 4) {
+    if (!absl::SimpleAtoi(fen_parts[2], &board.irreversible_move_counter_) ||
+        !absl::SimpleAtoi(fen_parts[3], &board.move_number_)) {
+      std::cerr << "Invalid move counters in FEN: " << fen << std::endl;
+      return std::nullopt;
+    }
+  }
+  return board;
+}
+
+void BattleChessBoard::SetCell(int index, CellState cs) {
+  const Bitboard bit = Bitboard{1} << index;
+  bitboards_[static_cast<int>(board_[index])] &= ~bit;
+  bitboards_[static_cast<int>(cs)] |= bit;
+  zobrist_hash_ ^= SquareZobristValue(index, board_[index]);
+  zobrist_hash_ ^= SquareZobristValue(index, cs);
+  board_[index] = cs;
+}
+
+void BattleChessBoard::set_square(int index, CellState cs) {
+  if (board_[index] != CellState::kEmpty) RemovePiece(index, board_[index]);
+  if (cs != CellState::kEmpty) AddPiece(index, cs);
+  SetCell(index, cs);
+}
+
+void BattleChessBoard::SetToPlay(Color c) {
+  if (c != to_play_) zobrist_hash_ ^= ToPlayZobristValue();
+  to_play_ = c;
+}
+
+void BattleChessBoard::AddPiece(int index, CellState cs) {
+  const int color = ToInt(CellColor(cs));
+  const Square sq = IndexToSquare(index);
+  piece_slot_[index] = num_pieces_[color];
+  pieces_[color][num_pieces_[color]++] = PiecePlacement{sq.y, sq.x, cs};
+}
+
+void BattleChessBoard::RemovePiece(int index, CellState cs) {
+  const int slot = piece_slot_[index];
+  SPIEL_CHECK_GE(slot, 0);
+  std::array<PiecePlacement, kMaxSquares>& pieces =
+      pieces_[ToInt(CellColor(cs))];
+  const int last = --num_pieces_[ToInt(CellColor(cs))];
+  pieces[slot] = pieces[last];
+  piece_slot_[pieces[slot].row * cols() + pieces[slot].col] = slot;
+  piece_slot_[index] = -1;
+}
+
+void BattleChessBoard::RestorePiece(int index, CellState cs, int slot) {
+  const int color = ToInt(CellColor(cs));
+  std::array<PiecePlacement, kMaxSquares>& pieces = pieces_[color];
+  const int last = num_pieces_[color]++;
+  if (slot != last) {
+    // Send the piece that RemovePiece() moved into this slot back to the end.
+    pieces[last] = pieces[slot];
+    piece_slot_[pieces[last].row * cols() + pieces[last].col] = last;
+  }
+  const Square sq = IndexToSquare(index);
+  pieces[slot] = PiecePlacement{sq.y, sq.x, cs};
+  piece_slot_[index] = slot;
+}
+
+MoveRecord BattleChessBoard::ApplyMove(const Move& move) {
+  const CellState moving = board_[move.from];
+  const CellState captured = board_[move.to];
+  SPIEL_CHECK_EQ(CellColor(moving), to_play_);
+
+  MoveRecord record{zobrist_hash_, move, captured, /*captured_slot=*/-1,
+                    irreversible_move_counter_};
+  if (captured != CellState::kEmpty) {
+    SPIEL_CHECK_EQ(CellColor(captured), OppColor(to_play_));
+    record.captured_slot = piece_slot_[move.to];
+    RemovePiece(move.to, captured);
+    irreversible_move_counter_ = 0;
+  } else {
+    ++irreversible_move_counter_;
+  }
+
+  // The moving piece keeps its slot in the piece list.
+  const int slot = piece_slot_[move.from];
+  PiecePlacement& piece = pieces_[ToInt(to_play_)][slot];
+  const Square to = IndexToSquare(move.to);
+  piece.row = to.y;
+  piece.col = to.x;
+  piece_slot_[move.to] = slot;
+  piece_slot_[move.from] = -1;
+
+  SetCell(move.to, moving);
+  SetCell(move.from, CellState::kEmpty);
+
+  if (to_play_ == Color::kBlack) ++move_number_;
+  SetToPlay(OppColor(to_play_));
+  return record;
+}
+
+void BattleChessBoard::UndoMove(const MoveRecord& record) {
+  SetToPlay(OppColor(to_play_));
+  if (to_play_ == Color::kBlack) --move_number_;
+  irreversible_move_counter_ = record.irreversible_move_counter;
+
+  const Move& move = record.move;
+  const CellState moving = board_[move.to];
+  const int slot = piece_slot_[move.to];
+  PiecePlacement& piece = pieces_[ToInt(to_play_)][slot];
+  const Square from = IndexToSquare(move.from);
+  piece.row = from.y;
+  piece.col = from.x;
+  piece_slot_[move.from] = slot;
+  piece_slot_[move.to] = -1;
+
+  SetCell(move.from, moving);
+  SetCell(move.to, record.captured);
+  if (record.captured != CellState::kEmpty) {
+    RestorePiece(move.to, record.captured, record.captured_slot);
+  }
+}
+
+std::string BattleChessBoard::DebugString() const {
+  std::string result = "";
+  for (int y = 0; y < rows(); ++y) {
+    absl::StrAppend(&result, RowLabel(rows(), y));
+    for (int x = 0; x < cols(); ++x) {
+      absl::StrAppend(&result, CellStateToString(board_[y * cols() + x]));
+    }
+    result.append("\n");
+  }
+  absl::StrAppend(&result, " ");
+  for (int x = 0; x < cols(); ++x) {
+    absl::StrAppend(&result, ColLabel(x));
+  }
+  absl::StrAppend(&result, "\n");
+  return result;
+}
+
+std::string BattleChessBoard::ToFEN() const {
+  std::string fen;
+  for (int y = 0; y < rows(); ++y) {
+    if (y > 0) fen.push_back('/');
+    int num_empty = 0;
+    for (int x = 0; x < cols(); ++x) {
+      const CellState cs = board_[y * cols() + x];
+      if (cs == CellState::kEmpty) {
+        ++num_empty;
+        continue;
+      }
+      if (num_empty > 0) {
+        absl::StrAppend(&fen, num_empty);
+        num_empty = 0;
+      }
+      absl::StrAppend(&fen, CellStateToString(cs));
+    }
+    if (num_empty > 0) absl::StrAppend(&fen, num_empty);
+  }
+  absl::StrAppend(&fen, " ", to_play_ == Color::kWhite ? "w" : "b", " ",
+                  irreversible_move_counter_, " ", move_number_);
+  return fen;
+}
+
+void BattleChessBoard::AppendBinary(std::string* out) const {
+  out->push_back(static_cast<char>(rows() << 4 | cols()));
+  out->push_back(static_cast<char>(ToInt(to_play_)));
+  AppendUint32(irreversible_move_counter_, out);
+  AppendUint32(move_number_, out);
+  for (int i = 0; i < NumSquares(); i += 2) {
+    int byte = static_cast<int>(board_[i]);
+    if (i + 1 < NumSquares()) byte |= static_cast<int>(board_[i + 1]) << 4;
+    out->push_back(static_cast<char>(byte));
+  }
+}
+
+std::optional<BattleChessBoard> BattleChessBoard::BoardFromBinary(
+    absl::string_view* data, const MoveTables* tables) {
+  BattleChessBoard board(tables);
+  const int num_bytes = (board.NumSquares() + 1) / 2;
+  if (data->size() < 2) return std::nullopt;
+  const uint8_t size = static_cast<uint8_t>((*data)[0]);
+  const uint8_t to_play = static_cast<uint8_t>((*data)[1]);
+  if (size != (board.rows() << 4 | board.cols()) || to_play > 1) {
+    return std::nullopt;
+  }
+  data->remove_prefix(2);
+
+  uint32_t irreversible_move_counter;
+  uint32_t move_number;
+  if (!ConsumeUint32(data, &irreversible_move_counter) ||
+      !ConsumeUint32(data, &move_number) ||
+      data->size() < static_cast<size_t>(num_bytes)) {
+    return std::nullopt;
+  }
+  for (int i = 0; i < board.NumSquares(); ++i) {
+    const uint8_t byte = static_cast<uint8_t>((*data)[i / 2]);
+    const int cs = (byte >> (4 * (i % 2))) & 0xF;
+    if (cs >= kCellStates) return std::nullopt;
+    if (cs != static_cast<int>(CellState::kEmpty)) {
+      board.set_square(i, static_cast<CellState>(cs));
+    }
+  }
+  data->remove_prefix(num_bytes);
+
+  board.SetToPlay(static_cast<Color>(to_play));
+  board.irreversible_move_counter_ = irreversible_move_counter;
+  board.move_number_ = move_number;
+  return board;
+}
+
+void AppendUint16(uint16_t value, std::string* out) {
+  out->push_back(static_cast<char>(value & 0xFF));
+  out->push_back(static_cast<char>(value >> 8));
+}
+
+void AppendUint32(uint32_t value, std::string* out) {
+  AppendUint16(value & 0xFFFF, out);
+  AppendUint16(value >> 16, out);
+}
+
+bool ConsumeUint16(absl::string_view* data, uint16_t* value) {
+  if (data->size() < 2) return false;
+  *value = static_cast<uint8_t>((*data)[0]) |
+           static_cast<uint16_t>(static_cast<uint8_t>((*data)[1])) << 8;
+  data->remove_prefix(2);
+  return true;
+}
+
+bool ConsumeUint32(absl::string_view* data, uint32_t* value) {
+  uint16_t low, high;
+  if (!ConsumeUint16(data, &low) || !ConsumeUint16(data, &high)) return false;
+  *value = low | static_cast<uint32_t>(high) << 16;
+  return true;
+}
+
+std::string DefaultFEN(int rows, int cols) {
+  std::string back_rank(cols, 'd');
+  back_rank.front() = 'a';
+  back_rank.back() = 'a';
+  back_rank[cols / 2] = 'k';
+  std::string fen = back_rank;
+  for (int y = 1; y < rows - 1; ++y) absl::StrAppend(&fen, "/", cols);
+  absl::StrAppend(&fen, "/", absl::AsciiStrToUpper(back_rank), " w 0 1");
+  return fen;
+}
+
+BattleChessBoard MakeDefaultBoard(const MoveTables* tables) {
+  auto maybe_board = BattleChessBoard::BoardFromFEN(
+      DefaultFEN(tables->rows, tables->cols), tables);
+  SPIEL_CHECK_TRUE(maybe_board);
+  return *maybe_board;
+}
+
 }  // namespace battle_chess
+}  // namespace open_spiel
@@ -1,46 +1,95 @@
+// Copyright 2019 DeepMind Technologies Ltd. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
 #ifndef THIRD_PARTY_OPEN_SPIEL_GAMES_IMPL_BATTLE_CHESS_BATTLE_BOARD_H_
 #define THIRD_PARTY_OPEN_SPIEL_GAMES_IMPL_BATTLE_CHESS_BATTLE_BOARD_H_
 
-
+#include <algorithm>
 #include <array>
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <optional>
 #include <ostream>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "open_spiel/abseil-cpp/absl/strings/string_view.h"
+#include "open_spiel/abseil-cpp/absl/types/span.h"
+#include "open_spiel/games/chess/chess_common.h"
 #include "open_spiel/spiel_utils.h"
 
+// The position of a battle_chess game, independent of the State API, so that
+// move generation can be benchmarked and reused without virtual calls.
+//
+// Squares are indexed row-major from the top-left corner: index = y * cols + x
+// where x is the column and y the row. Row 0 is black's back rank, and is
+// shown as the highest rank.
+
 namespace open_spiel {
 namespace battle_chess {
 
+using chess_common::Offset;
+using chess_common::Square;
+
+inline constexpr int kDefaultBoardSize = 5;
+inline constexpr int kMinBoardSize = 3;
+inline constexpr int kMaxBoardSize = 8;
+inline constexpr int kMaxSquares = kMaxBoardSize * kMaxBoardSize;
+
+// A set of squares, with bit (y * cols + x) set for each member. Boards up to
+// 8x8 fit in one 64-bit word.
+using Bitboard = uint64_t;
+
+// White moves first and is player 0.
+enum class Color : int8_t { kWhite = 0, kBlack = 1, kEmpty = 2 };
+
+inline int ToInt(Color color) { return static_cast<int>(color); }
+
+inline Color OppColor(Color color) {
+  return color == Color::kWhite ? Color::kBlack : Color::kWhite;
+}
+
+std::string ColorToString(Color c);
+
+inline std::ostream& operator<<(std::ostream& stream, Color c) {
+  return stream << ColorToString(c);
+}
+
 enum class PieceType : int8_t {
   kEmpty = 0,
   kKing = 1,
   kDefender = 2,
-  kAttacker= 3,
+  kAttacker = 3,
 };
 
-// 下面几个函数都是仿照国际象棋的写法
 static inline constexpr std::array<PieceType, 3> kPieceTypes = {
     {PieceType::kKing, PieceType::kDefender, PieceType::kAttacker}};
 
 // In case all the pieces are represented in the same plane, these values are
 // used to represent each piece type.
-static inline constexpr std::array<float, 6> kPieceRepresentation = {
+static inline constexpr std::array<float, 3> kPieceRepresentation = {
     {1, 0.8, 0.6}};
 
-// Tries to parse piece type from char ('K', 'Q', 'R', 'B', 'N', 'P').
-// Case-insensitive.
+// Tries to parse piece type from char ('K', 'D', 'A'). Case-insensitive.
 std::optional<PieceType> PieceTypeFromChar(char c);
 
-// Converts piece type to one character strings - "K", "Q", "R", "B", "N", "P".
+// Converts piece type to one character strings - "K", "D", "A".
 // p must be one of the enumerator values of PieceType.
 std::string PieceTypeToString(PieceType p, bool uppercase = true);
 
-// Piece 的结构， 仿照的是国际象棋的结构
 struct Piece {
   bool operator==(const Piece& other) const {
     return type == other.type && color == other.color;
@@ -48,31 +97,320 @@ struct Piece {
 
   bool operator!=(const Piece& other) const { return !(*this == other); }
 
-  std::string ToUnicode() const;
   std::string ToString() const;
 
   Color color;
   PieceType type;
 };
 
+static inline constexpr Piece kEmptyPiece =
+    Piece{Color::kEmpty, PieceType::kEmpty};
+
+inline std::ostream& operator<<(std::ostream& stream, const Piece& p) {
+  return stream << p.ToString();
+}
+
+// One-byte encoding of a square's content, used for the board array and to
+// index the bitboards.
+enum class CellState : int8_t {
+  kEmpty,
+  kBlackKing,
+  kBlackDefender,
+  kBlackAttacker,
+  kWhiteKing,
+  kWhiteDefender,
+  kWhiteAttacker
+};
+
+inline constexpr int kCellStates = 7;
+
+CellState PieceToCellState(Piece piece);
+Piece CellStateToPiece(CellState state);
+
+inline Color CellColor(CellState state) {
+  if (state == CellState::kEmpty) return Color::kEmpty;
+  return state >= CellState::kWhiteKing ? Color::kWhite : Color::kBlack;
+}
+
+// "K", "D", "A" for white, "k", "d", "a" for black and "." for empty.
+std::string CellStateToString(CellState state);
+
+std::ostream& operator<<(std::ostream& stream, const CellState& state);
 
+// Entry of a piece list.
+struct PiecePlacement {
+  int8_t row;
+  int8_t col;
+  CellState pieceType;
+};
+
+// A move between two square indices. The captured piece, if any, is whatever
+// stands on the destination.
+struct Move {
+  int8_t from;
+  int8_t to;
+};
+
+// Everything BattleChessBoard::UndoMove() needs to take back a move in O(1).
+struct MoveRecord {
+  uint64_t hash;  // HashValue() before the move, to detect repetitions.
+  Move move;
+  CellState captured;    // kEmpty if the move captured nothing.
+  int8_t captured_slot;  // Index of the captured piece in its piece list.
+  int32_t irreversible_move_counter;  // Value before the move.
+};
+
+inline constexpr std::array<Offset, 4> kOrthogonalOffsets = {
+    {{0, 1}, {0, -1}, {1, 0}, {-1, 0}}};
+
+inline constexpr std::array<Offset, 4> kDiagonalOffsets = {
+    {{1, 1}, {1, -1}, {-1, -1}, {-1, 1}}};
+
+// Per-square step masks for one board size. They are built once per game and
+// shared by all its boards, so move generation needs no bounds checks.
+struct MoveTables {
+  MoveTables(int rows, int cols);
+
+  int rows;
+  int cols;
+  int num_squares;
+  Bitboard all_squares;
+  // The king moves and captures along the orthogonal masks. Defenders move
+  // orthogonally and capture diagonally; attackers do the opposite.
+  std::array<Bitboard, kMaxSquares> orthogonal;
+  std::array<Bitboard, kMaxSquares> diagonal;
+};
+
+// The tables passed to a board must outlive it. BattleChessGame owns the
+// tables of its states' boards.
 class BattleChessBoard {
-  public:
-    BattleChessBoard();
-    static std::optional<ChessBoard> BoardFromFEN(const std::string& fen);
+ public:
+  // An empty board with white to play.
+  explicit BattleChessBoard(const MoveTables* tables);
+
+  // Parses a FEN-like string, e.g. the default 5x5 starting position
+  // "adkda/5/5/5/ADKDA w 0 1": rows from the top (black's side) separated by
+  // '/', digits for runs of empty squares, side to play, irreversible move
+  // counter and move number. The board size must match the tables.
+  static std::optional<BattleChessBoard> BoardFromFEN(
+      const std::string& fen, const MoveTables* tables);
 
-    const Piece& at(Square sq) const { return board_[SquareToIndex_(sq)]; }
+  Piece at(Square sq) const { return CellStateToPiece(at(SquareToIndex(sq))); }
+  CellState at(int index) const { return board_[index]; }
+
+  // Both keep the bitboards, piece lists and hash in sync.
+  void set_square(Square sq, Piece p) {
+    set_square(SquareToIndex(sq), PieceToCellState(p));
+  }
+  void set_square(int index, CellState cs);
 
-    void set_square(Square sq, Piece p);
+  // Squares holding the given cell state; kEmpty gives the empty squares.
+  Bitboard bitboard(CellState cs) const {
+    return bitboards_[static_cast<int>(cs)];
+  }
+  Bitboard Occupancy(Color color) const {
+    return color == Color::kWhite ? bitboard(CellState::kWhiteKing) |
+                                        bitboard(CellState::kWhiteDefender) |
+                                        bitboard(CellState::kWhiteAttacker)
+                                  : bitboard(CellState::kBlackKing) |
+                                        bitboard(CellState::kBlackDefender) |
+                                        bitboard(CellState::kBlackAttacker);
+  }
+
+  // Pieces of the given colour, in no particular order.
+  absl::Span<const PiecePlacement> pieces(Color color) const {
+    return absl::MakeConstSpan(pieces_[ToInt(color)].data(),
+                               num_pieces_[ToInt(color)]);
+  }
 
-    const std::array<Piece, kBoardSize * kBoardSize>& pieces() const {
-      return board_;
+  // The game is lost by the side whose king has been captured.
+  bool HasKing(Color color) const {
+    return bitboard(color == Color::kWhite ? CellState::kWhiteKing
+                                           : CellState::kBlackKing) != 0;
+  }
+
+  Color ToPlay() const { return to_play_; }
+  void SetToPlay(Color c);
+
+  // Number of moves since the last capture.
+  int32_t IrreversibleMoveCounter() const { return irreversible_move_counter_; }
+  // Starts at 1 and increments after each black move, as in chess.
+  int32_t Movenumber() const { return move_number_; }
+
+  // Calls yield(move) for every legal move of the side to play. Moves are
+  // generated in increasing (from, to) order.
+  template <typename YieldFn>
+  void GenerateLegalMoves(const YieldFn& yield) const;
+
+  // Calls yield(from, targets) for every piece of the side to play, in
+  // increasing order of `from`, with the bitboard of the squares it can move
+  // to.
+  template <typename YieldFn>
+  void GenerateMoveTargets(const YieldFn& yield) const;
+
+  // Returns the legal move at index floor(z * n) in the order of
+  // GenerateLegalMoves(), out of the n legal moves, for z in [0, 1). It keeps
+  // the targets of each piece from one pass over the pieces and counts them,
+  // so no list of moves is built. There must be a legal move.
+  Move LegalMoveAt(double z) const;
+
+  bool HasLegalMoves() const {
+    bool found = false;
+    GenerateLegalMoves([&found](const Move&) { found = true; });
+    return found;
+  }
+
+  // Applies a legal move and returns what is needed to undo it.
+  MoveRecord ApplyMove(const Move& move);
+  void UndoMove(const MoveRecord& record);
+
+  bool InBoardArea(const Square& sq) const {
+    return sq.x >= 0 && sq.x < cols() && sq.y >= 0 && sq.y < rows();
+  }
+
+  int SquareToIndex(Square sq) const { return sq.y * cols() + sq.x; }
+  Square IndexToSquare(int index) const {
+    return Square{static_cast<int8_t>(index % cols()),
+                  static_cast<int8_t>(index / cols())};
+  }
+
+  int rows() const { return tables_->rows; }
+  int cols() const { return tables_->cols; }
+  int NumSquares() const { return tables_->num_squares; }
+  const MoveTables& Tables() const { return *tables_; }
+
+  uint64_t HashValue() const { return zobrist_hash_; }
+
+  // Rows with their labels, followed by the column labels.
+  std::string DebugString() const;
+
+  std::string ToFEN() const;
+
+  // Appends a compact binary encoding of the position to out: board size,
+  // side to play, both counters and one nibble per square (23 bytes for 5x5).
+  void AppendBinary(std::string* out) const;
+
+  // Parses AppendBinary() output from the front of data, which is advanced
+  // past it. Returns nullopt if the input is malformed or was written for
+  // another board size.
+  static std::optional<BattleChessBoard> BoardFromBinary(
+      absl::string_view* data, const MoveTables* tables);
+
+ private:
+  void AddPiece(int index, CellState cs);
+  // Removes the piece in O(1) by moving the last piece of the same colour
+  // into its slot.
+  void RemovePiece(int index, CellState cs);
+  // Inverse of RemovePiece(): puts the piece back at the given slot.
+  void RestorePiece(int index, CellState cs, int slot);
+  // Updates board_, bitboards_ and zobrist_hash_ only.
+  void SetCell(int index, CellState cs);
+
+  const MoveTables* tables_;
+  std::array<CellState, kMaxSquares> board_;
+  // One bitboard per CellState, kept in sync with board_.
+  std::array<Bitboard, kCellStates> bitboards_;
+  // Piece lists indexed by colour. Only the first num_pieces_ entries of each
+  // are live.
+  std::array<std::array<PiecePlacement, kMaxSquares>, 2> pieces_;
+  std::array<int8_t, 2> num_pieces_;
+  // For every square, the index of its piece in pieces_, or -1 if empty.
+  std::array<int8_t, kMaxSquares> piece_slot_;
+
+  Color to_play_;
+  int32_t irreversible_move_counter_;
+  int32_t move_number_;
+
+  uint64_t zobrist_hash_;
+};
+
+template <typename YieldFn>
+void BattleChessBoard::GenerateMoveTargets(const YieldFn& yield) const {
+  const Bitboard own = Occupancy(to_play_);
+  const Bitboard opponent = Occupancy(OppColor(to_play_));
+  const Bitboard empty = bitboard(CellState::kEmpty);
+  const std::array<Bitboard, kMaxSquares>& orthogonal = tables_->orthogonal;
+  const std::array<Bitboard, kMaxSquares>& diagonal = tables_->diagonal;
+
+  for (Bitboard origins = own; origins; origins &= origins - 1) {
+    const int from = __builtin_ctzll(origins);
+    Bitboard targets = 0;
+    switch (board_[from]) {
+      case CellState::kWhiteKing:
+      case CellState::kBlackKing:
+        targets = orthogonal[from] & ~own;
+        break;
+      case CellState::kWhiteDefender:
+      case CellState::kBlackDefender:
+        targets = (orthogonal[from] & empty) |
+                  (diagonal[from] & opponent);
+        break;
+      case CellState::kWhiteAttacker:
+      case CellState::kBlackAttacker:
+        targets = (diagonal[from] & empty) |
+                  (orthogonal[from] & opponent);
+        break;
+      default:
+        SpielFatalError("Empty square in the piece bitboards.");
+    }
+    yield(from, targets);
+  }
+}
+
+template <typename YieldFn>
+void BattleChessBoard::GenerateLegalMoves(const YieldFn& yield) const {
+  GenerateMoveTargets([&yield](int from, Bitboard targets) {
+    for (; targets; targets &= targets - 1) {
+      yield(Move{static_cast<int8_t>(from),
+                 static_cast<int8_t>(__builtin_ctzll(targets))});
     }
+  });
+}
+
+inline Move BattleChessBoard::LegalMoveAt(double z) const {
+  std::array<int8_t, kMaxSquares> origins;
+  std::array<Bitboard, kMaxSquares> targets;
+  int num_pieces = 0;
+  int num_moves = 0;
+  GenerateMoveTargets([&](int from, Bitboard to) {
+    if (to == 0) return;
+    origins[num_pieces] = from;
+    targets[num_pieces++] = to;
+    num_moves += __builtin_popcountll(to);
+  });
+  SPIEL_CHECK_GT(num_moves, 0);
+  int n = std::min<int>(z * num_moves, num_moves - 1);
+  int piece = 0;
+  while (n >= __builtin_popcountll(targets[piece])) {
+    n -= __builtin_popcountll(targets[piece++]);
+  }
+  Bitboard to = targets[piece];
+  for (; n > 0; --n) to &= to - 1;
+  return Move{origins[piece], static_cast<int8_t>(__builtin_ctzll(to))};
+}
+
+inline std::ostream& operator<<(std::ostream& stream,
+                                const BattleChessBoard& board) {
+  return stream << board.DebugString();
+}
 
-  private:
-    std::array<Piece, kBoardSize * kBoardSize> board_;
+std::shared_ptr<const MoveTables> MakeMoveTables(int rows, int cols);
+
+// Little-endian fixed-width integers for the binary formats. The Consume
+// functions advance data and return false if it is too short.
+void AppendUint16(uint16_t value, std::string* out);
+void AppendUint32(uint32_t value, std::string* out);
+bool ConsumeUint16(absl::string_view* data, uint16_t* value);
+bool ConsumeUint32(absl::string_view* data, uint32_t* value);
+
+// FEN of the standard starting position for the given size: each side's back
+// rank has attackers in the corners, the king in the middle and defenders in
+// between, e.g. "adkda/5/5/5/ADKDA w 0 1".
+std::string DefaultFEN(int rows, int cols);
+
+BattleChessBoard MakeDefaultBoard(const MoveTables* tables);
 
-}  // class BattleChessBoard
 }  // namespace battle_chess
 }  // namespace open_spiel
-#endif  // THIRD_PARTY_OPEN_SPIEL_GAMES_IMPL_BATTLE_CHESS_BATTLE_BOARD_H_
\ No newline at end of file
+
+#endif  // THIRD_PARTY_OPEN_SPIEL_GAMES_IMPL_BATTLE_CHESS_BATTLE_BOARD_H_
@@ -12,6 +12,16 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include "open_spiel/games/battle_chess.h"
+
+#include <random>
+#include <string>
+#include <tuple>
+#include <utility>
+
+#include "open_spiel/abseil-cpp/absl/container/flat_hash_map.h"
+#include "open_spiel/games/battle_chess/battle_board.h"
+
 #include "open_spiel/spiel.h"
 #include "open_spiel/tests/basic_tests.h"
 
@@ -25,6 +35,308 @@ void BasicBattleChessTests() {
   testing::LoadGameTest("battle_chess");
   testing::NoChanceOutcomesTest(*LoadGame("battle_chess"));
   testing::RandomSimTest(*LoadGame("battle_chess"), 100);
+  testing::RandomSimTestWithUndo(*LoadGame("battle_chess"), 10);
+}
+
+void CheckSamePieces(const BattleChessState& a, const BattleChessState& b) {
+  for (int color = 0; color < kNumPlayers; ++color) {
+    SPIEL_CHECK_EQ(a.pieces(color).size(), b.pieces(color).size());
+    for (int i = 0; i < a.pieces(color).size(); ++i) {
+      SPIEL_CHECK_EQ(a.pieces(color)[i].row, b.pieces(color)[i].row);
+      SPIEL_CHECK_EQ(a.pieces(color)[i].col, b.pieces(color)[i].col);
+      SPIEL_CHECK_EQ(a.pieces(color)[i].pieceType,
+                     b.pieces(color)[i].pieceType);
+    }
+  }
+}
+
+// Plays random games, undoing every move once, and checks that the piece
+// lists (not just the board) come back exactly as they were.
+void UndoRestoresPieceListsTest() {
+  std::shared_ptr<const Game> game = LoadGame("battle_chess");
+  std::mt19937 rng;
+  for (int sim = 0; sim < 20; ++sim) {
+    std::unique_ptr<State> state = game->NewInitialState();
+    std::vector<std::unique_ptr<State>> snapshots;
+    while (!state->IsTerminal()) {
+      std::vector<Action> actions = state->LegalActions();
+      Action action = actions[rng() % actions.size()];
+      std::unique_ptr<State> before = state->Clone();
+      state->ApplyAction(action);
+      state->UndoAction(before->CurrentPlayer(), action);
+      CheckSamePieces(static_cast<const BattleChessState&>(*before),
+                      static_cast<const BattleChessState&>(*state));
+      SPIEL_CHECK_EQ(before->LegalActions(), state->LegalActions());
+      SPIEL_CHECK_EQ(before->HashValue(), state->HashValue());
+      snapshots.push_back(std::move(before));
+      state->ApplyAction(action);
+    }
+    // Unwind the whole game.
+    while (!snapshots.empty()) {
+      std::vector<Action> history = state->History();
+      state->UndoAction(snapshots.back()->CurrentPlayer(), history.back());
+      CheckSamePieces(static_cast<const BattleChessState&>(*snapshots.back()),
+                      static_cast<const BattleChessState&>(*state));
+      SPIEL_CHECK_EQ(snapshots.back()->ToString(), state->ToString());
+      snapshots.pop_back();
+    }
+  }
+}
+
+// The incremental hash must depend only on the position, the side to move and
+// the no-capture counter, however the position was reached.
+void HashValueTest() {
+  std::shared_ptr<const Game> game = LoadGame("battle_chess");
+  std::mt19937 rng;
+  using Key = std::tuple<std::string, Player, int>;
+  absl::flat_hash_map<Key, uint64_t> hashes;
+  absl::flat_hash_map<uint64_t, Key> positions;
+  for (int sim = 0; sim < 100; ++sim) {
+    std::unique_ptr<State> state = game->NewInitialState();
+    while (!state->IsTerminal()) {
+      Key key = {state->ToString(), state->CurrentPlayer(),
+                 static_cast<const BattleChessState&>(*state)
+                     .Board()
+                     .IrreversibleMoveCounter()};
+      auto [it, inserted] = hashes.insert({key, state->HashValue()});
+      SPIEL_CHECK_EQ(it->second, state->HashValue());
+      auto [pos_it, pos_inserted] =
+          positions.insert({state->HashValue(), key});
+      SPIEL_CHECK_TRUE(pos_it->second == key);
+      std::vector<Action> actions = state->LegalActions();
+      state->ApplyAction(actions[rng() % actions.size()]);
+    }
+  }
+}
+
+// The FEN string must capture everything the board knows, including the hash.
+void BoardFENTest() {
+  std::shared_ptr<const MoveTables> tables = MakeMoveTables(5, 5);
+  BattleChessBoard start = MakeDefaultBoard(tables.get());
+  SPIEL_CHECK_EQ(start.ToFEN(), "adkda/5/5/5/ADKDA w 0 1");
+  SPIEL_CHECK_EQ(start.DebugString(), "5adkda\n4.....\n3.....\n2.....\n"
+                                      "1ADKDA\n abcde\n");
+  SPIEL_CHECK_FALSE(BattleChessBoard::BoardFromFEN("adkda/5/5/5 w 0 1",
+                                                   tables.get()));
+  SPIEL_CHECK_FALSE(BattleChessBoard::BoardFromFEN("adkda/6/5/5/ADKDA w",
+                                                   tables.get()));
+  SPIEL_CHECK_FALSE(BattleChessBoard::BoardFromFEN("adkda/5/5/5/ADKDA x",
+                                                   tables.get()));
+
+  std::mt19937 rng;
+  BattleChessBoard board = start;
+  while (board.HasKing(Color::kWhite) && board.HasKing(Color::kBlack)) {
+    std::optional<BattleChessBoard> parsed =
+        BattleChessBoard::BoardFromFEN(board.ToFEN(), tables.get());
+    SPIEL_CHECK_TRUE(parsed);
+    SPIEL_CHECK_EQ(parsed->ToFEN(), board.ToFEN());
+    SPIEL_CHECK_EQ(parsed->HashValue(), board.HashValue());
+
+    std::vector<Move> moves;
+    board.GenerateLegalMoves([&moves](const Move& move) {
+      moves.push_back(move);
+    });
+    board.ApplyMove(moves[rng() % moves.size()]);
+  }
+}
+
+void CheckSameState(const BattleChessState& a, const BattleChessState& b) {
+  SPIEL_CHECK_EQ(a.Board().ToFEN(), b.Board().ToFEN());
+  SPIEL_CHECK_EQ(a.CurrentPlayer(), b.CurrentPlayer());
+  SPIEL_CHECK_EQ(a.HashValue(), b.HashValue());
+  SPIEL_CHECK_EQ(a.LegalActions(), b.LegalActions());
+}
+
+// Both binary variants must restore the position exactly, and the one with
+// history must also restore History() and support undoing it.
+void BinarySerializationTest(const std::string& game_string) {
+  std::shared_ptr<const Game> game = LoadGame(game_string);
+  std::mt19937 rng;
+  for (int i = 0; i < 20; ++i) {
+    std::unique_ptr<State> state = game->NewInitialState();
+    while (true) {
+      const auto& bc_state = static_cast<const BattleChessState&>(*state);
+      const std::string board_only = bc_state.SerializeBinary();
+      SPIEL_CHECK_EQ(board_only.size(),
+                     12 + (bc_state.rows() * bc_state.cols() + 1) / 2);
+      CheckSameState(bc_state, static_cast<const BattleChessState&>(
+                                   *game->DeserializeState(board_only)));
+
+      std::unique_ptr<State> copy =
+          game->DeserializeState(bc_state.SerializeBinary(true));
+      CheckSameState(bc_state, static_cast<const BattleChessState&>(*copy));
+      SPIEL_CHECK_EQ(copy->History(), state->History());
+
+      // The text format only keeps the board.
+      SPIEL_CHECK_EQ(game->DeserializeState(state->Serialize())->ToString(),
+                     state->ToString());
+
+      if (state->IsTerminal()) {
+        for (int j = state->History().size() - 1; j >= 0; --j) {
+          copy->UndoAction(j % 2, state->History()[j]);
+        }
+        CheckSameState(static_cast<const BattleChessState&>(*copy),
+                       static_cast<const BattleChessState&>(
+                           *game->NewInitialState()));
+        break;
+      }
+      std::vector<Action> actions = state->LegalActions();
+      state->ApplyAction(actions[rng() % actions.size()]);
+    }
+  }
+
+  // History recorded from a deserialized position starts from that position.
+  std::unique_ptr<State> state = game->NewInitialState();
+  state->ApplyAction(state->LegalActions()[0]);
+  state = game->DeserializeState(
+      static_cast<const BattleChessState&>(*state).SerializeBinary());
+  state->ApplyAction(state->LegalActions()[0]);
+  std::unique_ptr<State> copy = game->DeserializeState(
+      static_cast<const BattleChessState&>(*state).SerializeBinary(true));
+  SPIEL_CHECK_EQ(copy->History(), state->History());
+  CheckSameState(static_cast<const BattleChessState&>(*state),
+                 static_cast<const BattleChessState&>(*copy));
+}
+
+void DrawRulesTest() {
+  SPIEL_CHECK_EQ(LoadGame("battle_chess")->MaxGameLength(),
+                 9 * kDefaultNoCaptureLimit);
+
+  // Kings alone cannot meet within two plies.
+  std::shared_ptr<const Game> game =
+      LoadGame("battle_chess", {{"fen", GameParameter(std::string(
+                                            "k4/5/5/5/4K w 0 1"))},
+                                {"no_capture_limit", GameParameter(2)}});
+  SPIEL_CHECK_EQ(game->MaxGameLength(), 2);
+  std::unique_ptr<State> state = game->NewInitialState();
+  state->ApplyAction(state->StringToAction("e1e2-"));
+  SPIEL_CHECK_FALSE(state->IsTerminal());
+  state->ApplyAction(state->StringToAction("a5a4-"));
+  SPIEL_CHECK_TRUE(state->IsTerminal());
+  SPIEL_CHECK_EQ(state->Returns(), (std::vector<double>{0.0, 0.0}));
+  state->UndoAction(kBlackPlayerId, state->History().back());
+  SPIEL_CHECK_FALSE(state->IsTerminal());
+
+  // The starting position comes back for the third time after eight plies.
+  game = LoadGame("battle_chess", {{"fen", GameParameter(std::string(
+                                               "k4/5/5/5/4K w 0 1"))}});
+  state = game->NewInitialState();
+  const auto& bc_state = static_cast<const BattleChessState&>(*state);
+  for (int i = 0; i < 2; ++i) {
+    SPIEL_CHECK_EQ(bc_state.NumRepetitions(), i + 1);
+    for (const char* move : {"e1e2-", "a5a4-", "e2e1-", "a4a5-"}) {
+      SPIEL_CHECK_FALSE(state->IsTerminal());
+      state->ApplyAction(state->StringToAction(move));
+    }
+  }
+  SPIEL_CHECK_EQ(bc_state.NumRepetitions(), 3);
+  SPIEL_CHECK_TRUE(state->IsTerminal());
+  SPIEL_CHECK_EQ(state->Returns(), (std::vector<double>{0.0, 0.0}));
+
+  // White's king and attackers are blocked in, so White cannot move.
+  game = LoadGame(
+      "battle_chess",
+      {{"rows", GameParameter(4)},
+       {"columns", GameParameter(4)},
+       {"fen", GameParameter(std::string("1k2/2d1/1a1A/2AK w 0 1"))}});
+  state = game->NewInitialState();
+  SPIEL_CHECK_TRUE(state->IsTerminal());
+  SPIEL_CHECK_EQ(state->CurrentPlayer(), kTerminalPlayerId);
+  SPIEL_CHECK_TRUE(state->LegalActions().empty());
+  SPIEL_CHECK_EQ(state->Returns(), (std::vector<double>{0.0, 0.0}));
+
+  // The same position reached by play from the default 4x4 start.
+  game = LoadGame("battle_chess(rows=4,columns=4)");
+  state = game->NewInitialState();
+  for (Action action : {1953, 486, 2133, 963, 1368, 189, 1998, 297, 1188, 774,
+                        2263, 38, 2151, 909, 1809, 144, 1404, 9, 1809, 774,
+                        1422}) {
+    SPIEL_CHECK_FALSE(state->IsTerminal());
+    state->ApplyAction(action);
+  }
+  SPIEL_CHECK_FALSE(state->IsTerminal());
+  state->ApplyAction(657);
+  const std::string fen =
+      static_cast<const BattleChessState&>(*state).Board().ToFEN();
+  SPIEL_CHECK_EQ(fen.substr(0, fen.find(' ')), "1k2/2d1/1a1A/2AK");
+  SPIEL_CHECK_TRUE(state->IsTerminal());
+  SPIEL_CHECK_EQ(state->Returns(), (std::vector<double>{0.0, 0.0}));
+  state->UndoAction(kBlackPlayerId, 657);
+  SPIEL_CHECK_FALSE(state->IsTerminal());
+}
+
+// Checks the bitboard expansion against a cell-by-cell one-hot encoding.
+void ObservationTensorTest(const std::string& game_string) {
+  constexpr std::array<CellState, kCellStates> kPlanes = {
+      CellState::kBlackKing,     CellState::kBlackDefender,
+      CellState::kBlackAttacker, CellState::kWhiteKing,
+      CellState::kWhiteDefender, CellState::kWhiteAttacker,
+      CellState::kEmpty};
+  std::shared_ptr<const Game> game = LoadGame(game_string);
+  std::mt19937 rng;
+  std::unique_ptr<State> state = game->NewInitialState();
+  while (!state->IsTerminal()) {
+    const auto& bc_state = static_cast<const BattleChessState&>(*state);
+    std::vector<double> expected;
+    for (CellState plane : kPlanes) {
+      for (int r = 0; r < bc_state.rows(); ++r) {
+        for (int c = 0; c < bc_state.cols(); ++c) {
+          expected.push_back(bc_state.board(r, c) == plane ? 1.0 : 0.0);
+        }
+      }
+    }
+    SPIEL_CHECK_EQ(state->ObservationTensor(), expected);
+
+    std::vector<float> floats(game->ObservationTensorSize());
+    bc_state.ObservationTensor(state->CurrentPlayer(),
+                               absl::MakeSpan(floats));
+    SPIEL_CHECK_EQ(std::vector<double>(floats.begin(), floats.end()),
+                   expected);
+
+    std::vector<Action> actions = state->LegalActions();
+    state->ApplyAction(actions[rng() % actions.size()]);
+  }
+}
+
+// The counted sampling picks the same actions as indexing LegalActions().
+void UniformRandomLegalActionTest(const std::string& game_string) {
+  std::shared_ptr<const Game> game = LoadGame(game_string);
+  std::mt19937 rng;
+  std::uniform_real_distribution<double> uniform;
+  for (int game_num = 0; game_num < 10; ++game_num) {
+    std::unique_ptr<State> state = game->NewInitialState();
+    while (!state->IsTerminal()) {
+      const std::vector<Action> actions = state->LegalActions();
+      for (int i = 0; i < actions.size(); ++i) {
+        const double z = (i + 0.5) / actions.size();
+        SPIEL_CHECK_EQ(state->UniformRandomLegalAction(z), actions[i]);
+      }
+      SPIEL_CHECK_EQ(state->UniformRandomLegalAction(0), actions.front());
+      SPIEL_CHECK_EQ(state->UniformRandomLegalAction(0.9999999999),
+                     actions.back());
+      state->ApplyAction(state->UniformRandomLegalAction(uniform(rng)));
+    }
+  }
+}
+
+void BoardSizeTests() {
+  for (int size = kMinBoardSize; size <= kMaxBoardSize; ++size) {
+    std::shared_ptr<const Game> game = LoadGame(
+        "battle_chess", {{"rows", GameParameter(size)},
+                         {"columns", GameParameter(size)}});
+    SPIEL_CHECK_EQ(game->NumDistinctActions(),
+                   size * size * size * size * 9);
+    testing::RandomSimTest(*game, 10);
+    testing::RandomSimTestWithUndo(*game, 5);
+  }
+  testing::RandomSimTest(*LoadGame("battle_chess(rows=6,columns=8)"), 10);
+
+  std::shared_ptr<const Game> game =
+      LoadGame("battle_chess", {{"fen", GameParameter(std::string(
+                                            "k4/5/5/5/A3K b 0 1"))}});
+  std::unique_ptr<State> state = game->NewInitialState();
+  SPIEL_CHECK_EQ(state->CurrentPlayer(), kBlackPlayerId);
+  SPIEL_CHECK_EQ(state->LegalActions().size(), 2);
 }
 
 }  // namespace
@@ -33,4 +345,18 @@ void BasicBattleChessTests() {
 
 int main(int argc, char** argv) {
   open_spiel::battle_chess::BasicBattleChessTests();
+  open_spiel::battle_chess::UndoRestoresPieceListsTest();
+  open_spiel::battle_chess::HashValueTest();
+  open_spiel::battle_chess::BoardFENTest();
+  open_spiel::battle_chess::BoardSizeTests();
+  open_spiel::battle_chess::DrawRulesTest();
+  open_spiel::battle_chess::ObservationTensorTest("battle_chess");
+  open_spiel::battle_chess::ObservationTensorTest(
+      "battle_chess(rows=6,columns=8)");
+  open_spiel::battle_chess::BinarySerializationTest("battle_chess");
+  open_spiel::battle_chess::BinarySerializationTest(
+      "battle_chess(rows=8,columns=8)");
+  open_spiel::battle_chess::UniformRandomLegalActionTest("battle_chess");
+  open_spiel::battle_chess::UniformRandomLegalActionTest(
+      "battle_chess(rows=8,columns=8)");
 }
@@ -55,7 +55,9 @@ const GameType kGameType{/*short_name=*/"breakthrough",
                          /*provides_observation_tensor=*/true,
                          /*parameter_specification=*/
                          {{"rows", GameParameter(kDefaultRows)},
-                          {"columns", GameParameter(kDefaultColumns)}}};
+                          {"columns", GameParameter(kDefaultColumns)}},
+                         /*default_loadable=*/true,
+                         /*provides_undo=*/true};
 
 std::shared_ptr<const Game> Factory(const GameParameters& params) {
   return std::shared_ptr<const Game>(new BreakthroughGame(params));
@@ -360,15 +362,11 @@ void BreakthroughState::UndoAction(Player player, Action action) {
   SetBoard(r1, c1, board(r2, c2));
   SetBoard(r2, c2, CellState::kEmpty);
   if (capture) {
-    if (board(r1, c1) == CellState::kWhite) {
-      SetBoard(r2, c2, CellState::kBlack);
-      // If the piece being captured is white, decrement the white piece count.
-      pieces_[1]++;
-    } else if (board(r1, c1) == CellState::kBlack) {
-      SetBoard(r2, c2, CellState::kWhite);
-      // Otherwise, decrement the black piece count.
-      pieces_[0]++;
-    }
+    // The captured piece belongs to the opponent of the piece moved back, and
+    // goes back into its owner's piece count.
+    const CellState captured = OpponentState(board(r1, c1));
+    SetBoard(r2, c2, captured);
+    pieces_[StateToPlayer(captured)]++;
   }
   history_.pop_back();
 }
@@ -351,6 +351,7 @@ void ChessState::UndoAction(Player player, Action action) {
   for (const Move& move : moves_history_) {
     current_board_.ApplyMove(move);
   }
+  cached_legal_actions_.reset();
 }
 
 bool ChessState::IsRepetitionDraw() const {
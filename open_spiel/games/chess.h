@@ -168,6 +168,7 @@ class ChessState : public State {
                          std::vector<double>* values) const override;
   std::unique_ptr<State> Clone() const override;
   void UndoAction(Player player, Action action) override;
+  uint64_t HashValue() const override { return Board().HashValue(); }
 
   // Current board.
   StandardChessBoard& Board() { return current_board_; }
@@ -41,7 +41,9 @@ const GameType kGameType{
     /*provides_information_state_tensor=*/false,
     /*provides_observation_string=*/true,
     /*provides_observation_tensor=*/true,
-    /*parameter_specification=*/{}  // no parameters
+    /*parameter_specification=*/{},  // no parameters
+    /*default_loadable=*/true,
+    /*provides_undo=*/true
 };
 
 std::shared_ptr<const Game> Factory(const GameParameters& params) {
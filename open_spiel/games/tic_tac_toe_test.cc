@@ -25,6 +25,7 @@ void BasicTicTacToeTests() {
   testing::LoadGameTest("tic_tac_toe");
   testing::NoChanceOutcomesTest(*LoadGame("tic_tac_toe"));
   testing::RandomSimTest(*LoadGame("tic_tac_toe"), 100);
+  testing::RandomSimTestWithUndo(*LoadGame("tic_tac_toe"), 10);
 }
 
 }  // namespace
@@ -52,11 +52,12 @@
         end
         evaluator = random_rollout_evaluator_factory(20, 42)
         bot = MCTSBot(game, evaluator, UCT_C, 10000, 10, true, 42, false, UCT, 0., 0.)
-        mcts_search(bot, state), state
+        # The tree lives in the bot, so it is returned as well.
+        mcts_search(bot, state), state, bot
     end
 
     @testset "solve draw" begin
-        root, state = search_tic_tac_toe_state("x(1,1) o(0,0) x(2,2)")
+        root, state, bot = search_tic_tac_toe_state("x(1,1) o(0,0) x(2,2)")
         @test to_string(state) == "o..\n.x.\n..x"
         @test get_outcome(root)[get_player(root)+1] == 0
         for c in get_children(root)
@@ -67,7 +68,7 @@
     end
 
     @testset "solve loss" begin
-        root, state = search_tic_tac_toe_state("x(1,1) o(0,0) x(2,2) o(0,1) x(0,2)")
+        root, state, bot = search_tic_tac_toe_state("x(1,1) o(0,0) x(2,2) o(0,1) x(0,2)")
         @test to_string(state) == "oox\n.x.\n..x"
         @test get_outcome(root)[get_player(root)+1] == -1
         for c in get_children(root)
@@ -76,7 +77,7 @@
     end
 
     @testset "solve win" begin
-        root, state = search_tic_tac_toe_state("x(0,1) o(2,2)")
+        root, state, bot = search_tic_tac_toe_state("x(0,1) o(2,2)")
         @test to_string(state) == ".x.\n...\n..o"
         @test get_outcome(root)[get_player(root)+1] == 1
         best = best_child(root)[]
@@ -240,6 +240,8 @@ JLCXX_MODULE define_julia_module(jlcxx::Module& mod) {
               [](const open_spiel::GameType& gt) {
                 return gt.default_loadable;
               })
+      .method("provides_undo",
+              [](const open_spiel::GameType& gt) { return gt.provides_undo; })
       .method("provides_information_state_string",
               [](const open_spiel::GameType& gt) {
                 return gt.provides_information_state_string;
@@ -567,7 +569,10 @@ JLCXX_MODULE define_julia_module(jlcxx::Module& mod) {
                 return sn.total_reward;
               })
       .method("get_outcome",
-              [](open_spiel::algorithms::SearchNode& sn) { return sn.outcome; })
+              [](open_spiel::algorithms::SearchNode& sn) {
+                return std::vector<double>(sn.outcome().begin(),
+                                           sn.outcome().end());
+              })
       .method("set_action!",
               [](open_spiel::algorithms::SearchNode& sn,
                  open_spiel::Action action) { sn.action = action; })
@@ -583,21 +588,16 @@ JLCXX_MODULE define_julia_module(jlcxx::Module& mod) {
       .method("set_total_reward!",
               [](open_spiel::algorithms::SearchNode& sn, double total_reward) {
                 sn.total_reward = total_reward;
-              })
-      .method("set_outcome!",
-              [](open_spiel::algorithms::SearchNode& sn,
-                 std::vector<double> outcome) { sn.outcome = outcome; });
+              });
 
   jlcxx::stl::apply_stl<open_spiel::algorithms::SearchNode>(mod);
 
+  // The outcome and children of a node live in the arena of the MCTSBot that
+  // searched it, so they can be read but not replaced.
   mod.method("get_children", [](open_spiel::algorithms::SearchNode& sn) {
-    return sn.children;
+    return std::vector<open_spiel::algorithms::SearchNode>(
+        sn.children().begin(), sn.children().end());
   });
-  mod.method("set_children!",
-             [](open_spiel::algorithms::SearchNode& sn,
-                std::vector<open_spiel::algorithms::SearchNode> children) {
-               sn.children = children;
-             });
 
   mod.add_type<open_spiel::algorithms::MCTSBot>(
          "MCTSBot", jlcxx::julia_base_type<open_spiel::Bot>())
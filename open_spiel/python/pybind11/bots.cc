@@ -26,6 +26,7 @@
 #include "open_spiel/algorithms/mcts.h"
 #include "open_spiel/spiel.h"
 #include "open_spiel/spiel_bots.h"
+#include "open_spiel/utils/json.h"
 #include "pybind11/include/pybind11/cast.h"
 #include "pybind11/include/pybind11/detail/descr.h"
 #include "pybind11/include/pybind11/functional.h"
@@ -163,23 +164,111 @@ void init_pyspiel_bots(py::module& m) {
              algorithms::Evaluator,
              std::shared_ptr<algorithms::RandomRolloutEvaluator>>(
                  m, "RandomRolloutEvaluator")
-      .def(py::init<int, int>(), py::arg("n_rollouts"), py::arg("seed"));
+      .def(py::init<int, int, int>(), py::arg("n_rollouts"), py::arg("seed"),
+           py::arg("num_threads") = 1);
 
   py::enum_<algorithms::ChildSelectionPolicy>(m, "ChildSelectionPolicy")
       .value("UCT", algorithms::ChildSelectionPolicy::UCT)
       .value("PUCT", algorithms::ChildSelectionPolicy::PUCT);
 
+  py::enum_<algorithms::SearchStopReason>(m, "SearchStopReason")
+      .value("NONE", algorithms::SearchStopReason::kNone)
+      .value("SIMULATIONS", algorithms::SearchStopReason::kSimulations)
+      .value("TIME", algorithms::SearchStopReason::kTime)
+      .value("SOLVED", algorithms::SearchStopReason::kSolved)
+      .value("SINGLE_ACTION", algorithms::SearchStopReason::kSingleAction)
+      .value("DECIDED", algorithms::SearchStopReason::kDecided);
+
+  py::class_<algorithms::MCTSSearchStats>(m, "MCTSSearchStats")
+      .def_readonly("simulations", &algorithms::MCTSSearchStats::simulations)
+      .def_readonly("stop_reason", &algorithms::MCTSSearchStats::stop_reason)
+      .def_readonly("wall_seconds",
+                    &algorithms::MCTSSearchStats::wall_seconds)
+      .def_readonly("selection_seconds",
+                    &algorithms::MCTSSearchStats::selection_seconds)
+      .def_readonly("expansion_seconds",
+                    &algorithms::MCTSSearchStats::expansion_seconds)
+      .def_readonly("evaluation_seconds",
+                    &algorithms::MCTSSearchStats::evaluation_seconds)
+      .def_readonly("backpropagation_seconds",
+                    &algorithms::MCTSSearchStats::backpropagation_seconds)
+      .def_readonly("gc_seconds", &algorithms::MCTSSearchStats::gc_seconds)
+      .def_readonly("evaluator_calls",
+                    &algorithms::MCTSSearchStats::evaluator_calls)
+      .def_readonly("evaluator_batches",
+                    &algorithms::MCTSSearchStats::evaluator_batches)
+      .def_readonly("tree_nodes", &algorithms::MCTSSearchStats::tree_nodes)
+      .def_readonly("tree_bytes", &algorithms::MCTSSearchStats::tree_bytes)
+      .def_readonly("reused_nodes",
+                    &algorithms::MCTSSearchStats::reused_nodes)
+      .def_readonly("new_nodes", &algorithms::MCTSSearchStats::new_nodes)
+      .def_readonly("expansions", &algorithms::MCTSSearchStats::expansions)
+      .def_readonly("expanded_children",
+                    &algorithms::MCTSSearchStats::expanded_children)
+      .def_readonly("gc_passes", &algorithms::MCTSSearchStats::gc_passes)
+      .def_readonly("gc_nodes_freed",
+                    &algorithms::MCTSSearchStats::gc_nodes_freed)
+      .def_readonly("transposition_lookups",
+                    &algorithms::MCTSSearchStats::transposition_lookups)
+      .def_readonly("transposition_hits",
+                    &algorithms::MCTSSearchStats::transposition_hits)
+      .def_readonly("depth_histogram",
+                    &algorithms::MCTSSearchStats::depth_histogram)
+      .def("branching_factor", &algorithms::MCTSSearchStats::BranchingFactor)
+      .def("mean_depth", &algorithms::MCTSSearchStats::MeanDepth)
+      .def("max_depth", &algorithms::MCTSSearchStats::MaxDepth)
+      // A JSON string, e.g. for json.loads().
+      .def("to_json", [](const algorithms::MCTSSearchStats& stats) {
+        return json::ToString(stats.ToJson());
+      });
+
   py::class_<algorithms::MCTSBot, Bot>(m, "MCTSBot")
       .def(py::init<const Game&, std::shared_ptr<Evaluator>, double, int,
                     int64_t, bool, int, bool,
-                    ::open_spiel::algorithms::ChildSelectionPolicy>(),
+                    ::open_spiel::algorithms::ChildSelectionPolicy, double,
+                    double, int, int, int, bool, int64_t, bool>(),
            py::arg("game"), py::arg("evaluator"), py::arg("uct_c"),
            py::arg("max_simulations"), py::arg("max_memory_mb"),
            py::arg("solve"), py::arg("seed"), py::arg("verbose"),
            py::arg("child_selection_policy") =
-               algorithms::ChildSelectionPolicy::UCT)
+               algorithms::ChildSelectionPolicy::UCT,
+           py::arg("dirichlet_alpha") = 0, py::arg("dirichlet_epsilon") = 0,
+           py::arg("num_threads") = 1, py::arg("batch_size") = 1,
+           py::arg("transposition_table_size") = 0,
+           py::arg("use_undo") = true, py::arg("max_time_ms") = 0,
+           py::arg("stop_early") = false)
       .def("step", &algorithms::MCTSBot::Step)
-      .def("mcts_search", &algorithms::MCTSBot::MCTSearch);
+      .def("mcts_search", &algorithms::MCTSBot::MCTSearch,
+           py::return_value_policy::reference_internal)
+      .def("reused_nodes", &algorithms::MCTSBot::reused_nodes)
+      .def("new_nodes", &algorithms::MCTSBot::new_nodes)
+      .def("transposition_lookups",
+           &algorithms::MCTSBot::transposition_lookups)
+      .def("transposition_hits", &algorithms::MCTSBot::transposition_hits)
+      .def("evaluator_calls", &algorithms::MCTSBot::evaluator_calls)
+      .def("simulations", &algorithms::MCTSBot::simulations)
+      .def("stop_reason", &algorithms::MCTSBot::stop_reason)
+      .def("search_stats", &algorithms::MCTSBot::search_stats,
+           py::return_value_policy::copy);
+
+  py::class_<algorithms::RootParallelMCTSBot, Bot>(m, "RootParallelMCTSBot")
+      .def(py::init<const Game&, std::shared_ptr<Evaluator>, double, int,
+                    int64_t, bool, int, bool, int,
+                    ::open_spiel::algorithms::ChildSelectionPolicy, double,
+                    double, int64_t>(),
+           py::arg("game"), py::arg("evaluator"), py::arg("uct_c"),
+           py::arg("max_simulations"), py::arg("max_memory_mb"),
+           py::arg("solve"), py::arg("seed"), py::arg("verbose"),
+           py::arg("num_searches"),
+           py::arg("child_selection_policy") =
+               algorithms::ChildSelectionPolicy::UCT,
+           py::arg("dirichlet_alpha") = 0, py::arg("dirichlet_epsilon") = 0,
+           py::arg("max_time_ms") = 0)
+      .def("step", &algorithms::RootParallelMCTSBot::Step)
+      .def("num_searches", &algorithms::RootParallelMCTSBot::num_searches)
+      .def("simulations", &algorithms::RootParallelMCTSBot::simulations)
+      .def("search_stats", &algorithms::RootParallelMCTSBot::search_stats,
+           py::return_value_policy::copy);
 
   py::enum_<algorithms::ISMCTSFinalPolicyType>(m, "ISMCTSFinalPolicyType")
       .value("NORMALIZED_VISIT_COUNT",
@@ -190,20 +279,24 @@ void init_pyspiel_bots(py::module& m) {
 
   py::class_<algorithms::ISMCTSBot, Bot>(m, "ISMCTSBot")
       .def(py::init<int, std::shared_ptr<Evaluator>, double, int, int,
-                    algorithms::ISMCTSFinalPolicyType, bool, bool>(),
+                    algorithms::ISMCTSFinalPolicyType, bool, bool, int64_t,
+                    bool>(),
            py::arg("seed"), py::arg("evaluator"), py::arg("uct_c"),
            py::arg("max_simulations"),
            py::arg("max_world_samples") = algorithms::kUnlimitedNumWorldSamples,
            py::arg("final_policy_type") =
                algorithms::ISMCTSFinalPolicyType::kNormalizedVisitCount,
            py::arg("use_observation_string") = false,
-           py::arg("allow_inconsistent_action_sets") = false)
+           py::arg("allow_inconsistent_action_sets") = false,
+           py::arg("max_time_ms") = 0, py::arg("stop_early") = false)
       .def("step", &algorithms::ISMCTSBot::Step)
       .def("provides_policy", &algorithms::MCTSBot::ProvidesPolicy)
       .def("get_policy", &algorithms::ISMCTSBot::GetPolicy)
       .def("step_with_policy", &algorithms::ISMCTSBot::StepWithPolicy)
       .def("restart", &algorithms::ISMCTSBot::Restart)
-      .def("restart_at", &algorithms::ISMCTSBot::RestartAt);
+      .def("restart_at", &algorithms::ISMCTSBot::RestartAt)
+      .def("simulations", &algorithms::ISMCTSBot::simulations)
+      .def("stop_reason", &algorithms::ISMCTSBot::stop_reason);
 
   m.def("evaluate_bots", open_spiel::EvaluateBots, py::arg("state"),
         py::arg("bots"), py::arg("seed"),
@@ -92,14 +92,16 @@ void init_pyspiel_policy(py::module& m) {
       .def("get_state_policy", &open_spiel::UniformPolicy::GetStatePolicy);
 
   py::class_<open_spiel::algorithms::CFRSolver>(m, "CFRSolver")
-      .def(py::init<const Game&>())
+      .def(py::init<const Game&, bool, int>(), py::arg("game"),
+           py::arg("compiled_tree") = false, py::arg("num_threads") = 1)
       .def("evaluate_and_update_policy",
            &open_spiel::algorithms::CFRSolver::EvaluateAndUpdatePolicy)
       .def("current_policy", &open_spiel::algorithms::CFRSolver::CurrentPolicy)
       .def("average_policy", &open_spiel::algorithms::CFRSolver::AveragePolicy);
 
   py::class_<open_spiel::algorithms::CFRPlusSolver>(m, "CFRPlusSolver")
-      .def(py::init<const Game&>())
+      .def(py::init<const Game&, bool, int>(), py::arg("game"),
+           py::arg("compiled_tree") = false, py::arg("num_threads") = 1)
       .def("evaluate_and_update_policy",
            &open_spiel::algorithms::CFRPlusSolver::EvaluateAndUpdatePolicy)
       .def("current_policy", &open_spiel::algorithms::CFRSolver::CurrentPolicy)
@@ -107,7 +109,8 @@ void init_pyspiel_policy(py::module& m) {
            &open_spiel::algorithms::CFRPlusSolver::AveragePolicy);
 
   py::class_<open_spiel::algorithms::CFRBRSolver>(m, "CFRBRSolver")
-      .def(py::init<const Game&>())
+      .def(py::init<const Game&, bool>(), py::arg("game"),
+           py::arg("compiled_tree") = false)
       .def("evaluate_and_update_policy",
            &open_spiel::algorithms::CFRPlusSolver::EvaluateAndUpdatePolicy)
       .def("current_policy", &open_spiel::algorithms::CFRSolver::CurrentPolicy)
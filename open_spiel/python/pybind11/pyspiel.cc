@@ -134,6 +134,7 @@ PYBIND11_MODULE(pyspiel, m) {
       .def_readonly("parameter_specification",
                     &GameType::parameter_specification)
       .def_readonly("default_loadable", &GameType::default_loadable)
+      .def_readonly("provides_undo", &GameType::provides_undo)
       .def("__repr__", [](const GameType& gt) {
         return "<GameType '" + gt.short_name + "'>";
       });
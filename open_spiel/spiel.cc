@@ -24,6 +24,7 @@
 #include <utility>
 #include <vector>
 
+#include "open_spiel/abseil-cpp/absl/hash/hash.h"
 #include "open_spiel/abseil-cpp/absl/strings/str_cat.h"
 #include "open_spiel/abseil-cpp/absl/strings/str_join.h"
 #include "open_spiel/abseil-cpp/absl/strings/str_split.h"
@@ -382,6 +383,11 @@ std::string State::Serialize() const {
   return absl::StrCat(absl::StrJoin(History(), "\n"), "\n");
 }
 
+uint64_t State::HashValue() const {
+  return absl::Hash<std::pair<std::string, Player>>{}(
+      {ToString(), CurrentPlayer()});
+}
+
 Action State::StringToAction(Player player,
                              const std::string& action_str) const {
   for (const Action action : LegalActions()) {
@@ -15,6 +15,7 @@
 #ifndef OPEN_SPIEL_SPIEL_H_
 #define OPEN_SPIEL_SPIEL_H_
 
+#include <cstdint>
 #include <functional>
 #include <iostream>
 #include <map>
@@ -140,6 +141,11 @@ struct GameType {
   // Can the game be loaded with no parameters? It is strongly recommended that
   // games be loadable with default arguments.
   bool default_loadable = true;
+
+  // Does State::UndoAction() restore the previous state exactly, and cost no
+  // more than a Clone()? Search algorithms then walk the game on one state and
+  // undo their moves, instead of copying the state for every simulation.
+  bool provides_undo = false;
 };
 
 enum class StateType {
@@ -241,6 +247,17 @@ class State {
   // is added.
   virtual std::vector<Action> LegalActions() const = 0;
 
+  // Returns LegalActions()[floor(z * n)], where n is the number of legal
+  // actions, so that a uniform random z in [0, 1) picks a uniformly random
+  // legal action. Random rollouts call this on every move, so games that can
+  // find the action without building the whole list should override it. Only
+  // valid for non-terminal states that are not chance nodes.
+  virtual Action UniformRandomLegalAction(double z) const {
+    std::vector<Action> actions = LegalActions();
+    SPIEL_CHECK_FALSE(actions.empty());
+    return actions[std::min<int>(z * actions.size(), actions.size() - 1)];
+  }
+
   // Returns a vector of length `game.NumDistinctActions()` containing 1 for
   // legal actions and 0 for illegal actions.
   std::vector<int> LegalActionsMask(Player player) const {
@@ -359,6 +376,9 @@ class State {
   // The full (player, action) history.
   std::vector<PlayerAction> FullHistory() const { return history_; }
 
+  // The number of actions applied so far, including chance outcomes.
+  int MoveNumber() const { return history_.size(); }
+
   // A string representation for the history. There should be a one to one
   // mapping between histories (i.e. sequences of actions for all players,
   // including chance) and the `State` objects.
@@ -560,6 +580,15 @@ class State {
   // If overridden, this must be the inverse of Game::DeserializeState.
   virtual std::string Serialize() const;
 
+  // Returns a 64-bit hash of the state, for use as a key in transposition
+  // tables and caches. Equal states must have equal hashes; different states
+  // should collide only rarely.
+  //
+  // The default implementation hashes ToString() together with the current
+  // player, so it costs a string build per call. Games that maintain an
+  // incremental hash (e.g. a Zobrist key) should override this.
+  virtual uint64_t HashValue() const;
+
   // Resamples a new history from the information state from player_id's view.
   // This resamples a private for the other players, but holds player_id's
   // privates constant, and the public information constant.
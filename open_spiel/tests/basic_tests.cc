@@ -171,6 +171,9 @@ void TestUndo(std::unique_ptr<State> state,
     SPIEL_CHECK_EQ(state->ToString(), prev->state->ToString());
     // We also check that UndoActions correctly updates history_.
     SPIEL_CHECK_EQ(state->History(), prev->state->History());
+    // Cached or derived values must be restored as well.
+    SPIEL_CHECK_EQ(state->CurrentPlayer(), prev->state->CurrentPlayer());
+    SPIEL_CHECK_EQ(state->LegalActions(), prev->state->LegalActions());
   }
 }
 
@@ -360,7 +363,12 @@ void RandomSimulation(std::mt19937* rng, const Game& game, bool undo,
       else
         SPIEL_CHECK_FALSE(actions.empty());
       std::uniform_int_distribution<int> dis(0, actions.size() - 1);
-      Action action = actions[dis(*rng)];
+      const int index = dis(*rng);
+      Action action = actions[index];
+      // Games may sample random actions without listing them.
+      SPIEL_CHECK_EQ(
+          state->UniformRandomLegalAction((index + 0.5) / actions.size()),
+          action);
 
       std::cout << "chose action: " << action << " ("
                 << state->ActionToString(player, action) << ")" << std::endl;
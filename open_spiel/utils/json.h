@@ -18,6 +18,7 @@
 #include <cstdint>
 
 #include <map>
+#include <optional>
 #include <ostream>
 #include <string>
 #include <variant>
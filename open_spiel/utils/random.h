@@ -0,0 +1,84 @@
+// Copyright 2019 DeepMind Technologies Ltd. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OPEN_SPIEL_UTILS_RANDOM_H_
+#define OPEN_SPIEL_UTILS_RANDOM_H_
+
+#include <cstdint>
+#include <limits>
+
+namespace open_spiel {
+
+// The SplitMix64 generator, mostly used to turn one seed into several
+// well-mixed ones.
+class SplitMix64 {
+ public:
+  explicit SplitMix64(uint64_t seed) : state_(seed) {}
+
+  uint64_t operator()() {
+    uint64_t z = (state_ += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+  }
+
+ private:
+  uint64_t state_;
+};
+
+// The xoshiro256** generator by Blackman and Vigna,
+// https://prng.di.unimi.it/. It is several times faster than std::mt19937 and
+// its state is 32 bytes, so hot loops such as random rollouts can keep one per
+// thread or per task. It is a UniformRandomBitGenerator, usable with <random>
+// and absl/random distributions. It is not cryptographically secure.
+class Xoshiro256 {
+ public:
+  using result_type = uint64_t;
+
+  // The state is seeded from SplitMix64, so nearby seeds give unrelated
+  // sequences.
+  explicit Xoshiro256(uint64_t seed) {
+    SplitMix64 seeder(seed);
+    for (uint64_t& s : s_) s = seeder();
+  }
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() {
+    return std::numeric_limits<result_type>::max();
+  }
+
+  result_type operator()() {
+    const uint64_t result = Rotl(s_[1] * 5, 7) * 9;
+    const uint64_t t = s_[1] << 17;
+    s_[2] ^= s_[0];
+    s_[3] ^= s_[1];
+    s_[1] ^= s_[2];
+    s_[0] ^= s_[3];
+    s_[2] ^= t;
+    s_[3] = Rotl(s_[3], 45);
+    return result;
+  }
+
+  // A uniform double in [0, 1), from the top 53 bits.
+  double UniformDouble() { return ((*this)() >> 11) * 0x1.0p-53; }
+
+ private:
+  static uint64_t Rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+  uint64_t s_[4];
+};
+
+}  // namespace open_spiel
+
+#endif  // OPEN_SPIEL_UTILS_RANDOM_H_
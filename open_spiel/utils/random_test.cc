@@ -0,0 +1,88 @@
+// Copyright 2019 DeepMind Technologies Ltd. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "open_spiel/utils/random.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "open_spiel/abseil-cpp/absl/random/distributions.h"
+#include "open_spiel/spiel_utils.h"
+
+namespace open_spiel {
+namespace {
+
+void TestSplitMix64() {
+  // The reference sequence for seed 1234567.
+  SplitMix64 rng(1234567);
+  SPIEL_CHECK_EQ(rng(), 6457827717110365317ULL);
+  SPIEL_CHECK_EQ(rng(), 3203168211198807973ULL);
+  SPIEL_CHECK_EQ(rng(), 9817491932198370423ULL);
+}
+
+void TestXoshiro256Seeding() {
+  Xoshiro256 a(42);
+  Xoshiro256 b(42);
+  Xoshiro256 c(43);
+  int same_as_c = 0;
+  for (int i = 0; i < 100; ++i) {
+    const uint64_t value = a();
+    SPIEL_CHECK_EQ(value, b());
+    if (value == c()) ++same_as_c;
+  }
+  SPIEL_CHECK_EQ(same_as_c, 0);
+}
+
+void TestXoshiro256Uniform() {
+  Xoshiro256 rng(7);
+  constexpr int kSamples = 100000;
+  double sum = 0;
+  std::vector<int> buckets(10, 0);
+  for (int i = 0; i < kSamples; ++i) {
+    const double z = rng.UniformDouble();
+    SPIEL_CHECK_GE(z, 0);
+    SPIEL_CHECK_LT(z, 1);
+    sum += z;
+    buckets[static_cast<int>(z * buckets.size())]++;
+  }
+  SPIEL_CHECK_FLOAT_NEAR(sum / kSamples, 0.5, 0.01);
+  for (int count : buckets) {
+    SPIEL_CHECK_FLOAT_NEAR(count, kSamples / buckets.size(), 600);
+  }
+}
+
+void TestXoshiro256WithDistributions() {
+  Xoshiro256 rng(3);
+  std::vector<int> values = {1, 2, 3, 4, 5};
+  std::shuffle(values.begin(), values.end(), rng);
+  std::sort(values.begin(), values.end());
+  SPIEL_CHECK_EQ(values, std::vector<int>({1, 2, 3, 4, 5}));
+  for (int i = 0; i < 1000; ++i) {
+    const int value = absl::Uniform(rng, 0, 6);
+    SPIEL_CHECK_GE(value, 0);
+    SPIEL_CHECK_LT(value, 6);
+  }
+}
+
+}  // namespace
+}  // namespace open_spiel
+
+int main(int argc, char** argv) {
+  open_spiel::TestSplitMix64();
+  open_spiel::TestXoshiro256Seeding();
+  open_spiel::TestXoshiro256Uniform();
+  open_spiel::TestXoshiro256WithDistributions();
+}
@@ -14,6 +14,7 @@
 
 #include "open_spiel/utils/thread.h"
 
+#include <algorithm>
 #include <thread>  // NOLINT
 
 namespace open_spiel {
@@ -32,4 +33,67 @@ Thread& Thread::operator=(Thread&& other) = default;
 
 void Thread::join() { thread_->join(); }
 
+ThreadPool::ThreadPool(int num_threads) {
+  threads_.reserve(num_threads);
+  for (int i = 0; i < num_threads; ++i) {
+    threads_.emplace_back([this]() { Work(); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    absl::MutexLock lock(&mutex_);
+    stop_ = true;
+  }
+  for (Thread& thread : threads_) thread.join();
+}
+
+int ThreadPool::RunTasks(Job* job) {
+  int count = 0;
+  for (int i = job->next++; i < job->n; i = job->next++) {
+    (*job->fn)(i);
+    ++count;
+  }
+  return count;
+}
+
+void ThreadPool::ParallelFor(int n, const std::function<void(int)>& fn) {
+  Job job;
+  job.fn = &fn;
+  job.n = n;
+  if (!threads_.empty() && n > 1) {
+    absl::MutexLock lock(&mutex_);
+    jobs_.push_back(&job);
+  }
+  const int count = RunTasks(&job);
+
+  absl::MutexLock lock(&mutex_);
+  // No thread may pick up the job once it goes out of scope.
+  auto it = std::find(jobs_.begin(), jobs_.end(), &job);
+  if (it != jobs_.end()) jobs_.erase(it);
+  job.finished += count;
+  mutex_.Await(absl::Condition(
+      +[](Job* job) { return job->finished == job->n && job->workers == 0; },
+      &job));
+}
+
+void ThreadPool::Work() {
+  absl::MutexLock lock(&mutex_);
+  while (true) {
+    mutex_.Await(absl::Condition(
+        +[](ThreadPool* pool) { return pool->stop_ || !pool->jobs_.empty(); },
+        this));
+    if (stop_) return;
+    Job* job = jobs_.front();
+    job->workers++;
+    mutex_.Unlock();
+    const int count = RunTasks(job);
+    mutex_.Lock();
+    // Every task has been handed out, so the job needs no more threads.
+    if (!jobs_.empty() && jobs_.front() == job) jobs_.pop_front();
+    job->finished += count;
+    job->workers--;
+  }
+}
+
 }  // namespace open_spiel
@@ -16,8 +16,12 @@
 #define OPEN_SPIEL_UTILS_THREAD_H_
 
 #include <atomic>
+#include <deque>
 #include <functional>
 #include <memory>
+#include <vector>
+
+#include "open_spiel/abseil-cpp/absl/synchronization/mutex.h"
 
 namespace open_spiel {
 
@@ -52,6 +56,43 @@ class StopToken {
   std::atomic<bool> token_;
 };
 
+// A fixed set of threads running the tasks of ParallelFor() calls, which may
+// come from several threads at once.
+class ThreadPool {
+ public:
+  explicit ThreadPool(int num_threads);
+  // Waits for the threads to finish their current tasks.
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  int num_threads() const { return threads_.size(); }
+
+  // Calls fn(i) for each i in [0, n) and returns once all calls have
+  // returned. The calling thread runs tasks too, so a call makes progress even
+  // while the pool's threads are busy with other calls.
+  void ParallelFor(int n, const std::function<void(int)>& fn);
+
+ private:
+  struct Job {
+    const std::function<void(int)>* fn;
+    int n;
+    std::atomic<int> next{0};  // The next task to hand out.
+    int finished = 0;  // Tasks done, guarded by mutex_.
+    int workers = 0;   // Pool threads running its tasks, guarded by mutex_.
+  };
+
+  // Runs tasks of the job until none are left, and returns how many it ran.
+  static int RunTasks(Job* job);
+  void Work();
+
+  absl::Mutex mutex_;
+  std::deque<Job*> jobs_;  // Jobs that still have tasks to hand out.
+  bool stop_ = false;
+  std::vector<Thread> threads_;
+};
+
 }  // namespace open_spiel
 
 #endif  // OPEN_SPIEL_UTILS_THREAD_H_
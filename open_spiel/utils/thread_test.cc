@@ -14,6 +14,8 @@
 
 #include "open_spiel/utils/thread.h"
 
+#include <vector>
+
 #include "open_spiel/spiel_utils.h"
 
 namespace open_spiel {
@@ -42,6 +44,36 @@ void TestThreadMoveAssign() {
   SPIEL_CHECK_EQ(value, 2);
 }
 
+void TestThreadPool() {
+  ThreadPool pool(3);
+  SPIEL_CHECK_EQ(pool.num_threads(), 3);
+  std::vector<int> values(100, 0);
+  pool.ParallelFor(values.size(), [&](int i) { values[i] = i * i; });
+  for (int i = 0; i < values.size(); ++i) SPIEL_CHECK_EQ(values[i], i * i);
+
+  // Calls from several threads share the pool.
+  std::vector<std::vector<int>> results(4, std::vector<int>(50, 0));
+  std::vector<Thread> callers;
+  for (int c = 0; c < results.size(); ++c) {
+    callers.emplace_back([&, c]() {
+      for (int round = 1; round <= 20; ++round) {
+        pool.ParallelFor(results[c].size(),
+                         [&, round](int i) { results[c][i] += round; });
+      }
+    });
+  }
+  for (Thread& caller : callers) caller.join();
+  for (const std::vector<int>& result : results) {
+    for (int value : result) SPIEL_CHECK_EQ(value, 210);
+  }
+
+  // A pool without threads runs everything on the caller.
+  ThreadPool empty(0);
+  int sum = 0;
+  empty.ParallelFor(10, [&](int i) { sum += i; });
+  SPIEL_CHECK_EQ(sum, 45);
+}
+
 }  // namespace
 }  // namespace open_spiel
 
@@ -49,4 +81,5 @@ int main(int argc, char** argv) {
   open_spiel::TestThread();
   open_spiel::TestThreadMove();
   open_spiel::TestThreadMoveAssign();
+  open_spiel::TestThreadPool();
 }